@@ -0,0 +1,565 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "cc-display-state.h"
+
+#define MONITOR_SPEC_FORMAT "(ssss)"
+#define LOGICAL_MONITOR_FORMAT "(iiduba" MONITOR_SPEC_FORMAT "a{sv})"
+
+/* MonitorsChanged tends to arrive in bursts (e.g. when docking), only
+ * fetch the state once things have settled for this long. */
+#define MONITORS_CHANGED_TIMEOUT_MS 100
+
+struct _CcDisplayStateSnapshot
+{
+  gint      ref_count;
+
+  guint32   serial;
+  GVariant *state;
+
+  GArray   *monitors;
+  GArray   *logical_monitors;
+
+  /* Connector -> index into monitors + 1 */
+  GHashTable *monitors_by_connector;
+};
+
+struct _CcDisplayState
+{
+  GObject parent_instance;
+
+  GCancellable *cancellable;
+  GCancellable *state_cancellable;
+  GDBusConnection *connection;
+  guint monitors_changed_id;
+  guint monitors_changed_timeout_id;
+  guint muffin_watch_id;
+
+  CcDisplayStateSnapshot *snapshot;
+};
+
+G_DEFINE_TYPE (CcDisplayState, cc_display_state, G_TYPE_OBJECT)
+
+enum
+{
+  CHANGED,
+  N_SIGNALS,
+};
+
+static guint signals[N_SIGNALS] = { 0 };
+
+static void
+clear_monitor (CcDisplayStateMonitor *monitor)
+{
+  g_free ((gchar *) monitor->connector);
+  g_free ((gchar *) monitor->vendor);
+  g_free ((gchar *) monitor->product);
+  g_free ((gchar *) monitor->serial);
+  g_free ((gchar *) monitor->display_name);
+}
+
+/**
+ * cc_display_state_snapshot_new:
+ * @state: a GetCurrentState reply in CC_DISPLAY_STATE_FORMAT
+ *
+ * Parses @state. Normally snapshots come from cc_display_state_get_snapshot(),
+ * this is for code that has a state from elsewhere.
+ *
+ * Returns: (transfer full): a new snapshot.
+ */
+CcDisplayStateSnapshot *
+cc_display_state_snapshot_new (GVariant *state)
+{
+  CcDisplayStateSnapshot *snapshot;
+  g_autoptr(GVariant) monitors = NULL;
+  g_autoptr(GVariant) logical_monitors = NULL;
+  GVariantIter iter;
+  GVariant *child;
+
+  snapshot = g_new0 (CcDisplayStateSnapshot, 1);
+  snapshot->ref_count = 1;
+  snapshot->state = g_variant_ref_sink (state);
+
+  snapshot->monitors = g_array_new (FALSE, TRUE, sizeof (CcDisplayStateMonitor));
+  g_array_set_clear_func (snapshot->monitors, (GDestroyNotify) clear_monitor);
+  snapshot->logical_monitors = g_array_new (FALSE, TRUE, sizeof (CcDisplayStateLogicalMonitor));
+  snapshot->monitors_by_connector = g_hash_table_new (g_str_hash, g_str_equal);
+
+  g_variant_get (state, "(u@*@*@*)",
+                 &snapshot->serial, &monitors, &logical_monitors, NULL);
+
+  g_variant_iter_init (&iter, monitors);
+  while ((child = g_variant_iter_next_value (&iter)))
+    {
+      CcDisplayStateMonitor monitor = { 0, };
+      g_autoptr(GVariant) props = NULL;
+
+      g_variant_get (child, "((ssss)@*@a{sv})",
+                     &monitor.connector,
+                     &monitor.vendor,
+                     &monitor.product,
+                     &monitor.serial,
+                     NULL,
+                     &props);
+
+      if (!g_variant_lookup (props, "display-name", "s", &monitor.display_name))
+        monitor.display_name = NULL;
+      if (!g_variant_lookup (props, "is-builtin", "b", &monitor.builtin))
+        monitor.builtin = FALSE;
+      monitor.logical_monitor = -1;
+
+      g_array_append_val (snapshot->monitors, monitor);
+      g_hash_table_insert (snapshot->monitors_by_connector,
+                           (gpointer) monitor.connector,
+                           GUINT_TO_POINTER (snapshot->monitors->len));
+      g_variant_unref (child);
+    }
+
+  g_variant_iter_init (&iter, logical_monitors);
+  while ((child = g_variant_iter_next_value (&iter)))
+    {
+      CcDisplayStateLogicalMonitor logical_monitor = { 0, };
+      g_autoptr(GVariantIter) monitor_specs = NULL;
+      const gchar *connector, *vendor, *product, *serial;
+
+      g_variant_get (child, LOGICAL_MONITOR_FORMAT,
+                     &logical_monitor.x,
+                     &logical_monitor.y,
+                     &logical_monitor.scale,
+                     &logical_monitor.rotation,
+                     &logical_monitor.primary,
+                     &monitor_specs,
+                     NULL);
+
+      while (g_variant_iter_next (monitor_specs, "(&s&s&s&s)", &connector, &vendor, &product, &serial))
+        {
+          CcDisplayStateMonitor *m;
+          gint pos;
+
+          pos = cc_display_state_snapshot_lookup_monitor (snapshot, connector, vendor, product, serial);
+          if (pos < 0)
+            {
+              g_warning ("Couldn't find monitor given spec: %s, %s, %s, %s",
+                         connector, vendor, product, serial);
+              continue;
+            }
+
+          m = &g_array_index (snapshot->monitors, CcDisplayStateMonitor, pos);
+          if (m->logical_monitor < 0)
+            m->logical_monitor = snapshot->logical_monitors->len;
+        }
+
+      g_array_append_val (snapshot->logical_monitors, logical_monitor);
+      g_variant_unref (child);
+    }
+
+  return snapshot;
+}
+
+CcDisplayStateSnapshot *
+cc_display_state_snapshot_ref (CcDisplayStateSnapshot *snapshot)
+{
+  g_return_val_if_fail (snapshot != NULL, NULL);
+
+  g_atomic_int_inc (&snapshot->ref_count);
+
+  return snapshot;
+}
+
+void
+cc_display_state_snapshot_unref (CcDisplayStateSnapshot *snapshot)
+{
+  g_return_if_fail (snapshot != NULL);
+
+  if (!g_atomic_int_dec_and_test (&snapshot->ref_count))
+    return;
+
+  g_hash_table_unref (snapshot->monitors_by_connector);
+  g_array_unref (snapshot->monitors);
+  g_array_unref (snapshot->logical_monitors);
+  g_variant_unref (snapshot->state);
+  g_free (snapshot);
+}
+
+guint32
+cc_display_state_snapshot_get_serial (CcDisplayStateSnapshot *snapshot)
+{
+  return snapshot->serial;
+}
+
+/**
+ * cc_display_state_snapshot_get_variant:
+ *
+ * Returns: (transfer none): the GetCurrentState reply in
+ * CC_DISPLAY_STATE_FORMAT.
+ */
+GVariant *
+cc_display_state_snapshot_get_variant (CcDisplayStateSnapshot *snapshot)
+{
+  return snapshot->state;
+}
+
+guint
+cc_display_state_snapshot_get_n_monitors (CcDisplayStateSnapshot *snapshot)
+{
+  return snapshot->monitors->len;
+}
+
+const CcDisplayStateMonitor *
+cc_display_state_snapshot_get_monitor (CcDisplayStateSnapshot *snapshot,
+                                       guint                   index)
+{
+  g_return_val_if_fail (index < snapshot->monitors->len, NULL);
+
+  return &g_array_index (snapshot->monitors, CcDisplayStateMonitor, index);
+}
+
+/**
+ * cc_display_state_snapshot_lookup_monitor:
+ *
+ * Returns: the index of the monitor matching the given spec, or -1.
+ */
+gint
+cc_display_state_snapshot_lookup_monitor (CcDisplayStateSnapshot *snapshot,
+                                          const gchar            *connector,
+                                          const gchar            *vendor,
+                                          const gchar            *product,
+                                          const gchar            *serial)
+{
+  const CcDisplayStateMonitor *m;
+  guint pos;
+
+  /* Connectors are unique within a state, the rest of the spec still
+   * has to match for it to be the same monitor. */
+  pos = GPOINTER_TO_UINT (g_hash_table_lookup (snapshot->monitors_by_connector, connector));
+  if (pos == 0)
+    return -1;
+
+  m = &g_array_index (snapshot->monitors, CcDisplayStateMonitor, pos - 1);
+  if (!g_str_equal (m->vendor, vendor) ||
+      !g_str_equal (m->product, product) ||
+      !g_str_equal (m->serial, serial))
+    return -1;
+
+  return pos - 1;
+}
+
+guint
+cc_display_state_snapshot_get_n_logical_monitors (CcDisplayStateSnapshot *snapshot)
+{
+  return snapshot->logical_monitors->len;
+}
+
+const CcDisplayStateLogicalMonitor *
+cc_display_state_snapshot_get_logical_monitor (CcDisplayStateSnapshot *snapshot,
+                                               guint                   index)
+{
+  g_return_val_if_fail (index < snapshot->logical_monitors->len, NULL);
+
+  return &g_array_index (snapshot->logical_monitors, CcDisplayStateLogicalMonitor, index);
+}
+
+static void
+set_snapshot (CcDisplayState         *self,
+              CcDisplayStateSnapshot *snapshot)
+{
+  g_clear_pointer (&self->snapshot, cc_display_state_snapshot_unref);
+  self->snapshot = snapshot;
+
+  g_signal_emit (self, signals[CHANGED], 0);
+}
+
+static void
+got_current_state (GObject      *object,
+                   GAsyncResult *result,
+                   gpointer      data)
+{
+  CcDisplayState *self;
+  GVariant *variant;
+  g_autoptr(GError) error = NULL;
+
+  variant = g_dbus_connection_call_finish (G_DBUS_CONNECTION (object),
+                                           result, &error);
+  if (!variant)
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          self = CC_DISPLAY_STATE (data);
+          g_clear_object (&self->state_cancellable);
+          g_warning ("Error calling GetCurrentState: %s", error->message);
+          set_snapshot (self, NULL);
+        }
+      return;
+    }
+
+  self = CC_DISPLAY_STATE (data);
+  g_clear_object (&self->state_cancellable);
+
+  /* The serial is part of the state, so this only matches if nothing
+   * changed at all and there is nothing to parse or rebuild. */
+  if (self->snapshot && g_variant_equal (self->snapshot->state, variant))
+    {
+      g_debug ("Display state unchanged (serial %u), skipping update",
+               self->snapshot->serial);
+      g_variant_unref (variant);
+      return;
+    }
+
+  set_snapshot (self, cc_display_state_snapshot_new (variant));
+  g_variant_unref (variant);
+}
+
+static void
+cancel_current_state (CcDisplayState *self)
+{
+  if (self->monitors_changed_timeout_id)
+    {
+      g_source_remove (self->monitors_changed_timeout_id);
+      self->monitors_changed_timeout_id = 0;
+    }
+
+  if (self->state_cancellable)
+    {
+      g_cancellable_cancel (self->state_cancellable);
+      g_clear_object (&self->state_cancellable);
+    }
+}
+
+static void
+get_current_state (CcDisplayState *self)
+{
+  /* A newer request supersedes any reply that is still outstanding. */
+  cancel_current_state (self);
+  self->state_cancellable = g_cancellable_new ();
+
+  g_dbus_connection_call (self->connection,
+                          "org.cinnamon.Muffin.DisplayConfig",
+                          "/org/cinnamon/Muffin/DisplayConfig",
+                          "org.cinnamon.Muffin.DisplayConfig",
+                          "GetCurrentState",
+                          NULL,
+                          G_VARIANT_TYPE (CC_DISPLAY_STATE_FORMAT),
+                          G_DBUS_CALL_FLAGS_NO_AUTO_START,
+                          -1,
+                          self->state_cancellable,
+                          got_current_state,
+                          self);
+}
+
+static gboolean
+monitors_changed_timeout_cb (gpointer user_data)
+{
+  CcDisplayState *self = CC_DISPLAY_STATE (user_data);
+
+  self->monitors_changed_timeout_id = 0;
+  get_current_state (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+monitors_changed (GDBusConnection *connection,
+                  const gchar     *sender_name,
+                  const gchar     *object_path,
+                  const gchar     *interface_name,
+                  const gchar     *signal_name,
+                  GVariant        *parameters,
+                  gpointer         data)
+{
+  CcDisplayState *self = CC_DISPLAY_STATE (data);
+
+  /* Every signal of a burst pushes the fetch back */
+  if (self->monitors_changed_timeout_id)
+    g_source_remove (self->monitors_changed_timeout_id);
+
+  self->monitors_changed_timeout_id = g_timeout_add (MONITORS_CHANGED_TIMEOUT_MS,
+                                                     monitors_changed_timeout_cb,
+                                                     self);
+}
+
+static void
+muffin_vanished_cb (GDBusConnection *connection,
+                    const gchar     *name,
+                    gpointer         user_data)
+{
+  CcDisplayState *self = CC_DISPLAY_STATE (user_data);
+
+  g_debug ("Muffin vanished");
+
+  cancel_current_state (self);
+  set_snapshot (self, NULL);
+}
+
+static void
+muffin_appeared_cb (GDBusConnection *connection,
+                    const gchar     *name,
+                    const gchar     *name_owner,
+                    gpointer         user_data)
+{
+  CcDisplayState *self = CC_DISPLAY_STATE (user_data);
+
+  g_debug ("Muffin appeared");
+
+  get_current_state (self);
+}
+
+static void
+bus_gotten (GObject      *object,
+            GAsyncResult *result,
+            gpointer      data)
+{
+  CcDisplayState *self;
+  GDBusConnection *connection;
+  g_autoptr(GError) error = NULL;
+
+  connection = g_bus_get_finish (result, &error);
+  if (!connection)
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          g_warning ("Error obtaining DBus connection: %s", error->message);
+          g_signal_emit (data, signals[CHANGED], 0);
+        }
+      return;
+    }
+
+  self = CC_DISPLAY_STATE (data);
+  self->connection = connection;
+  self->monitors_changed_id =
+    g_dbus_connection_signal_subscribe (self->connection,
+                                        "org.cinnamon.Muffin.DisplayConfig",
+                                        "org.cinnamon.Muffin.DisplayConfig",
+                                        "MonitorsChanged",
+                                        "/org/cinnamon/Muffin/DisplayConfig",
+                                        NULL,
+                                        G_DBUS_SIGNAL_FLAGS_NONE,
+                                        monitors_changed,
+                                        self,
+                                        NULL);
+
+  /* This also fetches the initial state once Muffin is there. */
+  self->muffin_watch_id = g_bus_watch_name_on_connection (self->connection,
+                                                          "org.cinnamon.Muffin.DisplayConfig",
+                                                          G_BUS_NAME_WATCHER_FLAGS_NONE,
+                                                          muffin_appeared_cb,
+                                                          muffin_vanished_cb,
+                                                          self,
+                                                          NULL);
+}
+
+static void
+cc_display_state_init (CcDisplayState *self)
+{
+  self->cancellable = g_cancellable_new ();
+  g_bus_get (G_BUS_TYPE_SESSION, self->cancellable, bus_gotten, self);
+}
+
+static void
+cc_display_state_finalize (GObject *object)
+{
+  CcDisplayState *self = CC_DISPLAY_STATE (object);
+
+  cancel_current_state (self);
+  g_cancellable_cancel (self->cancellable);
+  g_clear_object (&self->cancellable);
+
+  if (self->monitors_changed_id && self->connection)
+    g_dbus_connection_signal_unsubscribe (self->connection,
+                                          self->monitors_changed_id);
+
+  if (self->muffin_watch_id)
+    g_bus_unwatch_name (self->muffin_watch_id);
+
+  g_clear_object (&self->connection);
+  g_clear_pointer (&self->snapshot, cc_display_state_snapshot_unref);
+
+  G_OBJECT_CLASS (cc_display_state_parent_class)->finalize (object);
+}
+
+static void
+cc_display_state_class_init (CcDisplayStateClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->finalize = cc_display_state_finalize;
+
+  signals[CHANGED] =
+    g_signal_new ("changed",
+                  CC_TYPE_DISPLAY_STATE,
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL,
+                  g_cclosure_marshal_VOID__VOID,
+                  G_TYPE_NONE, 0);
+}
+
+/**
+ * cc_display_state_get_default:
+ *
+ * Returns: (transfer none): the display state shared by all panels.
+ */
+CcDisplayState *
+cc_display_state_get_default (void)
+{
+  static CcDisplayState *singleton = NULL;
+
+  if (singleton == NULL)
+    singleton = g_object_new (CC_TYPE_DISPLAY_STATE, NULL);
+
+  return singleton;
+}
+
+/**
+ * cc_display_state_get_snapshot:
+ *
+ * Returns: (transfer full) (nullable): the last known state, or %NULL if
+ * Muffin could not be reached (yet).
+ */
+CcDisplayStateSnapshot *
+cc_display_state_get_snapshot (CcDisplayState *self)
+{
+  g_return_val_if_fail (CC_IS_DISPLAY_STATE (self), NULL);
+
+  if (self->snapshot == NULL)
+    return NULL;
+
+  return cc_display_state_snapshot_ref (self->snapshot);
+}
+
+/**
+ * cc_display_state_get_connection:
+ *
+ * Returns: (transfer none) (nullable): the session bus connection used to
+ * talk to Muffin.
+ */
+GDBusConnection *
+cc_display_state_get_connection (CcDisplayState *self)
+{
+  g_return_val_if_fail (CC_IS_DISPLAY_STATE (self), NULL);
+
+  return self->connection;
+}
+
+void
+cc_display_state_refresh (CcDisplayState *self)
+{
+  g_return_if_fail (CC_IS_DISPLAY_STATE (self));
+
+  if (self->connection == NULL)
+    return;
+
+  get_current_state (self);
+}
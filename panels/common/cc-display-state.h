@@ -0,0 +1,92 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/*
+ * CcDisplayState:
+ *
+ *   Process wide cache of the org.cinnamon.Muffin.DisplayConfig state. The
+ *   state is fetched asynchronously once per change and handed out as
+ *   immutable, reference counted snapshots, so every panel that needs to
+ *   know about the monitors shares a single GetCurrentState round-trip and
+ *   a single parse of the reply.
+ *
+ * CcDisplayStateSnapshot:
+ *
+ *   The raw GetCurrentState reply together with a flat, parsed view of its
+ *   monitors and logical monitors. Strings are owned by the snapshot and stay
+ *   valid for as long as the snapshot is referenced.
+ */
+
+#define CC_DISPLAY_STATE_FORMAT "(ua((ssss)a(siiddada{sv})a{sv})a(iiduba(ssss)a{sv})a{sv})"
+
+typedef struct
+{
+  const gchar *connector;
+  const gchar *vendor;
+  const gchar *product;
+  const gchar *serial;
+  const gchar *display_name;
+  gboolean     builtin;
+  /* Index of the first logical monitor showing this monitor, or -1 */
+  gint         logical_monitor;
+} CcDisplayStateMonitor;
+
+typedef struct
+{
+  gint     x;
+  gint     y;
+  gdouble  scale;
+  guint32  rotation;
+  gboolean primary;
+} CcDisplayStateLogicalMonitor;
+
+typedef struct _CcDisplayStateSnapshot CcDisplayStateSnapshot;
+
+CcDisplayStateSnapshot *             cc_display_state_snapshot_new                    (GVariant               *state);
+CcDisplayStateSnapshot *             cc_display_state_snapshot_ref                    (CcDisplayStateSnapshot *snapshot);
+void                                 cc_display_state_snapshot_unref                  (CcDisplayStateSnapshot *snapshot);
+guint32                              cc_display_state_snapshot_get_serial             (CcDisplayStateSnapshot *snapshot);
+GVariant *                           cc_display_state_snapshot_get_variant            (CcDisplayStateSnapshot *snapshot);
+guint                                cc_display_state_snapshot_get_n_monitors         (CcDisplayStateSnapshot *snapshot);
+const CcDisplayStateMonitor *        cc_display_state_snapshot_get_monitor            (CcDisplayStateSnapshot *snapshot,
+                                                                                       guint                   index);
+gint                                 cc_display_state_snapshot_lookup_monitor         (CcDisplayStateSnapshot *snapshot,
+                                                                                       const gchar            *connector,
+                                                                                       const gchar            *vendor,
+                                                                                       const gchar            *product,
+                                                                                       const gchar            *serial);
+guint                                cc_display_state_snapshot_get_n_logical_monitors (CcDisplayStateSnapshot *snapshot);
+const CcDisplayStateLogicalMonitor * cc_display_state_snapshot_get_logical_monitor    (CcDisplayStateSnapshot *snapshot,
+                                                                                       guint                   index);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (CcDisplayStateSnapshot, cc_display_state_snapshot_unref)
+
+#define CC_TYPE_DISPLAY_STATE (cc_display_state_get_type ())
+G_DECLARE_FINAL_TYPE (CcDisplayState, cc_display_state, CC, DISPLAY_STATE, GObject)
+
+CcDisplayState *         cc_display_state_get_default    (void);
+CcDisplayStateSnapshot * cc_display_state_get_snapshot   (CcDisplayState *self);
+GDBusConnection *        cc_display_state_get_connection (CcDisplayState *self);
+void                     cc_display_state_refresh        (CcDisplayState *self);
+
+G_END_DECLS
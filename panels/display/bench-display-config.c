@@ -0,0 +1,157 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * Times parsing a Muffin GetCurrentState reply, both into the shared
+ * CcDisplayStateSnapshot and into a CcDisplayConfigDBus, for walls of
+ * 1 to 32 monitors laid out side by side.
+ *
+ *   bench-display-config [ITERATIONS]
+ */
+
+#include "config.h"
+
+#include <gtk/gtk.h>
+
+#include "cc-display-config-dbus.h"
+#include "cc-display-state.h"
+
+#define DEFAULT_ITERATIONS 1000
+
+static const struct
+{
+  gint width;
+  gint height;
+  gdouble refresh;
+} modes[] = {
+  { 1920, 1080, 60.0 },
+  { 1920, 1080, 50.0 },
+  { 1680, 1050, 60.0 },
+  { 1280, 1024, 60.0 },
+  { 1280,  720, 60.0 },
+  { 1024,  768, 60.0 },
+};
+
+static GVariant *
+build_state (guint n_monitors)
+{
+  GVariantBuilder monitors;
+  GVariantBuilder logical_monitors;
+  guint i, j;
+
+  g_variant_builder_init (&monitors, G_VARIANT_TYPE ("a((ssss)a(siiddada{sv})a{sv})"));
+  g_variant_builder_init (&logical_monitors, G_VARIANT_TYPE ("a(iiduba(ssss)a{sv})"));
+
+  for (i = 0; i < n_monitors; i++)
+    {
+      g_autofree gchar *connector = g_strdup_printf ("DP-%u", i + 1);
+      g_autofree gchar *serial = g_strdup_printf ("%08u", i + 1);
+      g_autofree gchar *display_name = g_strdup_printf ("Monitor %u", i + 1);
+      GVariantBuilder monitor_modes;
+      GVariantBuilder props;
+
+      g_variant_builder_init (&monitor_modes, G_VARIANT_TYPE ("a(siiddada{sv})"));
+      for (j = 0; j < G_N_ELEMENTS (modes); j++)
+        {
+          g_autofree gchar *id = g_strdup_printf ("%dx%d@%.0f", modes[j].width, modes[j].height, modes[j].refresh);
+          const gdouble scales[] = { 1.0, 1.25, 1.5, 2.0 };
+          GVariantBuilder mode_props;
+
+          g_variant_builder_init (&mode_props, G_VARIANT_TYPE ("a{sv}"));
+          if (j == 0)
+            {
+              g_variant_builder_add (&mode_props, "{sv}", "is-current", g_variant_new_boolean (TRUE));
+              g_variant_builder_add (&mode_props, "{sv}", "is-preferred", g_variant_new_boolean (TRUE));
+            }
+
+          g_variant_builder_add (&monitor_modes, "(siidd@ada{sv})",
+                                 id, modes[j].width, modes[j].height, modes[j].refresh, 1.0,
+                                 g_variant_new_fixed_array (G_VARIANT_TYPE_DOUBLE, scales,
+                                                            G_N_ELEMENTS (scales), sizeof (gdouble)),
+                                 &mode_props);
+        }
+
+      g_variant_builder_init (&props, G_VARIANT_TYPE ("a{sv}"));
+      g_variant_builder_add (&props, "{sv}", "display-name", g_variant_new_string (display_name));
+      g_variant_builder_add (&props, "{sv}", "is-builtin", g_variant_new_boolean (FALSE));
+
+      g_variant_builder_add (&monitors, "((ssss)a(siiddada{sv})a{sv})",
+                             connector, "GSM", "LG ULTRAWIDE", serial,
+                             &monitor_modes, &props);
+
+      g_variant_builder_add (&logical_monitors, "(iiduba(ssss)a{sv})",
+                             (gint) (i * modes[0].width), 0, 1.0, 0, i == 0,
+                             g_variant_new_parsed ("[(%s, 'GSM', 'LG ULTRAWIDE', %s)]", connector, serial),
+                             NULL);
+    }
+
+  return g_variant_ref_sink (g_variant_new ("(ua((ssss)a(siiddada{sv})a{sv})a(iiduba(ssss)a{sv})a{sv})",
+                                            1, &monitors, &logical_monitors, NULL));
+}
+
+static gdouble
+time_snapshot (GVariant *state,
+               guint     iterations)
+{
+  gint64 start = g_get_monotonic_time ();
+  guint i;
+
+  for (i = 0; i < iterations; i++)
+    cc_display_state_snapshot_unref (cc_display_state_snapshot_new (state));
+
+  return (gdouble) (g_get_monotonic_time () - start) / iterations;
+}
+
+static gdouble
+time_config (GVariant *state,
+             guint     iterations)
+{
+  gint64 start = g_get_monotonic_time ();
+  guint i;
+
+  for (i = 0; i < iterations; i++)
+    g_object_unref (g_object_new (CC_TYPE_DISPLAY_CONFIG_DBUS,
+                                  "state", state,
+                                  NULL));
+
+  return (gdouble) (g_get_monotonic_time () - start) / iterations;
+}
+
+int
+main (int argc, char **argv)
+{
+  guint iterations = DEFAULT_ITERATIONS;
+  guint n;
+
+  gtk_init (&argc, &argv);
+
+  if (argc > 1)
+    iterations = MAX (1, g_ascii_strtoull (argv[1], NULL, 10));
+
+  g_print ("%8s %14s %14s\n", "monitors", "snapshot (us)", "config (us)");
+
+  for (n = 1; n <= 32; n *= 2)
+    {
+      g_autoptr(GVariant) state = build_state (n);
+
+      g_print ("%8u %14.1f %14.1f\n", n,
+               time_snapshot (state, iterations),
+               time_config (state, iterations));
+    }
+
+  return 0;
+}
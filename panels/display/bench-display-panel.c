@@ -0,0 +1,188 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * Loads the display panel module like the shell does, feeds it the mock
+ * Muffin layouts on a private session bus and times how long the panel
+ * takes to react to each change (reading the new config and rebuild_ui()).
+ *
+ *   bench-display-panel [ITERATIONS]
+ */
+
+#include "config.h"
+
+#include <gtk/gtk.h>
+
+#include <shell/cc-panel.h>
+#include <shell/cc-shell.h>
+
+#include "cc-display-state.h"
+#include "mock-display-config.h"
+
+#define DEFAULT_ITERATIONS 20
+#define TIMEOUT_USEC (5 * G_USEC_PER_SEC)
+
+static MockDisplayConfig *mock;
+static gint64 changed_start;
+static gint64 changed_time;
+
+static void
+state_changed_first_cb (void)
+{
+  changed_start = g_get_monotonic_time ();
+}
+
+static void
+state_changed_last_cb (void)
+{
+  changed_time = g_get_monotonic_time () - changed_start;
+}
+
+static gboolean
+wake_up_cb (gpointer user_data)
+{
+  return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+wait_for_state (void)
+{
+  gint64 deadline = g_get_monotonic_time () + TIMEOUT_USEC;
+  guint wake_up_id = g_timeout_add (10, wake_up_cb, NULL);
+  gboolean ret = FALSE;
+
+  while (g_get_monotonic_time () < deadline)
+    {
+      g_autoptr(CcDisplayStateSnapshot) snapshot = NULL;
+
+      snapshot = cc_display_state_get_snapshot (cc_display_state_get_default ());
+      if (snapshot &&
+          cc_display_state_snapshot_get_serial (snapshot) == mock_display_config_get_serial (mock))
+        {
+          ret = TRUE;
+          break;
+        }
+
+      g_main_context_iteration (NULL, TRUE);
+    }
+
+  g_source_remove (wake_up_id);
+
+  /* Let the panel settle (idle sources, resizes) */
+  while (g_main_context_iteration (NULL, FALSE));
+
+  return ret;
+}
+
+static GtkWidget *
+load_panel (void)
+{
+  GIOExtensionPoint *extension_point;
+  GIOExtension *extension;
+  GIOModule *module;
+
+  extension_point = g_io_extension_point_register (CC_SHELL_PANEL_EXTENSION_POINT);
+  g_io_extension_point_set_required_type (extension_point, CC_TYPE_PANEL);
+
+  module = g_io_module_new (DISPLAY_PANEL_MODULE);
+  if (!g_type_module_use (G_TYPE_MODULE (module)))
+    return NULL;
+
+  extension = g_io_extension_point_get_extension_by_name (extension_point, "display");
+  if (!extension)
+    return NULL;
+
+  return g_object_new (g_io_extension_get_type (extension), NULL);
+}
+
+int
+main (int argc, char **argv)
+{
+  GTestDBus *bus;
+  GtkWidget *window;
+  GtkWidget *panel;
+  g_autoptr(GError) error = NULL;
+  const gchar * const *layout;
+  guint iterations = DEFAULT_ITERATIONS;
+  guint i;
+
+  g_setenv ("GSETTINGS_BACKEND", "memory", TRUE);
+
+  gtk_init (&argc, &argv);
+
+  if (argc > 1)
+    iterations = MAX (1, g_ascii_strtoull (argv[1], NULL, 10));
+
+  bus = g_test_dbus_new (G_TEST_DBUS_NONE);
+  g_test_dbus_up (bus);
+
+  mock = mock_display_config_new ("laptop");
+  if (!mock_display_config_start (mock, g_test_dbus_get_bus_address (bus), &error))
+    g_error ("Failed to start the mock: %s", error->message);
+
+  /* Brackets the panel's own handlers */
+  g_signal_connect (cc_display_state_get_default (), "changed",
+                    G_CALLBACK (state_changed_first_cb), NULL);
+  g_signal_connect_after (cc_display_state_get_default (), "changed",
+                          G_CALLBACK (state_changed_last_cb), NULL);
+
+  panel = load_panel ();
+  if (!panel)
+    g_error ("Failed to load the display panel from %s", DISPLAY_PANEL_MODULE);
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_window_set_default_size (GTK_WINDOW (window), 800, 600);
+  gtk_container_add (GTK_CONTAINER (window), panel);
+  gtk_widget_show_all (window);
+
+  if (!wait_for_state ())
+    g_error ("The panel never got the initial state");
+
+  g_print ("%-8s %9s %16s\n", "layout", "monitors", "rebuild (ms)");
+
+  for (layout = mock_display_config_get_layouts (); *layout != NULL; layout++)
+    {
+      gint64 total = 0;
+
+      for (i = 0; i < iterations; i++)
+        {
+          /* Go through another layout so every step is a hotplug */
+          mock_display_config_set_layout (mock, g_str_equal (*layout, "laptop") ? "dual" : "laptop");
+          if (!wait_for_state ())
+            g_error ("Timed out waiting for %s", *layout);
+
+          mock_display_config_set_layout (mock, *layout);
+          if (!wait_for_state ())
+            g_error ("Timed out waiting for %s", *layout);
+
+          total += changed_time;
+        }
+
+      g_print ("%-8s %9u %16.2f\n", *layout,
+               mock_display_config_get_n_monitors (mock),
+               total / 1000.0 / iterations);
+    }
+
+  gtk_widget_destroy (window);
+  g_clear_object (&mock);
+
+  /* The shared display state keeps the session bus connection alive for
+   * the lifetime of the process, so don't wait for it to go away. */
+  g_test_dbus_stop (bus);
+
+  return 0;
+}
@@ -23,6 +23,7 @@
 #include "cc-display-arrangement.h"
 #include "cc-display-config.h"
 #include "cc-display-labeler.h"
+#include "cc-display-layout.h"
 
 struct _CcDisplayArrangement
 {
@@ -40,6 +41,14 @@ struct _CcDisplayArrangement
   gdouble           drag_anchor_x;
   gdouble           drag_anchor_y;
 
+  /* Motion events are compressed to one snap computation per frame. */
+  guint             drag_tick_id;
+  gboolean          drag_pending;
+  gdouble           drag_pending_x;
+  gdouble           drag_pending_y;
+  guint             drag_events_seen;
+  guint             drag_events_processed;
+
   guint             major_snap_distance;
 };
 
@@ -52,28 +61,9 @@ enum {
   PROP_LAST
 };
 
-typedef enum {
-  SNAP_DIR_NONE = 0,
-  SNAP_DIR_X    = 1 << 0,
-  SNAP_DIR_Y    = 1 << 1,
-  SNAP_DIR_BOTH = (SNAP_DIR_X | SNAP_DIR_Y),
-} SnapDirection;
-
-typedef struct {
-  cairo_matrix_t     to_widget;
-  guint              major_snap_distance;
-  gdouble            dist_x;
-  gdouble            dist_y;
-  gint               mon_x;
-  gint               mon_y;
-  SnapDirection      snapped;
-} SnapData;
-
 #define MARGIN_PX  0
 #define MARGIN_MON  0.66
 #define MAJOR_SNAP_DISTANCE 25
-#define MINOR_SNAP_DISTANCE 5
-#define MIN_OVERLAP 25
 
 G_DEFINE_TYPE (CcDisplayArrangement, cc_display_arrangement, GTK_TYPE_DRAWING_AREA)
 
@@ -203,164 +193,32 @@ monitor_get_drawing_rect (CcDisplayArrangement *self,
 }
 
 
-static void
-get_snap_distance (SnapData  *snap_data,
-                   gint       mon_x,
-                   gint       mon_y,
-                   gint       new_x,
-                   gint       new_y,
-                   gdouble   *dist_x,
-                   gdouble   *dist_y)
-{
-  gdouble local_dist_x, local_dist_y;
-
-  local_dist_x = ABS (mon_x - new_x);
-  local_dist_y = ABS (mon_y - new_y);
-
-  cairo_matrix_transform_distance (&snap_data->to_widget, &local_dist_x, &local_dist_y);
-
-  if (dist_x)
-    *dist_x = local_dist_x;
-  if (dist_y)
-    *dist_y = local_dist_y;
-}
-
-static void
-maybe_update_snap (SnapData       *snap_data,
-                   gint            mon_x,
-                   gint            mon_y,
-                   gint            new_x,
-                   gint            new_y,
-                   SnapDirection   snapped,
-                   SnapDirection   major_axis,
-                   gint            minor_unlimited)
-{
-  SnapDirection update_snap = SNAP_DIR_NONE;
-  gdouble dist_x, dist_y;
-  gdouble dist;
-
-  get_snap_distance (snap_data, mon_x, mon_y, new_x, new_y, &dist_x, &dist_y);
-  dist = MAX (dist_x, dist_y);
-
-  /* Snap by the variable max snap distance on the major axis, ensure the
-   * minor axis is below the minimum snapping distance (often just zero). */
-  switch (major_axis)
-    {
-      case SNAP_DIR_X:
-        if (dist_x > snap_data->major_snap_distance)
-          return;
-        if (dist_y > MINOR_SNAP_DISTANCE)
-          {
-            if (new_y > mon_y && minor_unlimited <= 0)
-              return;
-            if (new_y < mon_y && minor_unlimited >= 0)
-              return;
-          }
-        break;
-
-      case SNAP_DIR_Y:
-        if (dist_y > snap_data->major_snap_distance)
-          return;
-        if (dist_x > MINOR_SNAP_DISTANCE)
-          {
-            if (new_x > mon_x && minor_unlimited <= 0)
-              return;
-            if (new_x < mon_x && minor_unlimited >= 0)
-              return;
-          }
-        break;
-
-      default:
-        g_assert_not_reached();
-    }
-
-  if (snapped == SNAP_DIR_BOTH)
-    {
-      if (snap_data->snapped == SNAP_DIR_NONE)
-        update_snap = SNAP_DIR_BOTH;
-
-      /* Update, if this is closer on the main axis. */
-      if (((major_axis == SNAP_DIR_X) && (dist_x < snap_data->dist_x)) ||
-          ((major_axis == SNAP_DIR_Y) && (dist_y < snap_data->dist_y)))
-        {
-          update_snap = SNAP_DIR_BOTH;
-        }
-
-      /* Also update if we were only snapping in one direction earlier and it
-       * is better or equally good. */
-      if ((snap_data->snapped == SNAP_DIR_X && (dist <= snap_data->dist_x)) ||
-          (snap_data->snapped == SNAP_DIR_Y && (dist <= snap_data->dist_y)))
-        {
-          update_snap = SNAP_DIR_BOTH;
-        }
-
-      /* Also allow a minor axis to be added if the first axis remains identical. */
-      if (((snap_data->snapped == SNAP_DIR_X) && (major_axis == SNAP_DIR_X) && (new_x == snap_data->mon_x)) ||
-          ((snap_data->snapped == SNAP_DIR_Y) && (major_axis == SNAP_DIR_Y) && (new_y == snap_data->mon_y)))
-        {
-          update_snap = SNAP_DIR_BOTH;
-        }
-    }
-  else if (snapped == SNAP_DIR_X)
-    {
-      if (dist_x < snap_data->dist_x || (snap_data->snapped & SNAP_DIR_X) == SNAP_DIR_NONE)
-        update_snap = SNAP_DIR_X;
-    }
-  else if (snapped == SNAP_DIR_Y)
-    {
-      if (dist_y < snap_data->dist_y || (snap_data->snapped & SNAP_DIR_Y) == SNAP_DIR_NONE)
-        update_snap = SNAP_DIR_Y;
-    }
-  else
-    {
-      g_assert_not_reached ();
-    }
-
-  if (update_snap & SNAP_DIR_X)
-    {
-      snap_data->dist_x = dist_x;
-      snap_data->mon_x = new_x;
-      snap_data->snapped = snap_data->snapped | SNAP_DIR_X;
-    }
-  if (update_snap & SNAP_DIR_Y)
-    {
-      snap_data->dist_y = dist_y;
-      snap_data->mon_y = new_y;
-      snap_data->snapped = snap_data->snapped | SNAP_DIR_Y;
-    }
-}
-
+/* Snaps @snap_output against the other useful monitors, see
+ * cc_display_layout_snap(). */
 static void
 find_best_snapping (CcDisplayConfig   *config,
                     CcDisplayMonitor  *snap_output,
-                    SnapData          *snap_data)
+                    gdouble            distance_scale,
+                    guint              major_snap_distance,
+                    gint              *snap_x,
+                    gint              *snap_y)
 {
+  g_autofree CcDisplayLayoutRect *rects = NULL;
   GList *outputs, *l;
-  gint x1, y1, x2, y2;
-  gint w, h;
-  double max_scale;
+  gdouble max_scale;
+  guint n_rects = 1;
 
-  g_assert (snap_data != NULL);
+  outputs = cc_display_config_get_monitors (config);
+  rects = g_new (CcDisplayLayoutRect, g_list_length (outputs) + 1);
 
   max_scale = cc_display_config_get_maximum_scaling (config);
-  get_scaled_geometry (config, snap_output, max_scale, &x1, &y1, &w, &h);
-  x2 = x1 + w;
-  y2 = y1 + h;
-
-#define OVERLAP(_s1, _s2, _t1, _t2) ((_s1) <= (_t2) && (_t1) <= (_s2))
+  get_scaled_geometry (config, snap_output, max_scale,
+                       &rects[0].x, &rects[0].y, &rects[0].width, &rects[0].height);
 
-  outputs = cc_display_config_get_monitors (config);
   for (l = outputs; l; l = l->next)
     {
       CcDisplayMonitor *output = l->data;
-      gint _x1, _y1, _x2, _y2, _h, _w;
-      gint bottom_snap_pos;
-      gint top_snap_pos;
-      gint left_snap_pos;
-      gint right_snap_pos;
-      gdouble dist_x, dist_y;
-      gdouble max_scale;
-      gdouble tmp;
+      CcDisplayLayoutRect *rect = &rects[n_rects];
 
       if (output == snap_output)
         continue;
@@ -368,87 +226,11 @@ find_best_snapping (CcDisplayConfig   *config,
       if (!cc_display_monitor_is_useful (output))
         continue;
 
-      max_scale = cc_display_config_get_maximum_scaling (config);
-      get_scaled_geometry (config, output, max_scale, &_x1, &_y1, &_w, &_h);
-      _x2 = _x1 + _w;
-      _y2 = _y1 + _h;
-
-      top_snap_pos = _y1 - h;
-      bottom_snap_pos = _y2;
-      left_snap_pos = _x1 - w;
-      right_snap_pos = _x2;
-
-      dist_y = 9999;
-      /* overlap on the X axis */
-      if (OVERLAP (x1, x2, _x1, _x2))
-        {
-          get_snap_distance (snap_data, x1, y1, x1, top_snap_pos, NULL, &dist_y);
-          get_snap_distance (snap_data, x1, y1, x1, bottom_snap_pos, NULL, &tmp);
-          dist_y = MIN(dist_y, tmp);
-        }
-
-      dist_x = 9999;
-      /* overlap on the Y axis */
-      if (OVERLAP (y1, y2, _y1, _y2))
-        {
-          get_snap_distance (snap_data, x1, y1, left_snap_pos, y1, &dist_x, NULL);
-          get_snap_distance (snap_data, x1, y1, right_snap_pos, y1, &tmp, NULL);
-          dist_x = MIN(dist_x, tmp);
-        }
-
-      /* We only snap horizontally or vertically to an edge of the same monitor */
-      if (dist_y < dist_x)
-        {
-          maybe_update_snap (snap_data, x1, y1, x1, top_snap_pos, SNAP_DIR_Y, SNAP_DIR_Y, 0);
-          maybe_update_snap (snap_data, x1, y1, x1, bottom_snap_pos, SNAP_DIR_Y, SNAP_DIR_Y, 0);
-        }
-      else if (dist_x < 9999)
-        {
-          maybe_update_snap (snap_data, x1, y1, left_snap_pos, y1, SNAP_DIR_X, SNAP_DIR_X, 0);
-          maybe_update_snap (snap_data, x1, y1, right_snap_pos, y1, SNAP_DIR_X, SNAP_DIR_X, 0);
-        }
-
-      /* Left/right edge identical on the top */
-      maybe_update_snap (snap_data, x1, y1, _x1, top_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 0);
-      maybe_update_snap (snap_data, x1, y1, _x2 - w, top_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 0);
-
-      /* Left/right edge identical on the bottom */
-      maybe_update_snap (snap_data, x1, y1, _x1, bottom_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 0);
-      maybe_update_snap (snap_data, x1, y1, _x2 - w, bottom_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 0);
-
-      /* Top/bottom edge identical on the left */
-      maybe_update_snap (snap_data, x1, y1, left_snap_pos, _y1, SNAP_DIR_BOTH, SNAP_DIR_X, 0);
-      maybe_update_snap (snap_data, x1, y1, left_snap_pos, _y2 - h, SNAP_DIR_BOTH, SNAP_DIR_X, 0);
-
-      /* Top/bottom edge identical on the right */
-      maybe_update_snap (snap_data, x1, y1, right_snap_pos, _y1, SNAP_DIR_BOTH, SNAP_DIR_X, 0);
-      maybe_update_snap (snap_data, x1, y1, right_snap_pos, _y2 - h, SNAP_DIR_BOTH, SNAP_DIR_X, 0);
-
-      /* If snapping is infinite, then add snapping points with minimal overlap
-       * to prevent detachment.
-       * This is similar to the above but simply re-defines the snapping pos
-       * to have only minimal overlap */
-      if (snap_data->major_snap_distance == G_MAXUINT)
-        {
-          /* Hanging over the left/right edge on the top */
-          maybe_update_snap (snap_data, x1, y1, _x1 - w + MIN_OVERLAP, top_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 1);
-          maybe_update_snap (snap_data, x1, y1, _x2 - MIN_OVERLAP, top_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, -1);
-
-          /* Left/right edge identical on the bottom */
-          maybe_update_snap (snap_data, x1, y1, _x1 - w + MIN_OVERLAP, bottom_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 1);
-          maybe_update_snap (snap_data, x1, y1, _x2 - MIN_OVERLAP, bottom_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, -1);
-
-          /* Top/bottom edge identical on the left */
-          maybe_update_snap (snap_data, x1, y1, left_snap_pos, _y1 - h + MIN_OVERLAP, SNAP_DIR_BOTH, SNAP_DIR_X, 1);
-          maybe_update_snap (snap_data, x1, y1, left_snap_pos, _y2 - MIN_OVERLAP, SNAP_DIR_BOTH, SNAP_DIR_X, -1);
-
-          /* Top/bottom edge identical on the right */
-          maybe_update_snap (snap_data, x1, y1, right_snap_pos, _y1 - h + MIN_OVERLAP, SNAP_DIR_BOTH, SNAP_DIR_X, 1);
-          maybe_update_snap (snap_data, x1, y1, right_snap_pos, _y2 - MIN_OVERLAP, SNAP_DIR_BOTH, SNAP_DIR_X, -1);
-        }
+      get_scaled_geometry (config, output, max_scale, &rect->x, &rect->y, &rect->width, &rect->height);
+      n_rects++;
     }
 
-#undef OVERLAP
+  cc_display_layout_snap (rects, n_rects, 0, distance_scale, major_snap_distance, snap_x, snap_y);
 }
 
 static void
@@ -741,6 +523,71 @@ cc_display_arrangement_draw (GtkWidget *widget,
   return TRUE;
 }
 
+static void
+cc_display_arrangement_drag_step (CcDisplayArrangement *self)
+{
+  gdouble event_x, event_y;
+  gint mon_x, mon_y;
+  gint snap_x, snap_y;
+  gint64 start_time;
+
+  if (!self->drag_pending)
+    return;
+
+  self->drag_pending = FALSE;
+  self->drag_events_processed++;
+
+  g_assert (self->selected_output);
+
+  start_time = g_get_monotonic_time ();
+
+  event_x = self->drag_pending_x;
+  event_y = self->drag_pending_y;
+
+  cairo_matrix_transform_point (&self->to_actual, &event_x, &event_y);
+
+  mon_x = round (event_x - self->drag_anchor_x);
+  mon_y = round (event_y - self->drag_anchor_y);
+
+  /* The monitor is now at the location as if there was no snapping whatsoever. */
+  cc_display_monitor_set_position (self->selected_output, mon_x, mon_y);
+
+  /* to_widget only scales and translates, so xx is the distance scale */
+  find_best_snapping (self->config, self->selected_output,
+                      self->to_widget.xx, self->major_snap_distance,
+                      &snap_x, &snap_y);
+
+  cc_display_monitor_set_position (self->selected_output, snap_x, snap_y);
+
+  g_debug ("Drag step %u: %d,%d snapped to %d,%d in %" G_GINT64_FORMAT " us",
+           self->drag_events_processed, mon_x, mon_y,
+           snap_x, snap_y,
+           g_get_monotonic_time () - start_time);
+}
+
+static gboolean
+drag_tick_cb (GtkWidget     *widget,
+              GdkFrameClock *frame_clock,
+              gpointer       user_data)
+{
+  CcDisplayArrangement *self = CC_DISPLAY_ARRANGEMENT (widget);
+
+  self->drag_tick_id = 0;
+  cc_display_arrangement_drag_step (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+cc_display_arrangement_cancel_drag_tick (CcDisplayArrangement *self)
+{
+  if (self->drag_tick_id == 0)
+    return;
+
+  gtk_widget_remove_tick_callback (GTK_WIDGET (self), self->drag_tick_id);
+  self->drag_tick_id = 0;
+}
+
 static gboolean
 cc_display_arrangement_button_press_event (GtkWidget      *widget,
                                            GdkEventButton *event)
@@ -782,6 +629,8 @@ cc_display_arrangement_button_press_event (GtkWidget      *widget,
       self->drag_active = TRUE;
       self->drag_anchor_x = event_x - mon_x;
       self->drag_anchor_y = event_y - mon_y;
+      self->drag_events_seen = 0;
+      self->drag_events_processed = 0;
     }
 
   return TRUE;
@@ -804,6 +653,13 @@ cc_display_arrangement_button_release_event (GtkWidget      *widget,
   if (!self->drag_active)
     return FALSE;
 
+  /* Apply the last pointer position that has not been handled yet. */
+  cc_display_arrangement_cancel_drag_tick (self);
+  cc_display_arrangement_drag_step (self);
+
+  g_debug ("Drag finished: %u motion events, %u processed",
+           self->drag_events_seen, self->drag_events_processed);
+
   self->drag_active = FALSE;
 
   output = cc_display_arrangement_find_monitor_at (self, event->x, event->y);
@@ -822,9 +678,6 @@ cc_display_arrangement_motion_notify_event (GtkWidget      *widget,
                                             GdkEventMotion *event)
 {
   CcDisplayArrangement *self = CC_DISPLAY_ARRANGEMENT (widget);
-  gdouble event_x, event_y;
-  gint mon_x, mon_y;
-  SnapData snap_data;
 
   if (!self->config)
     return FALSE;
@@ -849,30 +702,15 @@ cc_display_arrangement_motion_notify_event (GtkWidget      *widget,
       return FALSE;
     }
 
-  g_assert (self->selected_output);
+  /* Only remember the latest pointer position, snapping happens once per
+   * frame in drag_tick_cb(). */
+  self->drag_events_seen++;
+  self->drag_pending = TRUE;
+  self->drag_pending_x = event->x;
+  self->drag_pending_y = event->y;
 
-  event_x = event->x;
-  event_y = event->y;
-
-  cairo_matrix_transform_point (&self->to_actual, &event_x, &event_y);
-
-  mon_x = round (event_x - self->drag_anchor_x);
-  mon_y = round (event_y - self->drag_anchor_y);
-
-  /* The monitor is now at the location as if there was no snapping whatsoever. */
-  snap_data.snapped = SNAP_DIR_NONE;
-  snap_data.mon_x = mon_x;
-  snap_data.mon_y = mon_y;
-  snap_data.dist_x = 0;
-  snap_data.dist_y = 0;
-  snap_data.to_widget = self->to_widget;
-  snap_data.major_snap_distance = self->major_snap_distance;
-
-  cc_display_monitor_set_position (self->selected_output, mon_x, mon_y);
-
-  find_best_snapping (self->config, self->selected_output, &snap_data);
-
-  cc_display_monitor_set_position (self->selected_output, snap_data.mon_x, snap_data.mon_y);
+  if (self->drag_tick_id == 0)
+    self->drag_tick_id = gtk_widget_add_tick_callback (widget, drag_tick_cb, NULL, NULL);
 
   return TRUE;
 }
@@ -1017,6 +855,8 @@ cc_display_arrangement_set_config (CcDisplayArrangement *self,
     }
   g_clear_object (&self->config);
 
+  cc_display_arrangement_cancel_drag_tick (self);
+  self->drag_pending = FALSE;
   self->drag_active = FALSE;
 
   /* Listen to all the signals */
@@ -1063,9 +903,7 @@ void
 cc_display_config_snap_output (CcDisplayConfig  *config,
                                CcDisplayMonitor *output)
 {
-  SnapData snap_data;
-  gint x, y, w, h;
-  gdouble max_scale;
+  gint x, y;
 
   if (!cc_display_monitor_is_useful (output))
     return;
@@ -1073,18 +911,7 @@ cc_display_config_snap_output (CcDisplayConfig  *config,
   if (cc_display_config_count_useful_monitors (config) <= 1)
     return;
 
-  max_scale = cc_display_config_get_maximum_scaling (config);
-  get_scaled_geometry (config, output, max_scale, &x, &y, &w, &h);
-
-  snap_data.snapped = SNAP_DIR_NONE;
-  snap_data.mon_x = x;
-  snap_data.mon_y = y;
-  snap_data.dist_x = 0;
-  snap_data.dist_y = 0;
-  cairo_matrix_init_identity (&snap_data.to_widget);
-  snap_data.major_snap_distance = G_MAXUINT;
-
-  find_best_snapping (config, output, &snap_data);
+  find_best_snapping (config, output, 1.0, G_MAXUINT, &x, &y);
 
-  cc_display_monitor_set_position (output, snap_data.mon_x, snap_data.mon_y);
+  cc_display_monitor_set_position (output, x, y);
 }
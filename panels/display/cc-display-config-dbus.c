@@ -21,6 +21,7 @@
 #include <gio/gio.h>
 
 #include "cc-display-config-dbus.h"
+#include "cc-display-layout.h"
 
 #define MODE_BASE_FORMAT "siiddad"
 #define MODE_FORMAT "(" MODE_BASE_FORMAT "a{sv})"
@@ -35,6 +36,13 @@
 
 #define CURRENT_STATE_FORMAT "(u" MONITORS_FORMAT LOGICAL_MONITORS_FORMAT "a{sv})"
 
+/* Saved layouts: the logical monitors with the vendor, product and serial
+ * of their monitors instead of connectors, so that they still apply when
+ * the displays move to other ports */
+#define LAYOUT_MONITOR_FORMAT "(ssssb)"
+#define LAYOUT_LOGICAL_MONITOR_FORMAT "(iidub" "a" LAYOUT_MONITOR_FORMAT ")"
+#define LAYOUT_FORMAT "(u" "a" LAYOUT_LOGICAL_MONITOR_FORMAT ")"
+
 typedef enum _CcDisplayModeFlags
 {
   MODE_PREFERRED = 1 << 0,
@@ -330,6 +338,11 @@ cc_display_config_dbus_append_right (CcDisplayConfigDBus *self,
                                      CcDisplayLogicalMonitor *monitor);
 static void
 cc_display_config_dbus_make_linear (CcDisplayConfigDBus *self);
+static CcDisplayLayoutRect *
+get_layout_rects (CcDisplayConfigDBus  *self,
+                  GList               **logical_monitors);
+static void
+invalidate_active_modes (CcDisplayConfigDBus *self);
 
 
 static const char *
@@ -892,9 +905,17 @@ struct _CcDisplayConfigDBus
   GList *monitors;
   CcDisplayMonitorDBus *primary;
 
+  /* Connector name -> CcDisplayMonitorDBus, built once in construct_monitors */
+  GHashTable *monitors_by_connector;
+  gchar *monitors_key;
+
   GHashTable *logical_monitors;
 
   GList *clone_modes;
+
+  /* CcDisplayLayoutModeInfo of the active monitors' current modes, for the
+   * global scale checks. NULL when a mode or monitor changed since. */
+  GArray *active_modes;
 };
 
 G_DEFINE_TYPE (CcDisplayConfigDBus,
@@ -1017,6 +1038,25 @@ cc_display_config_dbus_is_applicable (CcDisplayConfig *pself)
 {
   CcDisplayConfigDBus *self = CC_DISPLAY_CONFIG_DBUS (pself);
   g_autoptr(GError) error = NULL;
+  g_autofree CcDisplayLayoutRect *rects = NULL;
+  CcDisplayLayoutResult result;
+  GList *logical_monitors;
+  guint culprit = 0;
+
+  /* This runs on every edit, so don't bother Muffin with layouts it is
+   * going to refuse anyway. */
+  rects = get_layout_rects (self, &logical_monitors);
+  result = cc_display_layout_validate (rects,
+                                       g_hash_table_size (self->logical_monitors),
+                                       &culprit);
+  g_list_free (logical_monitors);
+
+  if (result != CC_DISPLAY_LAYOUT_VALID)
+    {
+      g_debug ("Config not applicable: layout check failed (%d) at logical monitor %u",
+               result, culprit);
+      return FALSE;
+    }
 
   if (!config_apply (self, CC_DISPLAY_CONFIG_METHOD_VERIFY, &error))
     {
@@ -1036,16 +1076,17 @@ monitor_from_spec (CcDisplayConfigDBus *self,
                    const gchar *product,
                    const gchar *serial)
 {
-  GList *l;
-  for (l = self->monitors; l != NULL; l = l->next)
-    {
-      CcDisplayMonitorDBus *m = l->data;
-      if (g_str_equal (m->connector_name, connector) &&
-          g_str_equal (m->vendor_name, vendor) &&
-          g_str_equal (m->product_name, product) &&
-          g_str_equal (m->product_serial, serial))
-        return m;
-    }
+  CcDisplayMonitorDBus *m;
+
+  /* Connectors are unique within a state, the rest of the spec still
+   * has to match for it to be the same monitor. */
+  m = g_hash_table_lookup (self->monitors_by_connector, connector);
+  if (m &&
+      g_str_equal (m->vendor_name, vendor) &&
+      g_str_equal (m->product_name, product) &&
+      g_str_equal (m->product_serial, serial))
+    return m;
+
   return NULL;
 }
 
@@ -1184,6 +1225,8 @@ cc_display_config_dbus_set_cloning (CcDisplayConfig *pself,
         }
       cc_display_config_dbus_make_linear (self);
     }
+
+  invalidate_active_modes (self);
 }
 
 static GList *
@@ -1203,6 +1246,319 @@ cc_display_config_dbus_apply (CcDisplayConfig *pself,
   return config_apply (self, CC_DISPLAY_CONFIG_METHOD_PERSISTENT, error);
 }
 
+static gint
+compare_logical_monitors (gconstpointer a,
+                          gconstpointer b)
+{
+  const CcDisplayLogicalMonitor *lma = *(CcDisplayLogicalMonitor **) a;
+  const CcDisplayLogicalMonitor *lmb = *(CcDisplayLogicalMonitor **) b;
+
+  if (lma->y != lmb->y)
+    return lma->y - lmb->y;
+
+  return lma->x - lmb->x;
+}
+
+static gint
+compare_monitors_by_product (gconstpointer a,
+                             gconstpointer b)
+{
+  const CcDisplayMonitorDBus *ma = *(CcDisplayMonitorDBus **) a;
+  const CcDisplayMonitorDBus *mb = *(CcDisplayMonitorDBus **) b;
+  gint ret;
+
+  ret = g_strcmp0 (ma->vendor_name, mb->vendor_name);
+  if (ret == 0)
+    ret = g_strcmp0 (ma->product_name, mb->product_name);
+  if (ret == 0)
+    ret = g_strcmp0 (ma->product_serial, mb->product_serial);
+
+  return ret;
+}
+
+static const char *
+cc_display_config_dbus_get_monitors_key (CcDisplayConfig *pself)
+{
+  CcDisplayConfigDBus *self = CC_DISPLAY_CONFIG_DBUS (pself);
+  g_autoptr(GPtrArray) specs = NULL;
+  g_autofree gchar *joined = NULL;
+  GList *l;
+
+  if (self->monitors_key)
+    return self->monitors_key;
+
+  specs = g_ptr_array_new_with_free_func (g_free);
+  for (l = self->monitors; l != NULL; l = l->next)
+    {
+      CcDisplayMonitorDBus *m = l->data;
+
+      g_ptr_array_add (specs, g_strdup_printf ("%s\t%s\t%s",
+                                               m->vendor_name,
+                                               m->product_name,
+                                               m->product_serial));
+    }
+  g_ptr_array_sort (specs, (GCompareFunc) g_strcmp0);
+  g_ptr_array_add (specs, NULL);
+
+  /* Same displays, same key, whatever port they are plugged into */
+  joined = g_strjoinv ("\n", (gchar **) specs->pdata);
+  self->monitors_key = g_compute_checksum_for_string (G_CHECKSUM_SHA256, joined, -1);
+
+  return self->monitors_key;
+}
+
+static GVariant *
+cc_display_config_dbus_get_layout (CcDisplayConfig *pself)
+{
+  CcDisplayConfigDBus *self = CC_DISPLAY_CONFIG_DBUS (pself);
+  g_autoptr(GPtrArray) logical_monitors = NULL;
+  g_autofree CcDisplayLayoutRect *rects = NULL;
+  GList *rect_monitors;
+  GVariantBuilder builder;
+  GHashTableIter iter;
+  CcDisplayLogicalMonitor *logical_monitor;
+  gint dx = 0, dy = 0;
+  guint i;
+
+  /* Stored starting at 0,0 like Muffin does, without moving this config's
+   * monitors; normalizing only translates the layout */
+  if (g_hash_table_size (self->logical_monitors) > 0)
+    {
+      rects = get_layout_rects (self, &rect_monitors);
+      dx = -rects[0].x;
+      dy = -rects[0].y;
+      cc_display_layout_normalize (rects, g_hash_table_size (self->logical_monitors));
+      dx += rects[0].x;
+      dy += rects[0].y;
+      g_list_free (rect_monitors);
+    }
+
+  /* Sorted, so that the same layout always serializes the same way */
+  logical_monitors = g_ptr_array_new ();
+  g_hash_table_iter_init (&iter, self->logical_monitors);
+  while (g_hash_table_iter_next (&iter, (void **) &logical_monitor, NULL))
+    g_ptr_array_add (logical_monitors, logical_monitor);
+  g_ptr_array_sort (logical_monitors, compare_logical_monitors);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a" LAYOUT_LOGICAL_MONITOR_FORMAT));
+
+  for (i = 0; i < logical_monitors->len; i++)
+    {
+      g_autoptr(GPtrArray) monitors = NULL;
+      GVariantBuilder monitors_builder;
+      CcDisplayMonitorDBus *monitor;
+      guint j;
+
+      logical_monitor = g_ptr_array_index (logical_monitors, i);
+
+      monitors = g_ptr_array_new ();
+      g_hash_table_iter_init (&iter, logical_monitor->monitors);
+      while (g_hash_table_iter_next (&iter, (void **) &monitor, NULL))
+        if (monitor->current_mode)
+          g_ptr_array_add (monitors, monitor);
+      g_ptr_array_sort (monitors, compare_monitors_by_product);
+
+      g_variant_builder_init (&monitors_builder, G_VARIANT_TYPE ("a" LAYOUT_MONITOR_FORMAT));
+      for (j = 0; j < monitors->len; j++)
+        {
+          monitor = g_ptr_array_index (monitors, j);
+          g_variant_builder_add (&monitors_builder, LAYOUT_MONITOR_FORMAT,
+                                 monitor->vendor_name,
+                                 monitor->product_name,
+                                 monitor->product_serial,
+                                 CC_DISPLAY_MODE_DBUS (monitor->current_mode)->id,
+                                 monitor->underscanning == UNDERSCANNING_ENABLED);
+        }
+
+      g_variant_builder_add (&builder, "(iidub@*)",
+                             logical_monitor->x + dx,
+                             logical_monitor->y + dy,
+                             logical_monitor->scale,
+                             logical_monitor->rotation,
+                             logical_monitor->primary,
+                             g_variant_builder_end (&monitors_builder));
+    }
+
+  return g_variant_new ("(u@*)", self->layout_mode, g_variant_builder_end (&builder));
+}
+
+/* Identical displays without a serial are matched by connector name, not
+ * in the order of self->monitors, which is the reverse of Muffin's. */
+static CcDisplayMonitorDBus *
+monitor_from_product (CcDisplayConfigDBus *self,
+                      GHashTable          *used,
+                      const gchar         *vendor,
+                      const gchar         *product,
+                      const gchar         *serial)
+{
+  CcDisplayMonitorDBus *found = NULL;
+  GList *l;
+
+  for (l = self->monitors; l != NULL; l = l->next)
+    {
+      CcDisplayMonitorDBus *m = l->data;
+
+      if (!g_hash_table_contains (used, m) &&
+          g_str_equal (m->vendor_name, vendor) &&
+          g_str_equal (m->product_name, product) &&
+          g_str_equal (m->product_serial, serial) &&
+          (found == NULL || g_strcmp0 (m->connector_name, found->connector_name) < 0))
+        found = m;
+    }
+
+  return found;
+}
+
+/* Turns a stored layout into ApplyMonitorsConfig parameters for the
+ * monitors as they are connected now. */
+static GVariant *
+build_layout_apply_parameters (CcDisplayConfigDBus  *self,
+                               GVariant             *layout,
+                               GError              **error)
+{
+  g_autoptr(GVariantIter) logical_monitors = NULL;
+  g_autoptr(GHashTable) used = NULL;
+  GVariantBuilder builder;
+  GVariantBuilder props_builder;
+  GVariantIter *monitors;
+  guint32 layout_mode;
+  gint x, y;
+  gdouble scale;
+  guint32 rotation;
+  gboolean primary;
+
+  g_variant_get (layout, LAYOUT_FORMAT, &layout_mode, &logical_monitors);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(iiduba(ssa{sv}))"));
+  used = g_hash_table_new (NULL, NULL);
+
+  while (g_variant_iter_next (logical_monitors, "(iidub" "a" LAYOUT_MONITOR_FORMAT ")",
+                              &x, &y, &scale, &rotation, &primary, &monitors))
+    {
+      GVariantBuilder monitors_builder;
+      const gchar *vendor, *product, *serial, *mode_id;
+      gboolean underscanning;
+
+      g_variant_builder_init (&monitors_builder, G_VARIANT_TYPE ("a(ssa{sv})"));
+
+      while (g_variant_iter_next (monitors, "(&s&s&s&sb)",
+                                  &vendor, &product, &serial,
+                                  &mode_id, &underscanning))
+        {
+          CcDisplayMonitorDBus *monitor;
+          GVariantBuilder monitor_props_builder;
+
+          monitor = monitor_from_product (self, used, vendor, product, serial);
+          if (!monitor)
+            {
+              g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND,
+                           "Display %s %s is not connected", vendor, product);
+              g_variant_builder_clear (&monitors_builder);
+              g_variant_builder_clear (&builder);
+              g_variant_iter_free (monitors);
+              return NULL;
+            }
+
+          g_hash_table_add (used, monitor);
+
+          g_variant_builder_init (&monitor_props_builder, G_VARIANT_TYPE ("a{sv}"));
+          g_variant_builder_add (&monitor_props_builder, "{sv}",
+                                 "underscanning", g_variant_new_boolean (underscanning));
+
+          g_variant_builder_add (&monitors_builder, "(ss@*)",
+                                 monitor->connector_name,
+                                 mode_id,
+                                 g_variant_builder_end (&monitor_props_builder));
+        }
+      g_variant_iter_free (monitors);
+
+      g_variant_builder_add (&builder, "(iidub@*)",
+                             x, y, scale, rotation, primary,
+                             g_variant_builder_end (&monitors_builder));
+    }
+
+  g_variant_builder_init (&props_builder, G_VARIANT_TYPE ("a{sv}"));
+  if (self->supports_changing_layout_mode)
+    g_variant_builder_add (&props_builder, "{sv}",
+                           "layout-mode", g_variant_new_uint32 (layout_mode));
+
+  return g_variant_new ("(uu@*@*)",
+                        self->serial,
+                        CC_DISPLAY_CONFIG_METHOD_PERSISTENT,
+                        g_variant_builder_end (&builder),
+                        g_variant_builder_end (&props_builder));
+}
+
+static void
+apply_layout_cb (GObject      *source_object,
+                 GAsyncResult *res,
+                 gpointer      user_data)
+{
+  g_autoptr(GTask) task = user_data;
+  g_autoptr(GVariant) retval = NULL;
+  GError *error = NULL;
+
+  retval = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source_object), res, &error);
+  if (!retval)
+    g_task_return_error (task, error);
+  else
+    g_task_return_boolean (task, TRUE);
+}
+
+static void
+cc_display_config_dbus_apply_layout_async (CcDisplayConfig     *pself,
+                                           GVariant            *layout,
+                                           GCancellable        *cancellable,
+                                           GAsyncReadyCallback  callback,
+                                           gpointer             user_data)
+{
+  CcDisplayConfigDBus *self = CC_DISPLAY_CONFIG_DBUS (pself);
+  g_autoptr(GTask) task = NULL;
+  GVariant *parameters;
+  GError *error = NULL;
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, cc_display_config_dbus_apply_layout_async);
+
+  if (!g_variant_is_of_type (layout, G_VARIANT_TYPE (LAYOUT_FORMAT)))
+    {
+      g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                               "Unknown layout format %s",
+                               g_variant_get_type_string (layout));
+      return;
+    }
+
+  parameters = build_layout_apply_parameters (self, layout, &error);
+  if (!parameters)
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  g_dbus_connection_call (self->connection,
+                          "org.cinnamon.Muffin.DisplayConfig",
+                          "/org/cinnamon/Muffin/DisplayConfig",
+                          "org.cinnamon.Muffin.DisplayConfig",
+                          "ApplyMonitorsConfig",
+                          parameters,
+                          NULL,
+                          G_DBUS_CALL_FLAGS_NO_AUTO_START,
+                          -1,
+                          cancellable,
+                          apply_layout_cb,
+                          g_steal_pointer (&task));
+}
+
+static gboolean
+cc_display_config_dbus_apply_layout_finish (CcDisplayConfig  *pself,
+                                            GAsyncResult     *result,
+                                            GError          **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, pself), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
 static gboolean
 cc_display_config_dbus_is_layout_logical (CcDisplayConfig *pself)
 {
@@ -1226,32 +1582,45 @@ cc_display_config_dbus_get_legacy_ui_scale (CcDisplayConfig *pself)
   return self->legacy_ui_scale;
 }
 
+static void
+get_mode_info (CcDisplayModeDBus       *mode,
+               CcDisplayLayoutModeInfo *info)
+{
+  info->width = mode->width;
+  info->height = mode->height;
+  info->supported_scales = (const gdouble *) mode->supported_scales->data;
+  info->n_supported_scales = mode->supported_scales->len;
+}
+
 static gboolean
 is_scaled_mode_allowed (CcDisplayConfigDBus *self,
                         CcDisplayMode       *pmode,
                         double               scale)
 {
-  gint width, height;
-  CcDisplayModeDBus *mode = CC_DISPLAY_MODE_DBUS (pmode);
+  CcDisplayLayoutModeInfo info;
 
-  if (!cc_display_mode_dbus_is_supported_scale (pmode, scale))
-    return FALSE;
+  get_mode_info (CC_DISPLAY_MODE_DBUS (pmode), &info);
 
-  /* Do the math as if the monitor is always in landscape mode. */
-  width = round (mode->width / scale);
-  height = round (mode->height / scale);
+  return cc_display_layout_is_scale_allowed (&info, scale, self->min_width, self->min_height);
+}
 
-  return (MAX (width, height) >= self->min_width &&
-          MIN (width, height) >= self->min_height);
+static void
+invalidate_active_modes (CcDisplayConfigDBus *self)
+{
+  g_clear_pointer (&self->active_modes, g_array_unref);
 }
 
-static gboolean
-is_scale_allowed_by_active_monitors (CcDisplayConfigDBus *self,
-                                     CcDisplayMode       *mode,
-                                     double               scale)
+static GArray *
+get_active_modes (CcDisplayConfigDBus *self)
 {
+  CcDisplayLayoutModeInfo info;
   GList *l;
 
+  if (self->active_modes)
+    return self->active_modes;
+
+  self->active_modes = g_array_new (FALSE, FALSE, sizeof (CcDisplayLayoutModeInfo));
+
   for (l = self->monitors; l != NULL; l = l->next)
     {
       CcDisplayMonitorDBus *m = CC_DISPLAY_MONITOR_DBUS (l->data);
@@ -1259,14 +1628,30 @@ is_scale_allowed_by_active_monitors (CcDisplayConfigDBus *self,
       if (!cc_display_monitor_is_active (CC_DISPLAY_MONITOR (m)))
         continue;
 
-      if (!is_scaled_mode_allowed (self, m->current_mode, scale))
-        return FALSE;
-
-      if (!is_scaled_mode_allowed (self, mode, scale))
-        return FALSE;
+      get_mode_info (CC_DISPLAY_MODE_DBUS (m->current_mode), &info);
+      g_array_append_val (self->active_modes, info);
     }
 
-  return TRUE;
+  return self->active_modes;
+}
+
+static gboolean
+is_scale_allowed_by_active_monitors (CcDisplayConfigDBus *self,
+                                     CcDisplayMode       *mode,
+                                     double               scale)
+{
+  GArray *active_modes = get_active_modes (self);
+
+  /* With nothing active there is nothing to share the scale with */
+  if (active_modes->len == 0)
+    return TRUE;
+
+  if (!is_scaled_mode_allowed (self, mode, scale))
+    return FALSE;
+
+  return cc_display_layout_is_scale_allowed_by_all ((CcDisplayLayoutModeInfo *) active_modes->data,
+                                                    active_modes->len, scale,
+                                                    self->min_width, self->min_height);
 }
 
 static void
@@ -1304,6 +1689,7 @@ cc_display_config_dbus_init (CcDisplayConfigDBus *self)
   self->global_scale_required = FALSE;
   self->layout_mode = CC_DISPLAY_LAYOUT_MODE_LOGICAL;
   self->logical_monitors = g_hash_table_new (NULL, NULL);
+  self->monitors_by_connector = g_hash_table_new (g_str_hash, g_str_equal);
 }
 
 static void
@@ -1384,6 +1770,15 @@ construct_monitors (CcDisplayConfigDBus *self,
 
       monitor = cc_display_monitor_dbus_new (variant, self);
       self->monitors = g_list_prepend (self->monitors, monitor);
+      g_hash_table_insert (self->monitors_by_connector,
+                           monitor->connector_name, monitor);
+
+      g_signal_connect_object (monitor, "mode",
+                               G_CALLBACK (invalidate_active_modes),
+                               self, G_CONNECT_SWAPPED);
+      g_signal_connect_object (monitor, "active",
+                               G_CALLBACK (invalidate_active_modes),
+                               self, G_CONNECT_SWAPPED);
 
       if (self->global_scale_required)
         g_signal_connect_object (monitor, "scale",
@@ -1554,8 +1949,11 @@ cc_display_config_dbus_finalize (GObject *object)
 
   g_list_foreach (self->monitors, (GFunc) g_object_unref, NULL);
   g_clear_pointer (&self->monitors, g_list_free);
+  g_clear_pointer (&self->monitors_by_connector, g_hash_table_destroy);
+  g_clear_pointer (&self->monitors_key, g_free);
   g_clear_pointer (&self->logical_monitors, g_hash_table_destroy);
   g_clear_pointer (&self->clone_modes, g_list_free);
+  g_clear_pointer (&self->active_modes, g_array_unref);
 
   G_OBJECT_CLASS (cc_display_config_dbus_parent_class)->finalize (object);
 }
@@ -1584,6 +1982,10 @@ cc_display_config_dbus_class_init (CcDisplayConfigDBusClass *klass)
   parent_class->set_minimum_size = cc_display_config_dbus_set_minimum_size;
   parent_class->layout_use_ui_scale = cc_display_config_dbus_layout_use_ui_scale;
   parent_class->get_legacy_ui_scale = cc_display_config_dbus_get_legacy_ui_scale;
+  parent_class->get_monitors_key = cc_display_config_dbus_get_monitors_key;
+  parent_class->get_layout = cc_display_config_dbus_get_layout;
+  parent_class->apply_layout_async = cc_display_config_dbus_apply_layout_async;
+  parent_class->apply_layout_finish = cc_display_config_dbus_apply_layout_finish;
 
   pspec = g_param_spec_variant ("state",
                                 "GVariant",
@@ -1613,22 +2015,6 @@ sort_x_axis (gconstpointer a, gconstpointer b)
   return ma->x - mb->x;
 }
 
-static gint
-sort_y_axis (gconstpointer a, gconstpointer b)
-{
-  const CcDisplayLogicalMonitor *ma = a;
-  const CcDisplayLogicalMonitor *mb = b;
-  return ma->y - mb->y;
-}
-
-static void
-add_x_delta (gpointer d1, gpointer d2)
-{
-  CcDisplayLogicalMonitor *m = d1;
-  int delta = GPOINTER_TO_INT (d2);
-  m->x += delta;
-}
-
 static gboolean
 logical_monitor_is_rotated (CcDisplayLogicalMonitor *lm)
 {
@@ -1664,65 +2050,115 @@ get_maximum_scale (CcDisplayConfig *config)
   return max_scale;
 }
 
-static int
-logical_monitor_width (CcDisplayLogicalMonitor *lm)
+static void
+get_logical_monitor_rect (CcDisplayLogicalMonitor *lm,
+                          CcDisplayLayoutRect     *rect)
 {
   CcDisplayMonitorDBus *monitor;
   CcDisplayModeDBus *mode;
   GHashTableIter iter;
-  int width;
+  int width, height;
+
+  rect->x = lm->x;
+  rect->y = lm->y;
+  rect->width = rect->height = 0;
 
   g_hash_table_iter_init (&iter, lm->monitors);
-  g_hash_table_iter_next (&iter, (void **) &monitor, NULL);
+  if (!g_hash_table_iter_next (&iter, (void **) &monitor, NULL))
+    return;
+
   mode = CC_DISPLAY_MODE_DBUS (monitor->current_mode);
+  if (!mode)
+    return;
+
   if (logical_monitor_is_rotated (lm))
-    width = mode ? mode->height : 0;
+    {
+      width = mode->height;
+      height = mode->width;
+    }
   else
-    width = mode ? mode->width : 0;
+    {
+      width = mode->width;
+      height = mode->height;
+    }
 
   if (monitor->config->layout_mode == CC_DISPLAY_LAYOUT_MODE_LOGICAL)
-    return round (width / lm->scale);
-  if (monitor->config->layout_mode == CC_DISPLAY_LAYOUT_MODE_GLOBAL_UI_LOGICAL)
+    {
+      rect->width = round (width / lm->scale);
+      rect->height = round (height / lm->scale);
+    }
+  else if (monitor->config->layout_mode == CC_DISPLAY_LAYOUT_MODE_GLOBAL_UI_LOGICAL)
     {
       double max_scale = get_maximum_scale(CC_DISPLAY_CONFIG (monitor->config));
-      return round ((width * ceil (max_scale)) / lm->scale);
+      rect->width = round ((width * ceil (max_scale)) / lm->scale);
+      rect->height = round ((height * ceil (max_scale)) / lm->scale);
     }
   else
-    return width;
+    {
+      rect->width = width;
+      rect->height = height;
+    }
+}
+
+static int
+logical_monitor_width (CcDisplayLogicalMonitor *lm)
+{
+  CcDisplayLayoutRect rect;
+
+  get_logical_monitor_rect (lm, &rect);
+
+  return rect.width;
+}
+
+/* Flattens the logical monitors for the layout engine, the rectangles are
+ * in the order of the returned list. */
+static CcDisplayLayoutRect *
+get_layout_rects (CcDisplayConfigDBus  *self,
+                  GList               **logical_monitors)
+{
+  CcDisplayLayoutRect *rects;
+  GList *l;
+  guint i = 0;
+
+  *logical_monitors = g_hash_table_get_keys (self->logical_monitors);
+  rects = g_new (CcDisplayLayoutRect, g_hash_table_size (self->logical_monitors));
+
+  for (l = *logical_monitors; l != NULL; l = l->next)
+    get_logical_monitor_rect (l->data, &rects[i++]);
+
+  return rects;
 }
 
 static void
-add_y_delta (gpointer d1, gpointer d2)
+set_layout_positions (GList                     *logical_monitors,
+                      const CcDisplayLayoutRect *rects)
 {
-  CcDisplayLogicalMonitor *m = d1;
-  int delta = GPOINTER_TO_INT (d2);
-  m->y += delta;
+  GList *l;
+  guint i = 0;
+
+  for (l = logical_monitors; l != NULL; l = l->next, i++)
+    {
+      CcDisplayLogicalMonitor *m = l->data;
+
+      m->x = rects[i].x;
+      m->y = rects[i].y;
+    }
 }
 
 static void
 cc_display_config_dbus_ensure_non_offset_coords (CcDisplayConfigDBus *self)
 {
-  GList *x_axis, *y_axis;
-  CcDisplayLogicalMonitor *m;
+  g_autofree CcDisplayLayoutRect *rects = NULL;
+  GList *logical_monitors;
 
   if (g_hash_table_size (self->logical_monitors) == 0)
     return;
 
-  x_axis = g_hash_table_get_keys (self->logical_monitors);
-  x_axis = g_list_sort (x_axis, sort_x_axis);
-  y_axis = g_hash_table_get_keys (self->logical_monitors);
-  y_axis = g_list_sort (y_axis, sort_y_axis);
-
-  m = x_axis->data;
-  if (m->x != 0)
-    g_list_foreach (x_axis, add_x_delta, GINT_TO_POINTER (- m->x));
-
-  m = y_axis->data;
-  if (m->y != 0)
-    g_list_foreach (y_axis, add_y_delta, GINT_TO_POINTER (- m->y));
+  rects = get_layout_rects (self, &logical_monitors);
+  cc_display_layout_normalize (rects, g_hash_table_size (self->logical_monitors));
+  set_layout_positions (logical_monitors, rects);
 
-  g_list_free (x_axis);
-  g_list_free (y_axis);
+  g_list_free (logical_monitors);
 }
 
 static void
@@ -1751,34 +2187,17 @@ cc_display_config_dbus_append_right (CcDisplayConfigDBus *self,
 static void
 cc_display_config_dbus_make_linear (CcDisplayConfigDBus *self)
 {
-  CcDisplayLogicalMonitor *primary;
-  GList *logical_monitors, *l;
-  int x;
+  g_autofree CcDisplayLayoutRect *rects = NULL;
+  GList *logical_monitors;
+  gint primary = -1;
 
-  if (self->primary && self->primary->logical_monitor)
-    {
-      primary = self->primary->logical_monitor;
-      primary->x = primary->y = 0;
-      x = logical_monitor_width (primary);
-    }
-  else
-    {
-      primary = NULL;
-      x = 0;
-    }
-
-  logical_monitors = g_hash_table_get_keys (self->logical_monitors);
-  for (l = logical_monitors; l != NULL; l = l->next)
-    {
-      CcDisplayLogicalMonitor *m = l->data;
+  rects = get_layout_rects (self, &logical_monitors);
 
-      if (m == primary)
-        continue;
+  if (self->primary && self->primary->logical_monitor)
+    primary = g_list_index (logical_monitors, self->primary->logical_monitor);
 
-      m->x = x;
-      m->y = 0;
-      x += logical_monitor_width (m);
-    }
+  cc_display_layout_make_linear (rects, g_hash_table_size (self->logical_monitors), primary);
+  set_layout_positions (logical_monitors, rects);
 
   g_list_free (logical_monitors);
 }
@@ -19,6 +19,7 @@
 
 #include "cc-display-config-dbus.h"
 #include "cc-display-config-manager-dbus.h"
+#include "cc-display-state.h"
 
 #include <gio/gio.h>
 
@@ -26,12 +27,8 @@ struct _CcDisplayConfigManagerDBus
 {
   CcDisplayConfigManager parent_instance;
 
-  GCancellable *cancellable;
-  GDBusConnection *connection;
-  guint monitors_changed_id;
-  guint muffin_watch_id;
-
-  GVariant *current_state;
+  CcDisplayState *state;
+  guint initial_changed_id;
 };
 
 G_DEFINE_TYPE (CcDisplayConfigManagerDBus,
@@ -42,151 +39,56 @@ static CcDisplayConfig *
 cc_display_config_manager_dbus_get_current (CcDisplayConfigManager *pself)
 {
   CcDisplayConfigManagerDBus *self = CC_DISPLAY_CONFIG_MANAGER_DBUS (pself);
+  g_autoptr(CcDisplayStateSnapshot) snapshot = NULL;
 
-  if (!self->current_state)
+  snapshot = cc_display_state_get_snapshot (self->state);
+  if (!snapshot)
     return NULL;
 
   return g_object_new (CC_TYPE_DISPLAY_CONFIG_DBUS,
-                       "state", self->current_state,
-                       "connection", self->connection, NULL);
+                       "state", cc_display_state_snapshot_get_variant (snapshot),
+                       "connection", cc_display_state_get_connection (self->state),
+                       NULL);
 }
 
 static void
-got_current_state (GObject      *object,
-                   GAsyncResult *result,
-                   gpointer      data)
+state_changed_cb (CcDisplayConfigManagerDBus *self)
 {
-  CcDisplayConfigManagerDBus *self;
-  GVariant *variant;
-  g_autoptr(GError) error = NULL;
-
-  variant = g_dbus_connection_call_finish (G_DBUS_CONNECTION (object),
-                                           result, &error);
-  if (!variant)
+  if (self->initial_changed_id)
     {
-      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
-        {
-          self = CC_DISPLAY_CONFIG_MANAGER_DBUS (data);
-          g_clear_pointer (&self->current_state, g_variant_unref);
-          _cc_display_config_manager_emit_changed (CC_DISPLAY_CONFIG_MANAGER (data));
-          g_warning ("Error calling GetCurrentState: %s", error->message);
-        }
-      return;
+      g_source_remove (self->initial_changed_id);
+      self->initial_changed_id = 0;
     }
 
-  self = CC_DISPLAY_CONFIG_MANAGER_DBUS (data);
-  g_clear_pointer (&self->current_state, g_variant_unref);
-  self->current_state = variant;
-
   _cc_display_config_manager_emit_changed (CC_DISPLAY_CONFIG_MANAGER (self));
 }
 
-static void
-get_current_state (CcDisplayConfigManagerDBus *self)
-{
-  g_dbus_connection_call (self->connection,
-                          "org.cinnamon.Muffin.DisplayConfig",
-                          "/org/cinnamon/Muffin/DisplayConfig",
-                          "org.cinnamon.Muffin.DisplayConfig",
-                          "GetCurrentState",
-                          NULL,
-                          NULL,
-                          G_DBUS_CALL_FLAGS_NO_AUTO_START,
-                          -1,
-                          self->cancellable,
-                          got_current_state,
-                          self);
-}
-
-static void
-monitors_changed (GDBusConnection *connection,
-                  const gchar     *sender_name,
-                  const gchar     *object_path,
-                  const gchar     *interface_name,
-                  const gchar     *signal_name,
-                  GVariant        *parameters,
-                  gpointer         data)
+static gboolean
+initial_changed_cb (gpointer user_data)
 {
-  CcDisplayConfigManagerDBus *self = CC_DISPLAY_CONFIG_MANAGER_DBUS (data);
-  get_current_state (self);
-}
-
-static void
-muffin_vanished_cb (GDBusConnection *connection,
-                    const gchar     *name,
-                    gpointer         user_data)
-{
-  CcDisplayConfigManagerDBus *self = user_data;
-
-  g_debug ("Muffin vanished");
-
-  g_clear_pointer (&self->current_state, g_variant_unref);
-  _cc_display_config_manager_emit_changed (CC_DISPLAY_CONFIG_MANAGER (user_data));
-}
+  CcDisplayConfigManagerDBus *self = CC_DISPLAY_CONFIG_MANAGER_DBUS (user_data);
 
-static void
-muffin_appeared_cb (GDBusConnection *connection,
-                    const gchar     *name,
-                    const gchar     *name_owner,
-                    gpointer         user_data)
-{
-  CcDisplayConfigManagerDBus *self = user_data;
-
-  g_debug ("Muffin appeared");
-
-  get_current_state (self);
-}
-
-static void
-bus_gotten (GObject      *object,
-            GAsyncResult *result,
-            gpointer      data)
-{
-  CcDisplayConfigManagerDBus *self;
-  GDBusConnection *connection;
-  g_autoptr(GError) error = NULL;
-
-  connection = g_bus_get_finish (result, &error);
-  if (!connection)
-    {
-      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
-        {
-          _cc_display_config_manager_emit_changed (CC_DISPLAY_CONFIG_MANAGER (data));
-          g_warning ("Error obtaining DBus connection: %s", error->message);
-        }
-      return;
-    }
+  self->initial_changed_id = 0;
+  _cc_display_config_manager_emit_changed (CC_DISPLAY_CONFIG_MANAGER (self));
 
-  self = CC_DISPLAY_CONFIG_MANAGER_DBUS (data);
-  self->connection = connection;
-  self->monitors_changed_id =
-    g_dbus_connection_signal_subscribe (self->connection,
-                                        "org.cinnamon.Muffin.DisplayConfig",
-                                        "org.cinnamon.Muffin.DisplayConfig",
-                                        "MonitorsChanged",
-                                        "/org/cinnamon/Muffin/DisplayConfig",
-                                        NULL,
-                                        G_DBUS_SIGNAL_FLAGS_NONE,
-                                        monitors_changed,
-                                        self,
-                                        NULL);
-
-  self->muffin_watch_id = g_bus_watch_name_on_connection (self->connection,
-                                                    "org.cinnamon.Muffin.DisplayConfig",
-                                                    G_BUS_NAME_WATCHER_FLAGS_NONE,
-                                                    muffin_appeared_cb,
-                                                    muffin_vanished_cb,
-                                                    self,
-                                                    NULL);
-
-  get_current_state (self);
+  return G_SOURCE_REMOVE;
 }
 
 static void
 cc_display_config_manager_dbus_init (CcDisplayConfigManagerDBus *self)
 {
-  self->cancellable = g_cancellable_new ();
-  g_bus_get (G_BUS_TYPE_SESSION, self->cancellable, bus_gotten, self);
+  g_autoptr(CcDisplayStateSnapshot) snapshot = NULL;
+
+  self->state = g_object_ref (cc_display_state_get_default ());
+  g_signal_connect_object (self->state, "changed",
+                           G_CALLBACK (state_changed_cb), self,
+                           G_CONNECT_SWAPPED);
+
+  /* Another panel may already have fetched the state, announce it once
+   * our owner had a chance to connect to the changed signal. */
+  snapshot = cc_display_state_get_snapshot (self->state);
+  if (snapshot)
+    self->initial_changed_id = g_idle_add (initial_changed_cb, self);
 }
 
 static void
@@ -194,18 +96,11 @@ cc_display_config_manager_dbus_finalize (GObject *object)
 {
   CcDisplayConfigManagerDBus *self = CC_DISPLAY_CONFIG_MANAGER_DBUS (object);
 
-  g_cancellable_cancel (self->cancellable);
-  g_clear_object (&self->cancellable);
-
-  if (self->monitors_changed_id && self->connection)
-    g_dbus_connection_signal_unsubscribe (self->connection,
-                                          self->monitors_changed_id);
-
-  if (self->muffin_watch_id && self->connection)
-    g_bus_unwatch_name (self->muffin_watch_id);
+  if (self->initial_changed_id)
+    g_source_remove (self->initial_changed_id);
+  self->initial_changed_id = 0;
 
-  g_clear_object (&self->connection);
-  g_clear_pointer (&self->current_state, g_variant_unref);
+  g_clear_object (&self->state);
 
   G_OBJECT_CLASS (cc_display_config_manager_dbus_parent_class)->finalize (object);
 }
@@ -460,6 +460,9 @@ struct _CcDisplayConfigPrivate {
   GSettings *muffin_settings;
   gboolean fractional_scaling;
   gboolean fractional_scaling_pending_disable;
+
+  /* Largest scale of the useful monitors, < 0 when it needs recomputing */
+  double maximum_scaling;
 };
 typedef struct _CcDisplayConfigPrivate CcDisplayConfigPrivate;
 
@@ -537,12 +540,21 @@ cc_display_config_init (CcDisplayConfig *self)
   CcDisplayConfigPrivate *priv = cc_display_config_get_instance_private (self);
 
   priv->ui_sorted_monitors = NULL;
+  priv->maximum_scaling = -1.0;
 
   /* No need to connect to the setting, as we'll get notified by mutter */
   priv->muffin_settings = g_settings_new (MUFFIN_SCHEMA);
   priv->fractional_scaling = get_fractional_scaling_active (self);
 }
 
+static void
+invalidate_maximum_scaling (CcDisplayConfig *self)
+{
+  CcDisplayConfigPrivate *priv = cc_display_config_get_instance_private (self);
+
+  priv->maximum_scaling = -1.0;
+}
+
 static void
 cc_display_config_constructed (GObject *object)
 {
@@ -555,6 +567,13 @@ cc_display_config_constructed (GObject *object)
   for (item = monitors; item != NULL; item = item->next)
     {
       CcDisplayMonitor *monitor = item->data;
+      const gchar *signals[] = { "mode", "scale", "active", "is-usable" };
+      gsize i;
+
+      for (i = 0; i < G_N_ELEMENTS (signals); i++)
+        g_signal_connect_object (monitor, signals[i],
+                                 G_CALLBACK (invalidate_maximum_scaling),
+                                 self, G_CONNECT_SWAPPED);
 
       if (cc_display_monitor_is_builtin (monitor))
         priv->ui_sorted_monitors = g_list_prepend (priv->ui_sorted_monitors, monitor);
@@ -717,7 +736,11 @@ cc_display_config_set_cloning (CcDisplayConfig *self,
                                gboolean clone)
 {
   g_return_if_fail (CC_IS_DISPLAY_CONFIG (self));
-  return CC_DISPLAY_CONFIG_GET_CLASS (self)->set_cloning (self, clone);
+
+  CC_DISPLAY_CONFIG_GET_CLASS (self)->set_cloning (self, clone);
+
+  /* Cloning can turn monitors on without an "active" signal */
+  invalidate_maximum_scaling (self);
 }
 
 GList *
@@ -780,8 +803,14 @@ cc_display_config_layout_use_ui_scale (CcDisplayConfig *self)
 double
 cc_display_config_get_maximum_scaling (CcDisplayConfig *self)
 {
+  CcDisplayConfigPrivate *priv = cc_display_config_get_instance_private (self);
   GList *outputs, *l;
   double max_scale = 1.0;
+
+  /* Asked for on every draw and drag step, only changes with the monitors */
+  if (priv->maximum_scaling > 0)
+    return priv->maximum_scaling;
+
   outputs = cc_display_config_get_monitors (self);
 
   for (l = outputs; l; l = l->next)
@@ -794,6 +823,8 @@ cc_display_config_get_maximum_scaling (CcDisplayConfig *self)
       max_scale = MAX (max_scale, cc_display_monitor_get_scale (output));
     }
 
+  priv->maximum_scaling = max_scale;
+
   return max_scale;
 }
 
@@ -914,3 +945,43 @@ cc_display_config_get_fractional_scaling (CcDisplayConfig *self)
 
   return priv->fractional_scaling;
 }
+
+/* Identifies the set of connected displays, whatever ports they are
+ * plugged into. */
+const char *
+cc_display_config_get_monitors_key (CcDisplayConfig *self)
+{
+  g_return_val_if_fail (CC_IS_DISPLAY_CONFIG (self), NULL);
+  return CC_DISPLAY_CONFIG_GET_CLASS (self)->get_monitors_key (self);
+}
+
+/* The arrangement, modes and scales, to be saved and applied again later
+ * with cc_display_config_apply_layout_async() when the same displays are
+ * connected. */
+GVariant *
+cc_display_config_get_layout (CcDisplayConfig *self)
+{
+  g_return_val_if_fail (CC_IS_DISPLAY_CONFIG (self), NULL);
+  return g_variant_ref_sink (CC_DISPLAY_CONFIG_GET_CLASS (self)->get_layout (self));
+}
+
+void
+cc_display_config_apply_layout_async (CcDisplayConfig     *self,
+                                      GVariant            *layout,
+                                      GCancellable        *cancellable,
+                                      GAsyncReadyCallback  callback,
+                                      gpointer             user_data)
+{
+  g_return_if_fail (CC_IS_DISPLAY_CONFIG (self));
+  CC_DISPLAY_CONFIG_GET_CLASS (self)->apply_layout_async (self, layout, cancellable,
+                                                          callback, user_data);
+}
+
+gboolean
+cc_display_config_apply_layout_finish (CcDisplayConfig  *self,
+                                       GAsyncResult     *result,
+                                       GError          **error)
+{
+  g_return_val_if_fail (CC_IS_DISPLAY_CONFIG (self), FALSE);
+  return CC_DISPLAY_CONFIG_GET_CLASS (self)->apply_layout_finish (self, result, error);
+}
@@ -19,7 +19,7 @@
 
 #pragma once
 
-#include <glib-object.h>
+#include <gio/gio.h>
 
 G_BEGIN_DECLS
 
@@ -162,6 +162,16 @@ struct _CcDisplayConfigClass
                                     double            scale);
   gboolean (*layout_use_ui_scale) (CcDisplayConfig  *self);
   gint     (*get_legacy_ui_scale) (CcDisplayConfig  *self);
+  const char* (*get_monitors_key)   (CcDisplayConfig  *self);
+  GVariant*   (*get_layout)         (CcDisplayConfig  *self);
+  void        (*apply_layout_async)  (CcDisplayConfig     *self,
+                                      GVariant            *layout,
+                                      GCancellable        *cancellable,
+                                      GAsyncReadyCallback  callback,
+                                      gpointer             user_data);
+  gboolean    (*apply_layout_finish) (CcDisplayConfig  *self,
+                                      GAsyncResult     *result,
+                                      GError          **error);
 };
 
 
@@ -196,6 +206,17 @@ void              cc_display_config_set_fractional_scaling  (CcDisplayConfig
                                                              gboolean            enabled);
 gboolean          cc_display_config_get_fractional_scaling  (CcDisplayConfig    *self);
 
+const char*       cc_display_config_get_monitors_key        (CcDisplayConfig    *self);
+GVariant*         cc_display_config_get_layout              (CcDisplayConfig    *self);
+void              cc_display_config_apply_layout_async      (CcDisplayConfig    *self,
+                                                             GVariant           *layout,
+                                                             GCancellable       *cancellable,
+                                                             GAsyncReadyCallback callback,
+                                                             gpointer            user_data);
+gboolean          cc_display_config_apply_layout_finish     (CcDisplayConfig    *self,
+                                                             GAsyncResult       *result,
+                                                             GError            **error);
+
 const char*       cc_display_monitor_get_display_name       (CcDisplayMonitor   *monitor);
 gboolean          cc_display_monitor_is_active              (CcDisplayMonitor   *monitor);
 void              cc_display_monitor_set_active             (CcDisplayMonitor   *monitor,
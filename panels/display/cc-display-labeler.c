@@ -40,9 +40,10 @@
 typedef struct {
 	CcDisplayConfig *config;
 
-	int num_outputs;
-
-	GtkWidget **windows;
+	/* Label windows are kept around between show and hide, keyed
+	 * by connector name, so they only get realized once. */
+	GHashTable *windows;
+	gboolean    shown;
 
 	GdkScreen  *screen;
 	Atom        workarea_atom;
@@ -76,10 +77,8 @@ screen_xevent_filter (GdkXEvent      *xevent,
 	if (xev->type == PropertyNotify &&
 	    xev->xproperty.atom == labeler->priv->workarea_atom) {
 		/* update label positions */
-		if (labeler->priv->windows != NULL) {
-			cc_display_labeler_hide (labeler);
+		if (labeler->priv->shown)
 			cc_display_labeler_show (labeler);
-		}
 	}
 
 	return GDK_FILTER_CONTINUE;
@@ -92,6 +91,9 @@ cc_display_labeler_init (CcDisplayLabeler *labeler)
 
 	labeler->priv = cc_display_labeler_get_instance_private (labeler);
 
+	labeler->priv->windows = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                                g_free, (GDestroyNotify) gtk_widget_destroy);
+
 	labeler->priv->workarea_atom = XInternAtom (GDK_DISPLAY_XDISPLAY (gdk_display_get_default ()),
 						    "_NET_WORKAREA",
 						    True);
@@ -109,7 +111,7 @@ cc_display_labeler_set_property (GObject *gobject, guint property_id, const GVal
 
 	switch (property_id) {
 	case PROP_CONFIG:
-		self->priv->config = CC_DISPLAY_CONFIG (g_value_dup_object (value));
+		cc_display_labeler_set_config (self, g_value_get_object (value));
 		return;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, property_id, param_spec);
@@ -130,7 +132,7 @@ cc_display_labeler_class_init (CcDisplayLabelerClass *klass)
 											 "Configuration",
 											 "RandR configuration to label",
 											 CC_TYPE_DISPLAY_CONFIG,
-											 G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY |
+											 G_PARAM_WRITABLE | G_PARAM_CONSTRUCT |
 											 G_PARAM_STATIC_NICK | G_PARAM_STATIC_BLURB));
     g_signal_new ("get-output-color",
                   CC_TYPE_DISPLAY_LABELER,
@@ -150,29 +152,12 @@ cc_display_labeler_finalize (GObject *object)
     gdkwindow = gdk_screen_get_root_window (labeler->priv->screen);
     gdk_window_remove_filter (gdkwindow, (GdkFilterFunc) screen_xevent_filter, labeler);
 
-	if (labeler->priv->config != NULL) {
-		g_object_unref (labeler->priv->config);
-	}
-
-	if (labeler->priv->windows != NULL) {
-		cc_display_labeler_hide (labeler);
-		g_free (labeler->priv->windows);
-	}
+	g_clear_object (&labeler->priv->config);
+	g_clear_pointer (&labeler->priv->windows, g_hash_table_destroy);
 
 	G_OBJECT_CLASS (cc_display_labeler_parent_class)->finalize (object);
 }
 
-static int
-count_outputs (CcDisplayConfig *config)
-{
-	int i;
-	GList *outputs = cc_display_config_get_ui_sorted_monitors (config);
-
-	i = g_list_length (outputs);
-
-    return i;
-}
-
 static void
 rounded_rectangle (cairo_t *cr,
                    gint     x,
@@ -324,14 +309,11 @@ label_window_composited_changed_cb (GtkWidget *widget, CcDisplayLabeler *labeler
 }
 
 static GtkWidget *
-create_label_window (CcDisplayLabeler *labeler, CcDisplayMonitor *output, gchar *rgba_str, gint num)
+create_label_window (CcDisplayLabeler *labeler)
 {
 	GtkWidget *window;
 	GtkWidget *widget;
-	char *str;
-	const char *display_name, *output_name;
 	GdkRGBA black = { 0, 0, 0, 1.0 };
-	int x, y;
 	GdkScreen *screen;
 	GdkVisual *visual;
 
@@ -346,13 +328,6 @@ create_label_window (CcDisplayLabeler *labeler, CcDisplayMonitor *output, gchar
 
 	gtk_container_set_border_width (GTK_CONTAINER (window), LABEL_WINDOW_PADDING + LABEL_WINDOW_EDGE_THICKNESS);
 
-	/* This is semi-dangerous.  The color is part of the labeler->palette
-	 * array.  Note that in cc_display_labeler_finalize(), we are careful to
-	 * free the palette only after we free the windows.
-	 */
-
-	g_object_set_data_full (G_OBJECT (window), "rgba", rgba_str, (GDestroyNotify) g_free);
-
 	g_signal_connect (window, "draw",
 			  G_CALLBACK (label_window_draw_event_cb), labeler);
 	g_signal_connect (window, "realize",
@@ -360,6 +335,26 @@ create_label_window (CcDisplayLabeler *labeler, CcDisplayMonitor *output, gchar
 	g_signal_connect (window, "composited-changed",
 			  G_CALLBACK (label_window_composited_changed_cb), labeler);
 
+	widget = gtk_label_new (NULL);
+	gtk_label_set_justify (GTK_LABEL (widget), GTK_JUSTIFY_CENTER);
+	gtk_widget_override_color (widget, gtk_widget_get_state_flags (widget), &black);
+	gtk_widget_show (widget);
+
+	gtk_container_add (GTK_CONTAINER (window), widget);
+
+	return window;
+}
+
+static void
+update_label_window (CcDisplayLabeler *labeler, GtkWidget *window, CcDisplayMonitor *output, gchar *rgba_str, gint num)
+{
+	char *str;
+	const char *display_name, *output_name;
+
+	/* The window takes ownership of the color string, replacing the one
+	 * from a previous show. */
+	g_object_set_data_full (G_OBJECT (window), "rgba", rgba_str, (GDestroyNotify) g_free);
+
 	if (cc_display_config_is_cloning (labeler->priv->config)) {
 		/* Translators:  this is the feature where what you see on your
 		 * laptop's screen is the same as your external projector.
@@ -375,21 +370,13 @@ create_label_window (CcDisplayLabeler *labeler, CcDisplayMonitor *output, gchar
 		str = g_strdup_printf ("<b>%d  %s</b>\n%s", num, display_name, output_name);
 	}
 
-	widget = gtk_label_new (NULL);
-	gtk_label_set_markup (GTK_LABEL (widget), str);
-	gtk_label_set_justify (GTK_LABEL (widget), GTK_JUSTIFY_CENTER);
+	gtk_label_set_markup (GTK_LABEL (gtk_bin_get_child (GTK_BIN (window))), str);
 	g_free (str);
 
-	gtk_widget_override_color (widget, gtk_widget_get_state_flags (widget), &black);
-
-	gtk_container_add (GTK_CONTAINER (window), widget);
-
-	cc_display_monitor_get_geometry (output, &x, &y, NULL, NULL);
 	position_window (labeler, output, window);
 
-	gtk_widget_show_all (window);
-
-	return window;
+	gtk_widget_queue_draw (window);
+	gtk_widget_show (window);
 }
 
 /**
@@ -411,6 +398,47 @@ cc_display_labeler_new (CcDisplayConfig *config)
 	return g_object_new (CC_TYPE_DISPLAY_LABELER, "config", config, NULL);
 }
 
+/**
+ * cc_display_labeler_set_config:
+ * @labeler: A #CcDisplayLabeler
+ * @config: Configuration of the screens to label
+ *
+ * Switch to a new configuration. Label windows of outputs that are still
+ * connected are kept and will be reused by the next cc_display_labeler_show().
+ */
+void
+cc_display_labeler_set_config (CcDisplayLabeler *labeler,
+                               CcDisplayConfig  *config)
+{
+	g_autoptr(GHashTable) connectors = NULL;
+	GHashTableIter iter;
+	const gchar *connector;
+	GList *l;
+
+	g_return_if_fail (CC_IS_DISPLAY_LABELER (labeler));
+
+	if (labeler->priv->config == config)
+		return;
+
+	g_clear_object (&labeler->priv->config);
+
+	if (config != NULL)
+		labeler->priv->config = g_object_ref (config);
+
+	/* Drop the windows of outputs that are gone, so that the pool does
+	 * not grow with every connector ever plugged in. */
+	connectors = g_hash_table_new (g_str_hash, g_str_equal);
+	if (config != NULL)
+		for (l = cc_display_config_get_monitors (config); l != NULL; l = l->next)
+			g_hash_table_add (connectors,
+			                  (gpointer) cc_display_monitor_get_connector_name (CC_DISPLAY_MONITOR (l->data)));
+
+	g_hash_table_iter_init (&iter, labeler->priv->windows);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &connector, NULL))
+		if (!g_hash_table_contains (connectors, connector))
+			g_hash_table_iter_remove (&iter);
+}
+
 /**
  * cc_display_labeler_show:
  * @labeler: A #CcDisplayLabeler
@@ -420,36 +448,51 @@ cc_display_labeler_new (CcDisplayConfig *config)
 void
 cc_display_labeler_show (CcDisplayLabeler *labeler)
 {
-    gint i;
+	gint i;
 	gboolean created_window_for_clone;
 	GList *outputs, *l;
+	GHashTableIter iter;
+	GtkWidget *window;
+	g_autoptr(GHashTable) used = NULL;
 
 	g_return_if_fail (CC_IS_DISPLAY_LABELER (labeler));
 
-	if (labeler->priv->windows != NULL)
+	if (labeler->priv->config == NULL)
 		return;
 
-    labeler->priv->num_outputs = count_outputs (labeler->priv->config);
-	labeler->priv->windows = g_new (GtkWidget *, labeler->priv->num_outputs);
+	labeler->priv->shown = TRUE;
+	used = g_hash_table_new (g_direct_hash, g_direct_equal);
 
 	created_window_for_clone = FALSE;
 
 	outputs = cc_display_config_get_ui_sorted_monitors (labeler->priv->config);
 
-    for (l = outputs, i = 0; l != NULL; l = l->next, i++) {
-        CcDisplayMonitor *output = CC_DISPLAY_MONITOR (l->data);
+	for (l = outputs, i = 0; l != NULL && !created_window_for_clone; l = l->next, i++) {
+		CcDisplayMonitor *output = CC_DISPLAY_MONITOR (l->data);
+		const char *connector;
+		gchar *rgba_str;
 
-		if (!created_window_for_clone) {
-            gchar *rgba_str;
+		connector = cc_display_monitor_get_connector_name (output);
 
-            g_signal_emit_by_name (G_OBJECT (labeler), "get-output-color", i, &rgba_str);
-			labeler->priv->windows[i] = create_label_window (labeler, output, rgba_str, i + 1);
+		window = g_hash_table_lookup (labeler->priv->windows, connector);
+		if (window == NULL) {
+			window = create_label_window (labeler);
+			g_hash_table_insert (labeler->priv->windows, g_strdup (connector), window);
+		}
+
+		g_signal_emit_by_name (G_OBJECT (labeler), "get-output-color", i, &rgba_str);
+		update_label_window (labeler, window, output, rgba_str, i + 1);
+		g_hash_table_add (used, window);
 
-			if (cc_display_config_is_cloning (labeler->priv->config))
-				created_window_for_clone = TRUE;
-		} else
-			labeler->priv->windows[i] = NULL;
+		if (cc_display_config_is_cloning (labeler->priv->config))
+			created_window_for_clone = TRUE;
 	}
+
+	/* Outputs not labelled this time (e.g. clones) keep their window, hidden. */
+	g_hash_table_iter_init (&iter, labeler->priv->windows);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &window))
+		if (!g_hash_table_contains (used, window))
+			gtk_widget_hide (window);
 }
 
 /**
@@ -461,22 +504,14 @@ cc_display_labeler_show (CcDisplayLabeler *labeler)
 void
 cc_display_labeler_hide (CcDisplayLabeler *labeler)
 {
-	int i;
-	CcDisplayLabelerPrivate *priv;
+	GHashTableIter iter;
+	GtkWidget *window;
 
 	g_return_if_fail (CC_IS_DISPLAY_LABELER (labeler));
 
-	priv = labeler->priv;
+	labeler->priv->shown = FALSE;
 
-	if (priv->windows == NULL)
-		return;
-
-	for (i = 0; i < priv->num_outputs; i++)
-		if (priv->windows[i] != NULL) {
-			gtk_widget_destroy (priv->windows[i]);
-			priv->windows[i] = NULL;
-	}
-	g_free (priv->windows);
-	priv->windows = NULL;
+	g_hash_table_iter_init (&iter, labeler->priv->windows);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &window))
+		gtk_widget_hide (window);
 }
-
@@ -33,6 +33,7 @@ G_BEGIN_DECLS
 G_DECLARE_FINAL_TYPE (CcDisplayLabeler, cc_display_labeler, CC, DISPLAY_LABELER, GObject)
 
 CcDisplayLabeler *cc_display_labeler_new (CcDisplayConfig *config);
+void cc_display_labeler_set_config (CcDisplayLabeler *labeler, CcDisplayConfig *config);
 void cc_display_labeler_show (CcDisplayLabeler *labeler);
 void cc_display_labeler_hide (CcDisplayLabeler *labeler);
 
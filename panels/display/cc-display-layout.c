@@ -0,0 +1,491 @@
+/*
+ * Copyright (C) 2007, 2008, 2017  Red Hat, Inc.
+ * Copyright (C) 2013 Intel, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <math.h>
+
+#include "cc-display-layout.h"
+
+typedef enum {
+  SNAP_DIR_NONE = 0,
+  SNAP_DIR_X    = 1 << 0,
+  SNAP_DIR_Y    = 1 << 1,
+  SNAP_DIR_BOTH = (SNAP_DIR_X | SNAP_DIR_Y),
+} SnapDirection;
+
+typedef struct {
+  gdouble            distance_scale;
+  guint              major_snap_distance;
+  gdouble            dist_x;
+  gdouble            dist_y;
+  gint               mon_x;
+  gint               mon_y;
+  SnapDirection      snapped;
+} SnapData;
+
+#define MINOR_SNAP_DISTANCE 5
+#define MIN_OVERLAP 25
+
+gboolean
+cc_display_layout_rects_overlap (const CcDisplayLayoutRect *a,
+                                 const CcDisplayLayoutRect *b)
+{
+  return a->x < b->x + b->width && b->x < a->x + a->width &&
+         a->y < b->y + b->height && b->y < a->y + a->height;
+}
+
+/* Same as Muffin's meta_rectangle_is_adjacent_to(): sharing an edge, and
+ * more than just a corner of it. */
+gboolean
+cc_display_layout_rects_adjacent (const CcDisplayLayoutRect *a,
+                                  const CcDisplayLayoutRect *b)
+{
+  gboolean x_touch = a->x + a->width == b->x || b->x + b->width == a->x;
+  gboolean y_touch = a->y + a->height == b->y || b->y + b->height == a->y;
+  gboolean x_span = a->x < b->x + b->width && b->x < a->x + a->width;
+  gboolean y_span = a->y < b->y + b->height && b->y < a->y + a->height;
+
+  return (x_touch && y_span) || (y_touch && x_span);
+}
+
+/**
+ * cc_display_layout_validate:
+ * @rects: the logical monitors
+ * @n_rects: number of @rects
+ * @culprit: (out) (optional): index of the offending rectangle
+ *
+ * Checks @rects the way Muffin checks a new configuration: logical monitors
+ * must not overlap and each of them must share an edge with another one.
+ * Offset layouts are not an error, see cc_display_layout_normalize().
+ */
+CcDisplayLayoutResult
+cc_display_layout_validate (const CcDisplayLayoutRect *rects,
+                            guint                      n_rects,
+                            guint                     *culprit)
+{
+  guint i, j;
+
+  if (n_rects == 0)
+    return CC_DISPLAY_LAYOUT_EMPTY;
+
+  for (i = 0; i < n_rects; i++)
+    {
+      gboolean has_neighbour = n_rects == 1;
+
+      for (j = 0; j < n_rects; j++)
+        {
+          if (i == j)
+            continue;
+
+          if (cc_display_layout_rects_overlap (&rects[i], &rects[j]))
+            {
+              if (culprit)
+                *culprit = i;
+              return CC_DISPLAY_LAYOUT_OVERLAPPING;
+            }
+
+          if (!has_neighbour && cc_display_layout_rects_adjacent (&rects[i], &rects[j]))
+            has_neighbour = TRUE;
+        }
+
+      if (!has_neighbour)
+        {
+          if (culprit)
+            *culprit = i;
+          return CC_DISPLAY_LAYOUT_DETACHED;
+        }
+    }
+
+  return CC_DISPLAY_LAYOUT_VALID;
+}
+
+/* Moves the layout so that it starts at 0,0, as Muffin wants it. */
+void
+cc_display_layout_normalize (CcDisplayLayoutRect *rects,
+                             guint                n_rects)
+{
+  gint min_x = G_MAXINT, min_y = G_MAXINT;
+  guint i;
+
+  if (n_rects == 0)
+    return;
+
+  for (i = 0; i < n_rects; i++)
+    {
+      min_x = MIN (min_x, rects[i].x);
+      min_y = MIN (min_y, rects[i].y);
+    }
+
+  if (min_x == 0 && min_y == 0)
+    return;
+
+  for (i = 0; i < n_rects; i++)
+    {
+      rects[i].x -= min_x;
+      rects[i].y -= min_y;
+    }
+}
+
+/* Puts @primary (if not -1) at the origin and lines up the others to the
+ * right of it, in order, along the top edge. */
+void
+cc_display_layout_make_linear (CcDisplayLayoutRect *rects,
+                               guint                n_rects,
+                               gint                 primary)
+{
+  gint x = 0;
+  guint i;
+
+  g_return_if_fail (primary < (gint) n_rects);
+
+  if (primary >= 0)
+    {
+      rects[primary].x = rects[primary].y = 0;
+      x = rects[primary].width;
+    }
+
+  for (i = 0; i < n_rects; i++)
+    {
+      if ((gint) i == primary)
+        continue;
+
+      rects[i].x = x;
+      rects[i].y = 0;
+      x += rects[i].width;
+    }
+}
+
+static void
+get_snap_distance (SnapData  *snap_data,
+                   gint       mon_x,
+                   gint       mon_y,
+                   gint       new_x,
+                   gint       new_y,
+                   gdouble   *dist_x,
+                   gdouble   *dist_y)
+{
+  if (dist_x)
+    *dist_x = ABS (mon_x - new_x) * snap_data->distance_scale;
+  if (dist_y)
+    *dist_y = ABS (mon_y - new_y) * snap_data->distance_scale;
+}
+
+static void
+maybe_update_snap (SnapData       *snap_data,
+                   gint            mon_x,
+                   gint            mon_y,
+                   gint            new_x,
+                   gint            new_y,
+                   SnapDirection   snapped,
+                   SnapDirection   major_axis,
+                   gint            minor_unlimited)
+{
+  SnapDirection update_snap = SNAP_DIR_NONE;
+  gdouble dist_x, dist_y;
+  gdouble dist;
+
+  get_snap_distance (snap_data, mon_x, mon_y, new_x, new_y, &dist_x, &dist_y);
+  dist = MAX (dist_x, dist_y);
+
+  /* Snap by the variable max snap distance on the major axis, ensure the
+   * minor axis is below the minimum snapping distance (often just zero). */
+  switch (major_axis)
+    {
+      case SNAP_DIR_X:
+        if (dist_x > snap_data->major_snap_distance)
+          return;
+        if (dist_y > MINOR_SNAP_DISTANCE)
+          {
+            if (new_y > mon_y && minor_unlimited <= 0)
+              return;
+            if (new_y < mon_y && minor_unlimited >= 0)
+              return;
+          }
+        break;
+
+      case SNAP_DIR_Y:
+        if (dist_y > snap_data->major_snap_distance)
+          return;
+        if (dist_x > MINOR_SNAP_DISTANCE)
+          {
+            if (new_x > mon_x && minor_unlimited <= 0)
+              return;
+            if (new_x < mon_x && minor_unlimited >= 0)
+              return;
+          }
+        break;
+
+      default:
+        g_assert_not_reached();
+    }
+
+  if (snapped == SNAP_DIR_BOTH)
+    {
+      if (snap_data->snapped == SNAP_DIR_NONE)
+        update_snap = SNAP_DIR_BOTH;
+
+      /* Update, if this is closer on the main axis. */
+      if (((major_axis == SNAP_DIR_X) && (dist_x < snap_data->dist_x)) ||
+          ((major_axis == SNAP_DIR_Y) && (dist_y < snap_data->dist_y)))
+        {
+          update_snap = SNAP_DIR_BOTH;
+        }
+
+      /* Also update if we were only snapping in one direction earlier and it
+       * is better or equally good. */
+      if ((snap_data->snapped == SNAP_DIR_X && (dist <= snap_data->dist_x)) ||
+          (snap_data->snapped == SNAP_DIR_Y && (dist <= snap_data->dist_y)))
+        {
+          update_snap = SNAP_DIR_BOTH;
+        }
+
+      /* Also allow a minor axis to be added if the first axis remains identical. */
+      if (((snap_data->snapped == SNAP_DIR_X) && (major_axis == SNAP_DIR_X) && (new_x == snap_data->mon_x)) ||
+          ((snap_data->snapped == SNAP_DIR_Y) && (major_axis == SNAP_DIR_Y) && (new_y == snap_data->mon_y)))
+        {
+          update_snap = SNAP_DIR_BOTH;
+        }
+    }
+  else if (snapped == SNAP_DIR_X)
+    {
+      if (dist_x < snap_data->dist_x || (snap_data->snapped & SNAP_DIR_X) == SNAP_DIR_NONE)
+        update_snap = SNAP_DIR_X;
+    }
+  else if (snapped == SNAP_DIR_Y)
+    {
+      if (dist_y < snap_data->dist_y || (snap_data->snapped & SNAP_DIR_Y) == SNAP_DIR_NONE)
+        update_snap = SNAP_DIR_Y;
+    }
+  else
+    {
+      g_assert_not_reached ();
+    }
+
+  if (update_snap & SNAP_DIR_X)
+    {
+      snap_data->dist_x = dist_x;
+      snap_data->mon_x = new_x;
+      snap_data->snapped = snap_data->snapped | SNAP_DIR_X;
+    }
+  if (update_snap & SNAP_DIR_Y)
+    {
+      snap_data->dist_y = dist_y;
+      snap_data->mon_y = new_y;
+      snap_data->snapped = snap_data->snapped | SNAP_DIR_Y;
+    }
+}
+
+static void
+find_best_snapping (const CcDisplayLayoutRect *rects,
+                    guint                      n_rects,
+                    guint                      index,
+                    SnapData                  *snap_data)
+{
+  gint x1, y1, x2, y2;
+  gint w, h;
+  guint i;
+
+  x1 = rects[index].x;
+  y1 = rects[index].y;
+  w = rects[index].width;
+  h = rects[index].height;
+  x2 = x1 + w;
+  y2 = y1 + h;
+
+#define OVERLAP(_s1, _s2, _t1, _t2) ((_s1) <= (_t2) && (_t1) <= (_s2))
+
+  for (i = 0; i < n_rects; i++)
+    {
+      gint _x1, _y1, _x2, _y2;
+      gint bottom_snap_pos;
+      gint top_snap_pos;
+      gint left_snap_pos;
+      gint right_snap_pos;
+      gdouble dist_x, dist_y;
+      gdouble tmp;
+
+      if (i == index)
+        continue;
+
+      _x1 = rects[i].x;
+      _y1 = rects[i].y;
+      _x2 = _x1 + rects[i].width;
+      _y2 = _y1 + rects[i].height;
+
+      top_snap_pos = _y1 - h;
+      bottom_snap_pos = _y2;
+      left_snap_pos = _x1 - w;
+      right_snap_pos = _x2;
+
+      dist_y = 9999;
+      /* overlap on the X axis */
+      if (OVERLAP (x1, x2, _x1, _x2))
+        {
+          get_snap_distance (snap_data, x1, y1, x1, top_snap_pos, NULL, &dist_y);
+          get_snap_distance (snap_data, x1, y1, x1, bottom_snap_pos, NULL, &tmp);
+          dist_y = MIN(dist_y, tmp);
+        }
+
+      dist_x = 9999;
+      /* overlap on the Y axis */
+      if (OVERLAP (y1, y2, _y1, _y2))
+        {
+          get_snap_distance (snap_data, x1, y1, left_snap_pos, y1, &dist_x, NULL);
+          get_snap_distance (snap_data, x1, y1, right_snap_pos, y1, &tmp, NULL);
+          dist_x = MIN(dist_x, tmp);
+        }
+
+      /* We only snap horizontally or vertically to an edge of the same monitor */
+      if (dist_y < dist_x)
+        {
+          maybe_update_snap (snap_data, x1, y1, x1, top_snap_pos, SNAP_DIR_Y, SNAP_DIR_Y, 0);
+          maybe_update_snap (snap_data, x1, y1, x1, bottom_snap_pos, SNAP_DIR_Y, SNAP_DIR_Y, 0);
+        }
+      else if (dist_x < 9999)
+        {
+          maybe_update_snap (snap_data, x1, y1, left_snap_pos, y1, SNAP_DIR_X, SNAP_DIR_X, 0);
+          maybe_update_snap (snap_data, x1, y1, right_snap_pos, y1, SNAP_DIR_X, SNAP_DIR_X, 0);
+        }
+
+      /* Left/right edge identical on the top */
+      maybe_update_snap (snap_data, x1, y1, _x1, top_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 0);
+      maybe_update_snap (snap_data, x1, y1, _x2 - w, top_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 0);
+
+      /* Left/right edge identical on the bottom */
+      maybe_update_snap (snap_data, x1, y1, _x1, bottom_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 0);
+      maybe_update_snap (snap_data, x1, y1, _x2 - w, bottom_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 0);
+
+      /* Top/bottom edge identical on the left */
+      maybe_update_snap (snap_data, x1, y1, left_snap_pos, _y1, SNAP_DIR_BOTH, SNAP_DIR_X, 0);
+      maybe_update_snap (snap_data, x1, y1, left_snap_pos, _y2 - h, SNAP_DIR_BOTH, SNAP_DIR_X, 0);
+
+      /* Top/bottom edge identical on the right */
+      maybe_update_snap (snap_data, x1, y1, right_snap_pos, _y1, SNAP_DIR_BOTH, SNAP_DIR_X, 0);
+      maybe_update_snap (snap_data, x1, y1, right_snap_pos, _y2 - h, SNAP_DIR_BOTH, SNAP_DIR_X, 0);
+
+      /* If snapping is infinite, then add snapping points with minimal overlap
+       * to prevent detachment.
+       * This is similar to the above but simply re-defines the snapping pos
+       * to have only minimal overlap */
+      if (snap_data->major_snap_distance == G_MAXUINT)
+        {
+          /* Hanging over the left/right edge on the top */
+          maybe_update_snap (snap_data, x1, y1, _x1 - w + MIN_OVERLAP, top_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 1);
+          maybe_update_snap (snap_data, x1, y1, _x2 - MIN_OVERLAP, top_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, -1);
+
+          /* Left/right edge identical on the bottom */
+          maybe_update_snap (snap_data, x1, y1, _x1 - w + MIN_OVERLAP, bottom_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, 1);
+          maybe_update_snap (snap_data, x1, y1, _x2 - MIN_OVERLAP, bottom_snap_pos, SNAP_DIR_BOTH, SNAP_DIR_Y, -1);
+
+          /* Top/bottom edge identical on the left */
+          maybe_update_snap (snap_data, x1, y1, left_snap_pos, _y1 - h + MIN_OVERLAP, SNAP_DIR_BOTH, SNAP_DIR_X, 1);
+          maybe_update_snap (snap_data, x1, y1, left_snap_pos, _y2 - MIN_OVERLAP, SNAP_DIR_BOTH, SNAP_DIR_X, -1);
+
+          /* Top/bottom edge identical on the right */
+          maybe_update_snap (snap_data, x1, y1, right_snap_pos, _y1 - h + MIN_OVERLAP, SNAP_DIR_BOTH, SNAP_DIR_X, 1);
+          maybe_update_snap (snap_data, x1, y1, right_snap_pos, _y2 - MIN_OVERLAP, SNAP_DIR_BOTH, SNAP_DIR_X, -1);
+        }
+    }
+
+#undef OVERLAP
+}
+
+/**
+ * cc_display_layout_snap:
+ * @rects: the monitors, including the one being moved
+ * @n_rects: number of @rects
+ * @index: index of the monitor being moved, at its unsnapped position
+ * @distance_scale: factor from layout to on-screen distances, the snap
+ *   distances are in on-screen pixels
+ * @major_snap_distance: how far to snap along the major axis, %G_MAXUINT
+ *   to always snap to the closest edge
+ * @x: (out): the snapped position
+ * @y: (out): the snapped position
+ *
+ * Returns: whether the monitor snapped to anything at all
+ */
+gboolean
+cc_display_layout_snap (const CcDisplayLayoutRect *rects,
+                        guint                      n_rects,
+                        guint                      index,
+                        gdouble                    distance_scale,
+                        guint                      major_snap_distance,
+                        gint                      *x,
+                        gint                      *y)
+{
+  SnapData snap_data;
+
+  g_return_val_if_fail (index < n_rects, FALSE);
+
+  snap_data.snapped = SNAP_DIR_NONE;
+  snap_data.mon_x = rects[index].x;
+  snap_data.mon_y = rects[index].y;
+  snap_data.dist_x = 0;
+  snap_data.dist_y = 0;
+  snap_data.distance_scale = distance_scale;
+  snap_data.major_snap_distance = major_snap_distance;
+
+  find_best_snapping (rects, n_rects, index, &snap_data);
+
+  *x = snap_data.mon_x;
+  *y = snap_data.mon_y;
+
+  return snap_data.snapped != SNAP_DIR_NONE;
+}
+
+gboolean
+cc_display_layout_is_scale_allowed (const CcDisplayLayoutModeInfo *mode,
+                                    gdouble                        scale,
+                                    gint                           min_width,
+                                    gint                           min_height)
+{
+  gint width, height;
+  guint i;
+
+  for (i = 0; i < mode->n_supported_scales; i++)
+    if (mode->supported_scales[i] == scale)
+      break;
+
+  if (i == mode->n_supported_scales)
+    return FALSE;
+
+  /* Do the math as if the monitor is always in landscape mode. */
+  width = round (mode->width / scale);
+  height = round (mode->height / scale);
+
+  return (MAX (width, height) >= min_width &&
+          MIN (width, height) >= min_height);
+}
+
+/* For configurations with one scale for all monitors. */
+gboolean
+cc_display_layout_is_scale_allowed_by_all (const CcDisplayLayoutModeInfo *modes,
+                                           guint                          n_modes,
+                                           gdouble                        scale,
+                                           gint                           min_width,
+                                           gint                           min_height)
+{
+  guint i;
+
+  for (i = 0; i < n_modes; i++)
+    if (!cc_display_layout_is_scale_allowed (&modes[i], scale, min_width, min_height))
+      return FALSE;
+
+  return TRUE;
+}
@@ -0,0 +1,91 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * The layout rules of the display panel (what Muffin accepts, how monitors
+ * snap together, how a fresh layout is laid out) on plain arrays of
+ * rectangles, so they can be run on every edit and tested without a
+ * CcDisplayConfig or a D-Bus connection.
+ *
+ * Rectangles are in layout coordinates, i.e. logical pixels for logical
+ * layouts and already rotated.
+ */
+
+typedef struct _CcDisplayLayoutRect
+{
+  gint x;
+  gint y;
+  gint width;
+  gint height;
+} CcDisplayLayoutRect;
+
+typedef struct _CcDisplayLayoutModeInfo
+{
+  gint           width;
+  gint           height;
+  const gdouble *supported_scales;
+  guint          n_supported_scales;
+} CcDisplayLayoutModeInfo;
+
+typedef enum _CcDisplayLayoutResult
+{
+  CC_DISPLAY_LAYOUT_VALID,
+  CC_DISPLAY_LAYOUT_EMPTY,
+  CC_DISPLAY_LAYOUT_OVERLAPPING,
+  CC_DISPLAY_LAYOUT_DETACHED,
+} CcDisplayLayoutResult;
+
+gboolean              cc_display_layout_rects_overlap           (const CcDisplayLayoutRect     *a,
+                                                                 const CcDisplayLayoutRect     *b);
+gboolean              cc_display_layout_rects_adjacent          (const CcDisplayLayoutRect     *a,
+                                                                 const CcDisplayLayoutRect     *b);
+
+CcDisplayLayoutResult cc_display_layout_validate                (const CcDisplayLayoutRect     *rects,
+                                                                 guint                          n_rects,
+                                                                 guint                         *culprit);
+
+void                  cc_display_layout_normalize               (CcDisplayLayoutRect           *rects,
+                                                                 guint                          n_rects);
+void                  cc_display_layout_make_linear             (CcDisplayLayoutRect           *rects,
+                                                                 guint                          n_rects,
+                                                                 gint                           primary);
+
+gboolean              cc_display_layout_snap                    (const CcDisplayLayoutRect     *rects,
+                                                                 guint                          n_rects,
+                                                                 guint                          index,
+                                                                 gdouble                        distance_scale,
+                                                                 guint                          major_snap_distance,
+                                                                 gint                          *x,
+                                                                 gint                          *y);
+
+gboolean              cc_display_layout_is_scale_allowed        (const CcDisplayLayoutModeInfo *mode,
+                                                                 gdouble                        scale,
+                                                                 gint                           min_width,
+                                                                 gint                           min_height);
+gboolean              cc_display_layout_is_scale_allowed_by_all (const CcDisplayLayoutModeInfo *modes,
+                                                                 guint                          n_modes,
+                                                                 gdouble                        scale,
+                                                                 gint                           min_width,
+                                                                 gint                           min_height);
+
+G_END_DECLS
@@ -82,18 +82,29 @@ struct _CcDisplayPanel
   UpClient *up_client;
   gboolean lid_is_closed;
 
-  guint       sensor_watch_id;
-  GDBusProxy *iio_sensor_proxy;
-  gboolean    has_accelerometer;
+  guint         sensor_watch_id;
+  GCancellable *sensor_cancellable;
+  GDBusProxy   *iio_sensor_proxy;
+  gboolean      has_accelerometer;
 
   GtkBuilder *builder;
 
   GtkWidget *apply_button;
   GtkWidget *defaults_button;
   GtkWidget *cancel_button;
+  GtkWidget *save_layout_button;
+
+  GtkWidget *profile_infobar;
+  GtkWidget *profile_label;
+  GtkWidget *profile_apply_button;
+  /* Saved layout for the connected displays, if it isn't the applied one */
+  GVariant  *profile_layout;
 
   GtkListStore   *output_selection_list;
   GdkRGBA   *palette;
+  /* Colour swatches for the output list, by palette index */
+  GPtrArray *swatches;
+  gboolean   labels_dirty;
   gint n_outputs;
 
   GtkWidget *arrangement_frame;
@@ -109,6 +120,7 @@ struct _CcDisplayPanel
 
   GCancellable   *cancellable;
   GSettings      *muffin_settings;
+  GSettings      *display_settings;
 
   CcDisplayLabeler *labeler;
 };
@@ -124,6 +136,7 @@ CC_PANEL_REGISTER (CcDisplayPanel, cc_display_panel)
 static void update_bottom_buttons (CcDisplayPanel *panel);
 static void apply_current_configuration (CcDisplayPanel *self);
 static void reset_current_config (CcDisplayPanel *panel);
+static void update_profile_infobar (CcDisplayPanel *panel);
 static void rebuild_ui (CcDisplayPanel *panel);
 static void regenerate_palette (CcDisplayPanel *panel, gint n_outputs);
 static void set_current_output (CcDisplayPanel   *panel,
@@ -319,6 +332,8 @@ config_ensure_of_type (CcDisplayPanel *panel, CcDisplayConfigType type)
       g_assert_not_reached ();
     }
 
+  /* Mirroring or joining changes which outputs get a label */
+  panel->labels_dirty = TRUE;
   rebuild_ui (panel);
 }
 
@@ -452,15 +467,18 @@ show_labels (CcDisplayPanel *self)
       if (WAYLAND_SESSION ())
         return;
 
-      if (self->labeler) {
-        cc_display_labeler_hide (self->labeler);
-        g_object_unref (self->labeler);
-      }
-
-      self->labeler = cc_display_labeler_new (self->current_config);
+      /* The labeler keeps its windows around, only hand it the new config. */
+      if (self->labeler == NULL)
+        {
+          self->labeler = cc_display_labeler_new (self->current_config);
 
-      g_signal_connect_object (self->labeler, "get-output-color",
-                               G_CALLBACK (get_output_color), self, 0);
+          g_signal_connect_object (self->labeler, "get-output-color",
+                                   G_CALLBACK (get_output_color), self, 0);
+        }
+      else
+        {
+          cc_display_labeler_set_config (self->labeler, self->current_config);
+        }
 
       cc_display_labeler_show (self->labeler);
     }
@@ -489,12 +507,17 @@ cc_display_panel_dispose (GObject *object)
 {
   CcDisplayPanel *self = CC_DISPLAY_PANEL (object);
 
+  g_cancellable_cancel (self->cancellable);
+  g_clear_object (&self->cancellable);
+
   if (self->sensor_watch_id > 0)
     {
       g_bus_unwatch_name (self->sensor_watch_id);
       self->sensor_watch_id = 0;
     }
 
+  g_cancellable_cancel (self->sensor_cancellable);
+  g_clear_object (&self->sensor_cancellable);
   g_clear_object (&self->iio_sensor_proxy);
 
   g_clear_object (&self->manager);
@@ -503,8 +526,11 @@ cc_display_panel_dispose (GObject *object)
   g_clear_object (&self->cinnamon_proxy);
 
   g_clear_object (&self->muffin_settings);
+  g_clear_object (&self->display_settings);
+  g_clear_pointer (&self->profile_layout, g_variant_unref);
   g_clear_object (&self->labeler);
   g_clear_pointer (&self->palette, g_free);
+  g_clear_pointer (&self->swatches, g_ptr_array_unref);
 
   g_clear_object (&self->output_selection_list);
   g_clear_object (&self->builder);
@@ -587,7 +613,8 @@ on_output_enabled_active_changed_cb (CcDisplayPanel *panel)
         }
     }
 
-  /* Changing the active state requires a UI rebuild. */
+  /* Changing the active state requires a UI rebuild, and new labels. */
+  panel->labels_dirty = TRUE;
   rebuild_ui (panel);
 }
 
@@ -712,76 +739,165 @@ set_current_output (CcDisplayPanel   *panel,
   panel->rebuilding_counter--;
 }
 
-static void
-rebuild_ui (CcDisplayPanel *panel)
+static GdkPixbuf *
+get_output_swatch (CcDisplayPanel *panel,
+                   gint            index)
 {
-  guint n_outputs, n_active_outputs, n_usable_outputs;
-  GList *outputs, *l;
-  CcDisplayConfigType type;
-  gboolean cloned = FALSE;
-  gint index = 0;
+  g_autofree gchar *color_string = NULL;
+  GdkPixbuf *pixbuf;
+  GdkRGBA color;
+  guint32 pixel = 0;
 
-  panel->rebuilding_counter++;
+  if ((guint) index < panel->swatches->len && g_ptr_array_index (panel->swatches, index))
+    return g_ptr_array_index (panel->swatches, index);
 
-  gtk_list_store_clear (panel->output_selection_list);
+  /* Go through the string so the swatch matches the labels exactly */
+  color_string = get_color_string_for_output (panel, index);
+  gdk_rgba_parse (&color, color_string);
 
-  if (!panel->current_config)
-    {
-      panel->rebuilding_counter--;
-      return;
-    }
+  pixel = pixel + ((int) (color.red * 255) << 24);
+  pixel = pixel + ((int) (color.green * 255) << 16);
+  pixel = pixel + ((int) (color.blue * 255) << 8);
+  pixel = pixel + ((int) (color.alpha * 255));
 
-  cloned = config_get_current_type (panel);
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, 20, 20);
+  gdk_pixbuf_fill (pixbuf, pixel);
 
-  n_active_outputs = 0;
-  n_usable_outputs = 0;
-  outputs = cc_display_config_get_ui_sorted_monitors (panel->current_config);
+  if ((guint) index >= panel->swatches->len)
+    g_ptr_array_set_size (panel->swatches, index + 1);
+  g_ptr_array_index (panel->swatches, index) = pixbuf;
 
-  regenerate_palette (panel, g_list_length (outputs));
-  ensure_monitor_labels (panel);
+  return pixbuf;
+}
+
+/* Brings the output list in line with @outputs, keyed by connector, so
+ * that rows (and the combo's selection) survive a rebuild and only the
+ * columns which actually changed get set. */
+static void
+sync_output_selection_list (CcDisplayPanel *panel,
+                            GList          *outputs,
+                            gboolean        cloned)
+{
+  GtkTreeModel *model = GTK_TREE_MODEL (panel->output_selection_list);
+  g_autoptr(GHashTable) rows = NULL;
+  GHashTableIter hash_iter;
+  GtkTreeIter iter, prev;
+  GtkTreeIter *row;
+  gboolean valid;
+  GList *l;
+  gint index;
+
+  rows = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                g_free, (GDestroyNotify) gtk_tree_iter_free);
+
+  valid = gtk_tree_model_get_iter_first (model, &iter);
+  while (valid)
+    {
+      g_autoptr(CcDisplayMonitor) o = NULL;
+
+      gtk_tree_model_get (model, &iter, 1, &o, -1);
+      g_hash_table_insert (rows,
+                           g_strdup (cc_display_monitor_get_connector_name (o)),
+                           gtk_tree_iter_copy (&iter));
+
+      valid = gtk_tree_model_iter_next (model, &iter);
+    }
 
   for (l = outputs, index = 0; l; l = l->next, index++)
     {
-      GtkTreeIter iter;
       CcDisplayMonitor *output = l->data;
+      const gchar *connector = cc_display_monitor_get_connector_name (output);
+      g_autofree gchar *old_label = NULL;
+      g_autoptr(CcDisplayMonitor) old_output = NULL;
+      g_autoptr(GdkPixbuf) old_pixbuf = NULL;
       GdkPixbuf *pixbuf;
-      GdkRGBA color;
-      guint32 pixel = 0;
       const gchar *label;
 
-      pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, 20, 20);
+      if (cloned)
+        label = _("Mirrored Displays");
+      else
+        label = cc_display_monitor_get_ui_number_name (output);
 
-      gchar *color_string = get_color_string_for_output (panel, index);
+      pixbuf = get_output_swatch (panel, index);
 
-      gdk_rgba_parse (&color, color_string);
-      g_free (color_string);
+      row = g_hash_table_lookup (rows, connector);
+      if (row)
+        {
+          g_autoptr(GtkTreePath) path = NULL;
 
-      pixel = pixel + ((int) (color.red * 255) << 24);
-      pixel = pixel + ((int) (color.green * 255) << 16);
-      pixel = pixel + ((int) (color.blue * 255) << 8);
-      pixel = pixel + ((int) (color.alpha * 255));
+          iter = *row;
+          g_hash_table_remove (rows, connector);
 
+          path = gtk_tree_model_get_path (model, &iter);
+          if (gtk_tree_path_get_indices (path)[0] != index)
+            gtk_list_store_move_after (panel->output_selection_list, &iter,
+                                       index > 0 ? &prev : NULL);
 
-      if (cloned)
-        {
-          label = _("Mirrored Displays");
+          gtk_tree_model_get (model, &iter,
+                              0, &old_label,
+                              1, &old_output,
+                              2, &old_pixbuf,
+                              -1);
         }
       else
         {
-          label = cc_display_monitor_get_ui_number_name (output);
+          gtk_list_store_insert (panel->output_selection_list, &iter, index);
         }
 
-      gdk_pixbuf_fill (pixbuf, pixel);
+      if (g_strcmp0 (old_label, label) != 0)
+        gtk_list_store_set (panel->output_selection_list, &iter, 0, label, -1);
+      if (old_output != output)
+        gtk_list_store_set (panel->output_selection_list, &iter, 1, output, -1);
+      if (old_pixbuf != pixbuf)
+        gtk_list_store_set (panel->output_selection_list, &iter, 2, pixbuf, -1);
 
-      gtk_list_store_append (panel->output_selection_list, &iter);
-      gtk_list_store_set (panel->output_selection_list,
-                          &iter,
-                          0, label,
-                          1, output,
-                          2, pixbuf,
-                          -1);
+      prev = iter;
+    }
+
+  /* Whatever is left got unplugged */
+  g_hash_table_iter_init (&hash_iter, rows);
+  while (g_hash_table_iter_next (&hash_iter, NULL, (gpointer *) &row))
+    gtk_list_store_remove (panel->output_selection_list, row);
+}
+
+static void
+rebuild_ui (CcDisplayPanel *panel)
+{
+  guint n_outputs, n_active_outputs, n_usable_outputs;
+  GList *outputs, *l;
+  CcDisplayConfigType type;
+  gboolean cloned = FALSE;
+
+  panel->rebuilding_counter++;
+
+  if (!panel->current_config)
+    {
+      gtk_list_store_clear (panel->output_selection_list);
+      panel->rebuilding_counter--;
+      return;
+    }
+
+  cloned = config_get_current_type (panel);
 
-      g_object_unref (pixbuf);
+  n_active_outputs = 0;
+  n_usable_outputs = 0;
+  outputs = cc_display_config_get_ui_sorted_monitors (panel->current_config);
+
+  if (panel->palette == NULL || panel->n_outputs != (gint) g_list_length (outputs))
+    regenerate_palette (panel, g_list_length (outputs));
+
+  /* Labels follow the outputs that are shown, not every edit */
+  if (panel->labels_dirty)
+    {
+      panel->labels_dirty = FALSE;
+      ensure_monitor_labels (panel);
+    }
+
+  sync_output_selection_list (panel, outputs, cloned);
+
+  for (l = outputs; l; l = l->next)
+    {
+      CcDisplayMonitor *output = l->data;
 
       if (!cc_display_monitor_is_usable (output))
         continue;
@@ -857,8 +973,7 @@ reset_current_config (CcDisplayPanel *panel)
 
   cc_display_config_set_minimum_size (current, MINIMUM_WIDTH, MINIMUM_HEIGHT);
   panel->current_config = current;
-
-  gtk_list_store_clear (panel->output_selection_list);
+  panel->labels_dirty = TRUE;
 
   if (panel->current_config)
     {
@@ -880,6 +995,7 @@ reset_current_config (CcDisplayPanel *panel)
   g_clear_object (&old);
 
   update_bottom_buttons (panel);
+  update_profile_infobar (panel);
 }
 
 static void
@@ -921,6 +1037,68 @@ update_bottom_buttons (CcDisplayPanel *panel)
       gtk_widget_set_sensitive (panel->apply_button, cc_display_config_is_applicable (panel->current_config));
       gtk_widget_set_sensitive (panel->cancel_button, TRUE);
     }
+
+  /* Only what has been applied can be saved */
+  gtk_widget_set_sensitive (panel->save_layout_button, config_equal);
+}
+
+static GVariant *
+lookup_layout_profile (CcDisplayPanel *panel,
+                       const gchar    *key,
+                       gchar         **name)
+{
+  g_autoptr(GVariant) profiles = NULL;
+  g_autoptr(GVariant) profile = NULL;
+  GVariant *layout;
+
+  profiles = g_settings_get_value (panel->display_settings, "layout-profiles");
+  profile = g_variant_lookup_value (profiles, key, G_VARIANT_TYPE ("(sv)"));
+  if (!profile)
+    return NULL;
+
+  g_variant_get (profile, "(sv)", name, &layout);
+
+  return layout;
+}
+
+static void
+update_profile_infobar (CcDisplayPanel *panel)
+{
+  g_autoptr(GVariant) layout = NULL;
+  g_autoptr(GVariant) current_layout = NULL;
+  g_autofree gchar *name = NULL;
+  g_autofree gchar *text = NULL;
+  const gchar *key;
+
+  g_clear_pointer (&panel->profile_layout, g_variant_unref);
+  gtk_widget_hide (panel->profile_infobar);
+
+  if (!panel->current_config)
+    return;
+
+  key = cc_display_config_get_monitors_key (panel->current_config);
+  if (!key)
+    return;
+
+  layout = lookup_layout_profile (panel, key, &name);
+  if (!layout)
+    return;
+
+  /* Nothing to offer if Muffin already restored it */
+  current_layout = cc_display_config_get_layout (panel->current_config);
+  if (current_layout && g_variant_equal (layout, current_layout))
+    return;
+
+  g_debug ("Found saved layout '%s' for displays %s", name, key);
+
+  panel->profile_layout = g_steal_pointer (&layout);
+
+  text = g_strdup_printf (_("A saved layout, “%s”, exists for these displays."), name);
+  gtk_label_set_text (GTK_LABEL (panel->profile_label), text);
+  gtk_info_bar_set_message_type (GTK_INFO_BAR (panel->profile_infobar), GTK_MESSAGE_QUESTION);
+  gtk_widget_show (panel->profile_apply_button);
+  gtk_widget_set_sensitive (panel->profile_apply_button, TRUE);
+  gtk_widget_show (panel->profile_infobar);
 }
 
 static void
@@ -996,6 +1174,35 @@ sensor_proxy_properties_changed_cb (GDBusProxy     *proxy,
     update_has_accel (self);
 }
 
+static void
+sensor_proxy_ready (GObject      *source_object,
+                    GAsyncResult *res,
+                    gpointer      user_data)
+{
+  CcDisplayPanel *self;
+  GDBusProxy *proxy;
+  g_autoptr(GError) error = NULL;
+
+  proxy = g_dbus_proxy_new_finish (res, &error);
+  if (!proxy)
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          g_warning ("Failed to connect to SensorProxy: %s", error->message);
+          g_clear_object (&CC_DISPLAY_PANEL (user_data)->sensor_cancellable);
+        }
+      return;
+    }
+
+  self = CC_DISPLAY_PANEL (user_data);
+  g_clear_object (&self->sensor_cancellable);
+
+  self->iio_sensor_proxy = proxy;
+  g_signal_connect (self->iio_sensor_proxy, "g-properties-changed",
+                    G_CALLBACK (sensor_proxy_properties_changed_cb), self);
+  update_has_accel (self);
+}
+
 static void
 sensor_proxy_appeared_cb (GDBusConnection *connection,
                           const gchar     *name,
@@ -1006,19 +1213,21 @@ sensor_proxy_appeared_cb (GDBusConnection *connection,
 
   g_debug ("SensorProxy appeared");
 
-  self->iio_sensor_proxy = g_dbus_proxy_new_sync (connection,
-                                                        G_DBUS_PROXY_FLAGS_NONE,
-                                                        NULL,
-                                                        "net.hadess.SensorProxy",
-                                                        "/net/hadess/SensorProxy",
-                                                        "net.hadess.SensorProxy",
-                                                        NULL,
-                                                        NULL);
-  g_return_if_fail (self->iio_sensor_proxy);
+  /* iio-sensor-proxy can take its time to answer the initial property
+   * fetch on tablets, don't hold up the panel for it. */
+  g_cancellable_cancel (self->sensor_cancellable);
+  g_clear_object (&self->sensor_cancellable);
+  self->sensor_cancellable = g_cancellable_new ();
 
-  g_signal_connect (self->iio_sensor_proxy, "g-properties-changed",
-                    G_CALLBACK (sensor_proxy_properties_changed_cb), self);
-  update_has_accel (self);
+  g_dbus_proxy_new (connection,
+                    G_DBUS_PROXY_FLAGS_NONE,
+                    NULL,
+                    "net.hadess.SensorProxy",
+                    "/net/hadess/SensorProxy",
+                    "net.hadess.SensorProxy",
+                    self->sensor_cancellable,
+                    sensor_proxy_ready,
+                    self);
 }
 
 static void
@@ -1030,6 +1239,8 @@ sensor_proxy_vanished_cb (GDBusConnection *connection,
 
   g_debug ("SensorProxy vanished");
 
+  g_cancellable_cancel (self->sensor_cancellable);
+  g_clear_object (&self->sensor_cancellable);
   g_clear_object (&self->iio_sensor_proxy);
   update_has_accel (self);
 }
@@ -1039,20 +1250,30 @@ cinnamon_proxy_ready (GObject *source_object,
                       GAsyncResult *res,
                       gpointer user_data)
 {
-    CcDisplayPanel *self = CC_DISPLAY_PANEL (user_data);
+    CcDisplayPanel *self;
+    GDBusProxy *proxy;
     GError *error = NULL;
 
-    self->cinnamon_proxy = g_dbus_proxy_new_finish (res, &error);
+    proxy = g_dbus_proxy_new_finish (res, &error);
 
-    if (self->cinnamon_proxy == NULL)
+    if (proxy == NULL)
       {
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            g_clear_error (&error);
+            return;
+        }
+
         if (WAYLAND_SESSION ()) {
             g_critical ("Can't connect to Cinnamon, monitor labels will not be shown: %s", error->message);
         } else {
             g_critical ("Can't connect to Cinnamon, using x11 monitor labeler: %s", error->message);
         }
         g_clear_error (&error);
+        return;
       }
+
+    self = CC_DISPLAY_PANEL (user_data);
+    self->cinnamon_proxy = proxy;
 }
 
 static void
@@ -1060,7 +1281,7 @@ session_bus_ready (GObject        *source,
                    GAsyncResult   *res,
                    CcDisplayPanel *self)
 {
-  GDBusConnection *bus;
+  g_autoptr(GDBusConnection) bus = NULL;
   g_autoptr(GError) error = NULL;
 
   bus = g_bus_get_finish (res, &error);
@@ -1087,7 +1308,7 @@ session_bus_ready (GObject        *source,
                     "org.Cinnamon",
                     "/org/Cinnamon",
                     "org.Cinnamon",
-                    NULL,
+                    self->cancellable,
                     (GAsyncReadyCallback) cinnamon_proxy_ready,
                     self);
 }
@@ -1112,6 +1333,104 @@ cancel_button_clicked_cb (GtkWidget *widget,
     on_screen_changed (CC_DISPLAY_PANEL (user_data));
 }
 
+static void
+save_layout_button_clicked_cb (GtkWidget *widget,
+                               gpointer   user_data)
+{
+  CcDisplayPanel *self = CC_DISPLAY_PANEL (user_data);
+  g_autoptr(CcDisplayConfig) applied_config = NULL;
+  g_autoptr(GVariant) layout = NULL;
+  g_autoptr(GVariant) profiles = NULL;
+  g_autoptr(GPtrArray) names = NULL;
+  g_autofree gchar *name = NULL;
+  GVariantBuilder builder;
+  GVariantIter iter;
+  const gchar *key;
+  const gchar *profile_key;
+  GVariant *profile;
+  GList *l;
+
+  applied_config = cc_display_config_manager_get_current (self->manager);
+  if (!applied_config)
+    return;
+
+  key = cc_display_config_get_monitors_key (applied_config);
+  layout = cc_display_config_get_layout (applied_config);
+  if (!key || !layout)
+    return;
+
+  names = g_ptr_array_new ();
+  for (l = cc_display_config_get_ui_sorted_monitors (applied_config); l; l = l->next)
+    g_ptr_array_add (names, (gpointer) cc_display_monitor_get_display_name (l->data));
+  g_ptr_array_add (names, NULL);
+  name = g_strjoinv (" + ", (gchar **) names->pdata);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{s(sv)}"));
+
+  profiles = g_settings_get_value (self->display_settings, "layout-profiles");
+  g_variant_iter_init (&iter, profiles);
+  while (g_variant_iter_loop (&iter, "{&s@(sv)}", &profile_key, &profile))
+    {
+      if (!g_str_equal (profile_key, key))
+        g_variant_builder_add (&builder, "{s@(sv)}", profile_key, profile);
+    }
+
+  g_variant_builder_add (&builder, "{s(sv)}", key, name, layout);
+
+  g_debug ("Saving layout '%s' for displays %s", name, key);
+
+  /* changed::layout-profiles takes care of the info bar */
+  g_settings_set_value (self->display_settings, "layout-profiles",
+                        g_variant_builder_end (&builder));
+}
+
+static void
+profile_applied_cb (GObject      *source,
+                    GAsyncResult *res,
+                    gpointer      user_data)
+{
+  CcDisplayPanel *self;
+  g_autoptr(GError) error = NULL;
+
+  if (!cc_display_config_apply_layout_finish (CC_DISPLAY_CONFIG (source), res, &error))
+    {
+      if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        return;
+
+      self = CC_DISPLAY_PANEL (user_data);
+
+      g_warning ("Error applying saved layout: %s", error->message);
+
+      gtk_label_set_text (GTK_LABEL (self->profile_label),
+                          _("The saved layout could not be applied to these displays."));
+      gtk_info_bar_set_message_type (GTK_INFO_BAR (self->profile_infobar), GTK_MESSAGE_WARNING);
+      gtk_widget_hide (self->profile_apply_button);
+      return;
+    }
+
+  /* MonitorsChanged will bring in the new layout */
+  self = CC_DISPLAY_PANEL (user_data);
+  gtk_widget_hide (self->profile_infobar);
+}
+
+static void
+profile_apply_button_clicked_cb (GtkWidget *widget,
+                                 gpointer   user_data)
+{
+  CcDisplayPanel *self = CC_DISPLAY_PANEL (user_data);
+
+  if (!self->current_config || !self->profile_layout)
+    return;
+
+  gtk_widget_set_sensitive (self->profile_apply_button, FALSE);
+
+  cc_display_config_apply_layout_async (self->current_config,
+                                        self->profile_layout,
+                                        self->cancellable,
+                                        profile_applied_cb,
+                                        self);
+}
+
 static void
 config_file_deleted (GObject *xml,
                      GAsyncResult *res,
@@ -1210,6 +1529,7 @@ regenerate_palette (CcDisplayPanel *panel, gint n_outputs)
 
     g_clear_pointer (&panel->palette, g_free);
     panel->palette = g_new (GdkRGBA, n_outputs);
+    g_ptr_array_set_size (panel->swatches, 0);
 
     start_hue = 0.0; /* red */
     end_hue   = 2.0/3; /* blue */
@@ -1275,6 +1595,10 @@ cc_display_panel_init (CcDisplayPanel *self)
   self->apply_button = WID ("apply_button");
   self->cancel_button = WID ("cancel_button");
   self->defaults_button = WID ("defaults_button");
+  self->save_layout_button = WID ("save_layout_button");
+  self->profile_infobar = WID ("profile_infobar");
+  self->profile_label = WID ("profile_label");
+  self->profile_apply_button = WID ("profile_apply_button");
 
   gtk_builder_add_callback_symbol (self->builder, "on_config_type_toggled_cb", G_CALLBACK (on_config_type_toggled_cb));
   gtk_builder_add_callback_symbol (self->builder, "on_output_enabled_active_changed_cb", G_CALLBACK (on_output_enabled_active_changed_cb));
@@ -1283,12 +1607,17 @@ cc_display_panel_init (CcDisplayPanel *self)
   gtk_builder_add_callback_symbol (self->builder, "apply_button_clicked_cb", G_CALLBACK (apply_button_clicked_cb));
   gtk_builder_add_callback_symbol (self->builder, "cancel_button_clicked_cb", G_CALLBACK (cancel_button_clicked_cb));
   gtk_builder_add_callback_symbol (self->builder, "defaults_button_clicked_cb", G_CALLBACK (defaults_button_clicked_cb));
+  gtk_builder_add_callback_symbol (self->builder, "save_layout_button_clicked_cb", G_CALLBACK (save_layout_button_clicked_cb));
+  gtk_builder_add_callback_symbol (self->builder, "profile_apply_button_clicked_cb", G_CALLBACK (profile_apply_button_clicked_cb));
 
   gtk_builder_connect_signals (self->builder, self);
 
   self->muffin_settings = g_settings_new ("org.cinnamon.muffin");
   g_signal_connect_swapped (self->muffin_settings, "changed::experimental-features", G_CALLBACK (experimental_features_changed), self);
 
+  self->display_settings = g_settings_new ("org.cinnamon.control-center.display");
+  g_signal_connect_swapped (self->display_settings, "changed::layout-profiles", G_CALLBACK (update_profile_infobar), self);
+
   self->arrangement = cc_display_arrangement_new (NULL);
 
   gtk_widget_show (GTK_WIDGET (self->arrangement));
@@ -1312,6 +1641,7 @@ cc_display_panel_init (CcDisplayPanel *self)
                            G_CONNECT_SWAPPED);
 
   self->output_selection_list = gtk_list_store_new (3, G_TYPE_STRING, CC_TYPE_DISPLAY_MONITOR, GDK_TYPE_PIXBUF);
+  self->swatches = g_ptr_array_new_with_free_func (g_object_unref);
   gtk_combo_box_set_model (GTK_COMBO_BOX (self->output_selection_combo), GTK_TREE_MODEL (self->output_selection_list));
   gtk_cell_layout_clear (GTK_CELL_LAYOUT (self->output_selection_combo));
 
@@ -43,6 +43,12 @@ struct _CcDisplaySettings
   GtkListStore     *refresh_rate_list;
   GtkListStore     *resolution_list;
 
+  /* Sorted unique resolutions, reused until the output or its mode changes */
+  GList            *resolution_modes;
+  CcDisplayMonitor *resolution_modes_output;
+  CcDisplayMode    *resolution_modes_current;
+  gboolean          resolution_modes_cloning;
+
   GtkBuilder       *builder;
 
   GtkWidget        *orientation_combo;
@@ -69,6 +75,10 @@ enum {
 
 G_DEFINE_TYPE (CcDisplaySettings, cc_display_settings, GTK_TYPE_BIN)
 
+/* Formatted strings are attached to the (immutable) mode objects */
+G_DEFINE_QUARK (cc-display-settings-resolution-string, resolution_string)
+G_DEFINE_QUARK (cc-display-settings-frequency-string, frequency_string)
+
 static GParamSpec *props[PROP_LAST];
 
 static void on_scale_btn_active_changed_cb (GtkWidget         *widget,
@@ -184,10 +194,34 @@ make_resolution_string (CcDisplayMode *mode)
     return g_strdup_printf ("%d × %d%s", width, height, interlaced);
 }
 
-static gchar *
+static const gchar *
+get_resolution_string (CcDisplayMode *mode)
+{
+  gchar *str;
+
+  str = g_object_get_qdata (G_OBJECT (mode), resolution_string_quark ());
+  if (str == NULL)
+    {
+      str = make_resolution_string (mode);
+      g_object_set_qdata_full (G_OBJECT (mode), resolution_string_quark (), str, g_free);
+    }
+
+  return str;
+}
+
+static const gchar *
 get_frequency_string (CcDisplayMode *mode)
 {
-  return g_strdup_printf (_("%.2lf Hz"), cc_display_mode_get_freq_f (mode));
+  gchar *str;
+
+  str = g_object_get_qdata (G_OBJECT (mode), frequency_string_quark ());
+  if (str == NULL)
+    {
+      str = g_strdup_printf (_("%.2lf Hz"), cc_display_mode_get_freq_f (mode));
+      g_object_set_qdata_full (G_OBJECT (mode), frequency_string_quark (), str, g_free);
+    }
+
+  return str;
 }
 
 static double
@@ -219,16 +253,171 @@ sort_modes_by_area_desc (CcDisplayMode *a, CcDisplayMode *b)
   return res;
 }
 
+/* Bring a mode list store in line with @modes, only touching rows whose
+ * mode differs from the one already at that position. */
+static void
+sync_mode_list (GtkListStore  *list,
+                GtkComboBox   *combo,
+                GList         *modes,
+                CcDisplayMode *active_mode,
+                const gchar * (*get_string) (CcDisplayMode *mode))
+{
+  GtkTreeModel *model = GTK_TREE_MODEL (list);
+  GtkTreeIter iter;
+  gboolean valid;
+  GList *l;
+
+  valid = gtk_tree_model_get_iter_first (model, &iter);
+
+  for (l = modes; l != NULL; l = l->next)
+    {
+      CcDisplayMode *mode = CC_DISPLAY_MODE (l->data);
+
+      if (valid)
+        {
+          g_autoptr(CcDisplayMode) row_mode = NULL;
+
+          gtk_tree_model_get (model, &iter, 1, &row_mode, -1);
+
+          if (row_mode != mode)
+            gtk_list_store_set (list, &iter,
+                                0, get_string (mode),
+                                1, mode,
+                                -1);
+        }
+      else
+        {
+          gtk_list_store_insert_with_values (list, &iter, -1,
+                                             0, get_string (mode),
+                                             1, mode,
+                                             -1);
+        }
+
+      if (mode == active_mode)
+        gtk_combo_box_set_active_iter (combo, &iter);
+
+      valid = gtk_tree_model_iter_next (model, &iter);
+    }
+
+  while (valid)
+    valid = gtk_list_store_remove (list, &iter);
+}
+
+static void
+clear_resolution_modes (CcDisplaySettings *self)
+{
+  g_clear_pointer (&self->resolution_modes, g_list_free);
+  self->resolution_modes_output = NULL;
+  self->resolution_modes_current = NULL;
+}
+
+static GList *
+get_resolution_modes (CcDisplaySettings *self,
+                      CcDisplayMode     *current_mode)
+{
+  GList *modes;
+  GList *item;
+  GList *unique_resolutions;
+  GList *l;
+  gboolean cloning;
+
+  cloning = cc_display_config_is_cloning (self->config);
+
+  if (self->resolution_modes != NULL &&
+      self->resolution_modes_output == self->selected_output &&
+      self->resolution_modes_current == current_mode &&
+      self->resolution_modes_cloning == cloning)
+    return self->resolution_modes;
+
+  clear_resolution_modes (self);
+
+  if (cloning)
+    modes = g_list_copy (cc_display_config_get_cloning_modes (self->config));
+  else
+    modes = g_list_copy (cc_display_monitor_get_modes (self->selected_output));
+
+  modes = g_list_reverse (modes);
+  unique_resolutions = g_list_prepend (NULL, current_mode);
+
+  for (item = modes; item != NULL; item = item->next)
+    {
+      CcDisplayMode *mode = CC_DISPLAY_MODE (item->data);
+
+      /* Exclude unusable low resolutions */
+      if (!cc_display_config_is_scaled_mode_valid (self->config, mode, 1.0))
+        continue;
+
+      gint ins = 0;
+
+      for (l = unique_resolutions; l != NULL; l = l->next, ins++)
+        {
+          CcDisplayMode *m = l->data;
+          gint cmp;
+
+          cmp = sort_modes_by_area_desc (mode, m);
+
+          if (cmp < 0)
+            break;
+
+          /* Don't insert if it is already in the list */
+          if (cmp == 0)
+            {
+              ins = -1;
+              break;
+            }
+
+        }
+
+      if (ins >= 0)
+        {
+          unique_resolutions = g_list_insert (unique_resolutions, mode, ins);
+        }
+    }
+
+  g_list_free (modes);
+
+  self->resolution_modes = unique_resolutions;
+  self->resolution_modes_output = self->selected_output;
+  self->resolution_modes_current = current_mode;
+  self->resolution_modes_cloning = cloning;
+
+  return self->resolution_modes;
+}
+
+static gboolean
+scale_buttons_match (CcDisplaySettings *self,
+                     const gdouble     *scales,
+                     gint               n_scales)
+{
+  g_autoptr(GList) children = NULL;
+  GList *l;
+  gint i;
+
+  children = gtk_container_get_children (GTK_CONTAINER (self->scale_bbox));
+  if (g_list_length (children) != (guint) n_scales)
+    return FALSE;
+
+  for (l = children, i = 0; l != NULL; l = l->next, i++)
+    {
+      gdouble *scale = g_object_get_data (G_OBJECT (l->data), "scale");
+
+      if (scale == NULL || *scale != scales[i])
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 static gboolean
 cc_display_settings_rebuild_ui (CcDisplaySettings *self)
 {
   GList *modes;
-  GList *item;
   gint width, height;
   CcDisplayMode *current_mode;
   GtkRadioButton *group = NULL;
   gint buttons = 0;
   const gdouble *scales, *scale;
+  gdouble shown_scales[MAX_SCALE_BUTTONS];
 
   self->idle_udpate_id = 0;
 
@@ -300,16 +489,13 @@ cc_display_settings_rebuild_ui (CcDisplaySettings *self)
   if (!cc_display_config_is_cloning (self->config))
     {
       GList *item;
+      GList *rates = NULL;
+      CcDisplayMode *active_rate = NULL;
       gdouble freq;
 
       freq = cc_display_mode_get_freq_f (current_mode);
 
-      modes = g_list_copy (cc_display_monitor_get_modes (self->selected_output));
-      modes = g_list_reverse (modes);
-
-      gtk_list_store_clear (self->refresh_rate_list);
-
-      for (item = modes; item != NULL; item = item->next)
+      for (item = cc_display_monitor_get_modes (self->selected_output); item != NULL; item = item->next)
         {
           gint w, h;
           CcDisplayMode *mode = CC_DISPLAY_MODE (item->data);
@@ -318,27 +504,22 @@ cc_display_settings_rebuild_ui (CcDisplaySettings *self)
           if (w != width || h != height)
             continue;
 
-          GtkTreeIter iter;
-
-          gtk_list_store_append (self->refresh_rate_list, &iter);
-
-          gchar *rate_string = get_frequency_string (mode);
-
-          gtk_list_store_set (self->refresh_rate_list,
-                              &iter,
-                              0, rate_string,
-                              1, mode,
-                              -1);
+          rates = g_list_prepend (rates, mode);
 
-          g_free (rate_string);
           /* At some point we used to filter very close resolutions,
            * but we don't anymore these days.
            */
-          if (freq == cc_display_mode_get_freq_f (mode))
-            gtk_combo_box_set_active_iter (GTK_COMBO_BOX (self->refresh_rate_combo), &iter);
+          if (active_rate == NULL && freq == cc_display_mode_get_freq_f (mode))
+            active_rate = mode;
         }
 
-      g_list_free (modes);
+      sync_mode_list (self->refresh_rate_list,
+                      GTK_COMBO_BOX (self->refresh_rate_combo),
+                      rates,
+                      active_rate,
+                      get_frequency_string);
+
+      g_list_free (rates);
 
       /* Show if we have more than one frequency to choose from. */
       gtk_widget_set_sensitive (self->refresh_rate_combo,
@@ -349,120 +530,75 @@ cc_display_settings_rebuild_ui (CcDisplaySettings *self)
       gtk_widget_set_sensitive (self->refresh_rate_combo, FALSE);
     }
 
-  if (cc_display_config_is_cloning (self->config))
-    modes = g_list_copy (cc_display_config_get_cloning_modes (self->config));
-  else
-    modes = g_list_copy (cc_display_monitor_get_modes (self->selected_output));
-
-  gtk_list_store_clear (self->resolution_list);
+  sync_mode_list (self->resolution_list,
+                  GTK_COMBO_BOX (self->resolution_combo),
+                  get_resolution_modes (self, current_mode),
+                  current_mode,
+                  get_resolution_string);
 
-  modes = g_list_reverse (modes);
-  GList *unique_resolutions = g_list_prepend (NULL, current_mode);
-  GList *l;
+  gtk_widget_set_sensitive (self->resolution_combo,
+                            gtk_tree_model_iter_n_children (GTK_TREE_MODEL (self->resolution_list), NULL) > 1);
 
-  for (item = modes; item != NULL; item = item->next)
+  /* Scale row is usually shown. */
+  scales = cc_display_mode_get_supported_scales (current_mode);
+  for (scale = scales; *scale != 0.0 && buttons < MAX_SCALE_BUTTONS; scale++)
     {
-      gint w, h;
-      CcDisplayMode *mode = CC_DISPLAY_MODE (item->data);
-
-      /* Exclude unusable low resolutions */
-      if (!cc_display_config_is_scaled_mode_valid (self->config, mode, 1.0))
+      if (!cc_display_config_is_scaled_mode_valid (self->config,
+                                                   current_mode,
+                                                   *scale) &&
+          cc_display_monitor_get_scale (self->selected_output) != *scale)
         continue;
 
-      cc_display_mode_get_resolution (mode, &w, &h);
+      shown_scales[buttons++] = *scale;
+    }
 
-      gint ins = 0;
+  if (scale_buttons_match (self, shown_scales, buttons))
+    {
+      g_autoptr(GList) children = NULL;
+      GList *l;
 
-      for (l = unique_resolutions; l != NULL; l = l->next, ins++)
+      /* Same set of scales, only the selection may have changed. */
+      children = gtk_container_get_children (GTK_CONTAINER (self->scale_bbox));
+      for (l = children; l != NULL; l = l->next)
         {
-          CcDisplayMode *m = l->data;
-          gint cmp;
-
-          cmp = sort_modes_by_area_desc (mode, m);
-
-          if (cmp < 0)
-            break;
-
-          /* Don't insert if it is already in the list */
-          if (cmp == 0)
-            {
-              ins = -1;
-              break;
-            }
+          gdouble *btn_scale = g_object_get_data (G_OBJECT (l->data), "scale");
 
-        }
-
-      if (ins >= 0)
-        {
-          unique_resolutions = g_list_insert (unique_resolutions, mode, ins);
+          if (cc_display_monitor_get_scale (self->selected_output) == *btn_scale)
+            gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (l->data), TRUE);
         }
     }
-
-  g_list_free (modes);
-
-  for (l = unique_resolutions; l != NULL; l = l->next)
+  else
     {
-      GtkTreeIter iter;
-      gchar *resolution_string;
-
-      gtk_list_store_append (self->resolution_list, &iter);
-      resolution_string = make_resolution_string (l->data);
-
-      gtk_list_store_set (self->resolution_list,
-                          &iter,
-                          0, resolution_string,
-                          1, l->data,
-                          -1);
+      gint i;
 
-      g_free (resolution_string);
+      gtk_container_foreach (GTK_CONTAINER (self->scale_bbox), (GtkCallback) gtk_widget_destroy, NULL);
 
-      if (current_mode == l->data)
+      for (i = 0; i < buttons; i++)
         {
-           gtk_combo_box_set_active_iter (GTK_COMBO_BOX (self->resolution_combo), &iter);
+          g_autofree gchar *scale_str = NULL;
+          GtkWidget *scale_btn;
+
+          scale_str = make_scale_string (shown_scales[i]);
+
+          scale_btn = gtk_radio_button_new_with_label_from_widget (group, scale_str);
+          if (!group)
+            group = GTK_RADIO_BUTTON (scale_btn);
+          gtk_toggle_button_set_mode (GTK_TOGGLE_BUTTON (scale_btn), FALSE);
+          g_object_set_data_full (G_OBJECT (scale_btn),
+                                  "scale",
+                                  g_memdup (&shown_scales[i], sizeof (gdouble)),
+                                  g_free);
+          gtk_widget_show (scale_btn);
+          gtk_container_add (GTK_CONTAINER (self->scale_bbox), scale_btn);
+          g_signal_connect_object (scale_btn,
+                                   "notify::active",
+                                   G_CALLBACK (on_scale_btn_active_changed_cb),
+                                   self, 0);
+
+          if (cc_display_monitor_get_scale (self->selected_output) == shown_scales[i])
+            gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (scale_btn), TRUE);
         }
     }
-  gtk_widget_set_sensitive (self->resolution_combo,
-                            gtk_tree_model_iter_n_children (GTK_TREE_MODEL (self->resolution_list), NULL) > 1);
-  g_list_free (unique_resolutions);
-
-  /* Scale row is usually shown. */
-  gtk_container_foreach (GTK_CONTAINER (self->scale_bbox), (GtkCallback) gtk_widget_destroy, NULL);
-  scales = cc_display_mode_get_supported_scales (current_mode);
-  for (scale = scales; *scale != 0.0; scale++)
-    {
-      g_autofree gchar *scale_str = NULL;
-      GtkWidget *scale_btn;
-
-      if (!cc_display_config_is_scaled_mode_valid (self->config,
-                                                   current_mode,
-                                                   *scale) &&
-          cc_display_monitor_get_scale (self->selected_output) != *scale)
-        continue;
-
-      scale_str = make_scale_string (*scale);
-
-      scale_btn = gtk_radio_button_new_with_label_from_widget (group, scale_str);
-      if (!group)
-        group = GTK_RADIO_BUTTON (scale_btn);
-      gtk_toggle_button_set_mode (GTK_TOGGLE_BUTTON (scale_btn), FALSE);
-      g_object_set_data_full (G_OBJECT (scale_btn),
-                              "scale",
-                              g_memdup (scale, sizeof (gdouble)),
-                              g_free);
-      gtk_widget_show (scale_btn);
-      gtk_container_add (GTK_CONTAINER (self->scale_bbox), scale_btn);
-      g_signal_connect_object (scale_btn,
-                               "notify::active",
-                               G_CALLBACK (on_scale_btn_active_changed_cb),
-                               self, 0);
-
-      if (cc_display_monitor_get_scale (self->selected_output) == *scale)
-        gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (scale_btn), TRUE);
-
-      buttons += 1;
-      if (buttons >= MAX_SCALE_BUTTONS)
-        break;
-    }
 
   gtk_widget_set_sensitive (self->scale_row, buttons > 1);
 
@@ -505,6 +641,13 @@ on_output_changed_cb (CcDisplaySettings *self,
   self->idle_udpate_id = g_idle_add ((GSourceFunc) cc_display_settings_rebuild_ui, self);
 }
 
+static void
+on_output_active_changed_cb (CcDisplaySettings *self)
+{
+  /* Which resolutions are usable depends on the set of active outputs. */
+  clear_resolution_modes (self);
+}
+
 static void
 on_orientation_selection_changed_cb (GtkComboBox       *box,
                                      GParamSpec        *pspec,
@@ -676,6 +819,7 @@ cc_display_settings_finalize (GObject *object)
   CcDisplaySettings *self = CC_DISPLAY_SETTINGS (object);
 
   g_clear_object (&self->config);
+  clear_resolution_modes (self);
 
   g_clear_object (&self->orientation_list);
   g_clear_object (&self->refresh_rate_list);
@@ -842,6 +986,7 @@ cc_display_settings_set_config (CcDisplaySettings *self,
         }
     }
   g_clear_object (&self->config);
+  clear_resolution_modes (self);
 
   self->config = g_object_ref (config);
 
@@ -853,6 +998,7 @@ cc_display_settings_set_config (CcDisplaySettings *self,
         {
           CcDisplayMonitor *output = l->data;
 
+          g_signal_connect_object (output, "active", G_CALLBACK (on_output_active_changed_cb), self, G_CONNECT_SWAPPED);
           for (i = 0; i < G_N_ELEMENTS (signals); ++i)
             g_signal_connect_object (output, signals[i], G_CALLBACK (on_output_changed_cb), self, G_CONNECT_SWAPPED);
         }
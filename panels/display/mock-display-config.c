@@ -0,0 +1,1076 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "config.h"
+
+#include "mock-display-config.h"
+#include "muffin-display-config.h"
+
+#define METHOD_VERIFY 0
+
+typedef struct
+{
+  gchar   *id;
+  gint     width;
+  gint     height;
+  gdouble  refresh;
+} MockMode;
+
+typedef struct
+{
+  gchar    *connector;
+  gchar    *vendor;
+  gchar    *product;
+  gchar    *serial;
+  gchar    *display_name;
+  gboolean  builtin;
+  gint      width_mm;
+  gint      height_mm;
+
+  /* The preferred mode comes first */
+  GArray   *modes;
+  guint     current_mode;
+
+  gboolean  active;
+  gint      x;
+  gint      y;
+  gdouble   scale;
+  guint     rotation;
+  gboolean  primary;
+} MockMonitor;
+
+struct _MockDisplayConfig
+{
+  GObject parent_instance;
+
+  MetaDBusDisplayConfig *skeleton;
+
+  gint serial;
+  GArray *monitors;
+
+  gint n_get_current_state;
+  gint n_apply;
+
+  /* Only set when running in a thread of its own, see
+   * mock_display_config_start() */
+  GDBusConnection *connection;
+  GMainContext *context;
+  GMainLoop *loop;
+  GThread *thread;
+  GMutex lock;
+  GCond cond;
+};
+
+G_DEFINE_TYPE (MockDisplayConfig, mock_display_config, G_TYPE_OBJECT)
+
+/* Canned layouts, synthesized by load_layout(); the larger walls are a
+ * grid of one kind of monitor, see add_grid(). */
+static const gchar * const layouts[] = {
+  "laptop",
+  "dual",
+  "triple",
+  "triple-swapped",
+  "8-way",
+  "24-way",
+  NULL
+};
+
+static const struct
+{
+  gint width;
+  gint height;
+} common_sizes[] = {
+  { 3840, 2160 },
+  { 2560, 1600 },
+  { 2560, 1440 },
+  { 1920, 1200 },
+  { 1920, 1080 },
+  { 1680, 1050 },
+  { 1280, 1024 },
+  { 1280,  720 },
+  { 1024,  768 },
+  {  800,  600 },
+};
+
+static const gdouble supported_scales[] = { 1.0, 1.25, 1.5, 1.75, 2.0 };
+
+static void
+clear_mode (MockMode *mode)
+{
+  g_free (mode->id);
+}
+
+static void
+clear_monitor (MockMonitor *monitor)
+{
+  g_free (monitor->connector);
+  g_free (monitor->vendor);
+  g_free (monitor->product);
+  g_free (monitor->serial);
+  g_free (monitor->display_name);
+  g_array_unref (monitor->modes);
+}
+
+static void
+add_mode (MockMonitor *monitor,
+          gint         width,
+          gint         height,
+          gdouble      refresh)
+{
+  MockMode mode;
+
+  mode.id = g_strdup_printf ("%dx%d@%.3f", width, height, refresh);
+  mode.width = width;
+  mode.height = height;
+  mode.refresh = refresh;
+
+  g_array_append_val (monitor->modes, mode);
+}
+
+static MockMonitor *
+add_monitor (MockDisplayConfig *self,
+             const gchar       *connector,
+             const gchar       *vendor,
+             const gchar       *product,
+             const gchar       *display_name,
+             gboolean           builtin,
+             gint               width_mm,
+             gint               height_mm,
+             gint               width,
+             gint               height,
+             gdouble            scale)
+{
+  MockMonitor monitor = { 0, };
+  guint n_same = 0;
+  guint i;
+
+  /* The serial belongs to the display, whichever port it is plugged into */
+  for (i = 0; i < self->monitors->len; i++)
+    if (g_str_equal (g_array_index (self->monitors, MockMonitor, i).product, product))
+      n_same++;
+
+  monitor.connector = g_strdup (connector);
+  monitor.vendor = g_strdup (vendor);
+  monitor.product = g_strdup (product);
+  monitor.serial = g_strdup_printf ("0x%08x", g_str_hash (product) + n_same);
+  monitor.display_name = g_strdup (display_name);
+  monitor.builtin = builtin;
+  monitor.width_mm = width_mm;
+  monitor.height_mm = height_mm;
+  monitor.scale = scale;
+  monitor.active = TRUE;
+
+  monitor.modes = g_array_new (FALSE, TRUE, sizeof (MockMode));
+  g_array_set_clear_func (monitor.modes, (GDestroyNotify) clear_mode);
+
+  add_mode (&monitor, width, height, 60.0);
+  add_mode (&monitor, width, height, 50.0);
+  for (i = 0; i < G_N_ELEMENTS (common_sizes); i++)
+    {
+      if (common_sizes[i].width > width || common_sizes[i].height > height)
+        continue;
+      if (common_sizes[i].width == width && common_sizes[i].height == height)
+        continue;
+
+      add_mode (&monitor, common_sizes[i].width, common_sizes[i].height, 60.0);
+    }
+
+  g_array_append_val (self->monitors, monitor);
+
+  return &g_array_index (self->monitors, MockMonitor, self->monitors->len - 1);
+}
+
+static void
+get_logical_size (MockMonitor *monitor,
+                  gint        *width,
+                  gint        *height)
+{
+  MockMode *mode = &g_array_index (monitor->modes, MockMode, monitor->current_mode);
+
+  *width = (gint) (mode->width / monitor->scale + 0.5);
+  *height = (gint) (mode->height / monitor->scale + 0.5);
+
+  if (monitor->rotation % 2)
+    {
+      gint tmp = *width;
+      *width = *height;
+      *height = tmp;
+    }
+}
+
+static void
+add_grid (MockDisplayConfig *self,
+          guint              columns,
+          guint              rows)
+{
+  guint i;
+
+  for (i = 0; i < columns * rows; i++)
+    {
+      g_autofree gchar *connector = g_strdup_printf ("DP-%u", i + 1);
+      MockMonitor *monitor;
+
+      monitor = add_monitor (self, connector, "DEL", "DELL P2419H", "Dell 24\"",
+                             FALSE, 527, 296, 1920, 1080, 1.0);
+      monitor->x = (i % columns) * 1920;
+      monitor->y = (i / columns) * 1080;
+      monitor->primary = (i == 0);
+    }
+}
+
+static gboolean
+load_layout (MockDisplayConfig *self,
+             const gchar       *layout)
+{
+  MockMonitor *monitor;
+  gint width, height;
+
+  g_array_set_size (self->monitors, 0);
+
+  if (g_str_equal (layout, "laptop"))
+    {
+      monitor = add_monitor (self, "eDP-1", "BOE", "0x0a1c", "Built-in display",
+                             TRUE, 344, 194, 2560, 1600, 2.0);
+      monitor->primary = TRUE;
+    }
+  else if (g_str_equal (layout, "dual"))
+    {
+      monitor = add_monitor (self, "eDP-1", "BOE", "0x0a1c", "Built-in display",
+                             TRUE, 344, 194, 2560, 1600, 2.0);
+      monitor->primary = TRUE;
+      get_logical_size (monitor, &width, &height);
+
+      monitor = add_monitor (self, "HDMI-1", "GSM", "LG HDR 4K", "LG Electronics 27\"",
+                             FALSE, 600, 340, 3840, 2160, 2.0);
+      monitor->x = width;
+    }
+  else if (g_str_equal (layout, "triple") || g_str_equal (layout, "triple-swapped"))
+    {
+      gboolean swapped = g_str_equal (layout, "triple-swapped");
+
+      /* The same displays in the same places, the two on DisplayPort
+       * swapped */
+      monitor = add_monitor (self, swapped ? "DP-2" : "DP-1", "DEL", "DELL U2415", "Dell 24\"",
+                             FALSE, 518, 324, 1920, 1200, 1.0);
+      get_logical_size (monitor, &width, &height);
+
+      monitor = add_monitor (self, swapped ? "DP-1" : "DP-2", "DEL", "DELL U2719D", "Dell 27\"",
+                             FALSE, 597, 336, 2560, 1440, 1.0);
+      monitor->x = width;
+      monitor->primary = TRUE;
+      get_logical_size (monitor, &width, &height);
+      width += monitor->x;
+
+      monitor = add_monitor (self, "HDMI-1", "DEL", "DELL U2415", "Dell 24\"",
+                             FALSE, 518, 324, 1920, 1200, 1.0);
+      monitor->x = width;
+    }
+  else if (g_str_equal (layout, "8-way"))
+    {
+      add_grid (self, 4, 2);
+    }
+  else if (g_str_equal (layout, "24-way"))
+    {
+      add_grid (self, 6, 4);
+    }
+  else
+    {
+      return FALSE;
+    }
+
+  g_atomic_int_inc (&self->serial);
+
+  return TRUE;
+}
+
+static MockMonitor *
+find_monitor (MockDisplayConfig *self,
+              const gchar       *connector)
+{
+  guint i;
+
+  for (i = 0; i < self->monitors->len; i++)
+    {
+      MockMonitor *monitor = &g_array_index (self->monitors, MockMonitor, i);
+
+      if (g_str_equal (monitor->connector, connector))
+        return monitor;
+    }
+
+  return NULL;
+}
+
+static gint
+find_mode (MockMonitor *monitor,
+           const gchar *id)
+{
+  guint i;
+
+  for (i = 0; i < monitor->modes->len; i++)
+    {
+      if (g_str_equal (g_array_index (monitor->modes, MockMode, i).id, id))
+        return i;
+    }
+
+  return -1;
+}
+
+static GVariant *
+build_monitors (MockDisplayConfig *self)
+{
+  GVariantBuilder builder;
+  guint i, j, k;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a((ssss)a(siiddada{sv})a{sv})"));
+
+  for (i = 0; i < self->monitors->len; i++)
+    {
+      MockMonitor *monitor = &g_array_index (self->monitors, MockMonitor, i);
+      GVariantBuilder modes;
+      GVariantBuilder props;
+
+      g_variant_builder_init (&modes, G_VARIANT_TYPE ("a(siiddada{sv})"));
+
+      for (j = 0; j < monitor->modes->len; j++)
+        {
+          MockMode *mode = &g_array_index (monitor->modes, MockMode, j);
+          GVariantBuilder scales;
+          GVariantBuilder mode_props;
+
+          g_variant_builder_init (&scales, G_VARIANT_TYPE ("ad"));
+          for (k = 0; k < G_N_ELEMENTS (supported_scales); k++)
+            {
+              gdouble width = mode->width / supported_scales[k];
+              gdouble height = mode->height / supported_scales[k];
+
+              /* Like Muffin, only offer scales giving a whole logical
+               * size of at least 800x600 */
+              if (width < 800 || height < 600 ||
+                  width != (gint) width || height != (gint) height)
+                continue;
+
+              g_variant_builder_add (&scales, "d", supported_scales[k]);
+            }
+
+          g_variant_builder_init (&mode_props, G_VARIANT_TYPE ("a{sv}"));
+          if (j == 0)
+            g_variant_builder_add (&mode_props, "{sv}", "is-preferred", g_variant_new_boolean (TRUE));
+          if (monitor->active && j == monitor->current_mode)
+            g_variant_builder_add (&mode_props, "{sv}", "is-current", g_variant_new_boolean (TRUE));
+
+          g_variant_builder_add (&modes, "(siiddada{sv})",
+                                 mode->id,
+                                 mode->width,
+                                 mode->height,
+                                 mode->refresh,
+                                 mode->width >= 3840 ? 2.0 : 1.0,
+                                 &scales,
+                                 &mode_props);
+        }
+
+      g_variant_builder_init (&props, G_VARIANT_TYPE ("a{sv}"));
+      g_variant_builder_add (&props, "{sv}", "width-mm", g_variant_new_int32 (monitor->width_mm));
+      g_variant_builder_add (&props, "{sv}", "height-mm", g_variant_new_int32 (monitor->height_mm));
+      g_variant_builder_add (&props, "{sv}", "is-builtin", g_variant_new_boolean (monitor->builtin));
+      g_variant_builder_add (&props, "{sv}", "display-name", g_variant_new_string (monitor->display_name));
+
+      g_variant_builder_add (&builder, "((ssss)a(siiddada{sv})a{sv})",
+                             monitor->connector,
+                             monitor->vendor,
+                             monitor->product,
+                             monitor->serial,
+                             &modes,
+                             &props);
+    }
+
+  return g_variant_builder_end (&builder);
+}
+
+static GVariant *
+build_logical_monitors (MockDisplayConfig *self)
+{
+  GVariantBuilder builder;
+  guint i;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(iiduba(ssss)a{sv})"));
+
+  for (i = 0; i < self->monitors->len; i++)
+    {
+      MockMonitor *monitor = &g_array_index (self->monitors, MockMonitor, i);
+      GVariantBuilder specs;
+
+      if (!monitor->active)
+        continue;
+
+      g_variant_builder_init (&specs, G_VARIANT_TYPE ("a(ssss)"));
+      g_variant_builder_add (&specs, "(ssss)",
+                             monitor->connector,
+                             monitor->vendor,
+                             monitor->product,
+                             monitor->serial);
+
+      g_variant_builder_add (&builder, "(iiduba(ssss)a{sv})",
+                             monitor->x,
+                             monitor->y,
+                             monitor->scale,
+                             monitor->rotation,
+                             monitor->primary,
+                             &specs,
+                             NULL);
+    }
+
+  return g_variant_builder_end (&builder);
+}
+
+static GVariant *
+build_properties (MockDisplayConfig *self)
+{
+  GVariantBuilder builder;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+  g_variant_builder_add (&builder, "{sv}", "layout-mode", g_variant_new_uint32 (1));
+  g_variant_builder_add (&builder, "{sv}", "supports-changing-layout-mode", g_variant_new_boolean (FALSE));
+  g_variant_builder_add (&builder, "{sv}", "global-scale-required", g_variant_new_boolean (FALSE));
+  g_variant_builder_add (&builder, "{sv}", "legacy-ui-scaling-factor", g_variant_new_int32 (1));
+
+  return g_variant_builder_end (&builder);
+}
+
+static gboolean
+handle_get_current_state (MetaDBusDisplayConfig *skeleton,
+                          GDBusMethodInvocation *invocation,
+                          MockDisplayConfig     *self)
+{
+  g_atomic_int_inc (&self->n_get_current_state);
+
+  meta_dbus_display_config_complete_get_current_state (skeleton,
+                                                        invocation,
+                                                        self->serial,
+                                                        build_monitors (self),
+                                                        build_logical_monitors (self),
+                                                        build_properties (self));
+
+  return TRUE;
+}
+
+typedef struct
+{
+  MockMonitor *monitor;
+  guint        logical_monitor;
+  gint         mode;
+  gint         x;
+  gint         y;
+  gint         width;
+  gint         height;
+  gdouble      scale;
+  guint        rotation;
+  gboolean     primary;
+} PendingMonitor;
+
+static gboolean
+rects_overlap (PendingMonitor *a,
+               PendingMonitor *b)
+{
+  return a->x < b->x + b->width && b->x < a->x + a->width &&
+         a->y < b->y + b->height && b->y < a->y + a->height;
+}
+
+static gboolean
+rects_adjacent (PendingMonitor *a,
+                PendingMonitor *b)
+{
+  gboolean x_touch = a->x + a->width == b->x || b->x + b->width == a->x;
+  gboolean y_touch = a->y + a->height == b->y || b->y + b->height == a->y;
+  gboolean x_span = a->x < b->x + b->width && b->x < a->x + a->width;
+  gboolean y_span = a->y < b->y + b->height && b->y < a->y + a->height;
+
+  return (x_touch && y_span) || (y_touch && x_span);
+}
+
+static gboolean
+check_config (GArray  *pending,
+              guint    n_logical_monitors,
+              GError **error)
+{
+  gint min_x = G_MAXINT, min_y = G_MAXINT;
+  guint n_primary = 0;
+  guint i, j;
+
+  for (i = 0; i < pending->len; i++)
+    {
+      PendingMonitor *a = &g_array_index (pending, PendingMonitor, i);
+      gboolean has_neighbour = n_logical_monitors == 1;
+
+      min_x = MIN (min_x, a->x);
+      min_y = MIN (min_y, a->y);
+
+      /* Count each logical monitor once, mirrored monitors share one */
+      if (a->primary &&
+          (i == 0 || g_array_index (pending, PendingMonitor, i - 1).logical_monitor != a->logical_monitor))
+        n_primary++;
+
+      for (j = 0; j < pending->len; j++)
+        {
+          PendingMonitor *b = &g_array_index (pending, PendingMonitor, j);
+
+          if (i == j)
+            continue;
+
+          if (a->monitor == b->monitor)
+            {
+              g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                           "Monitor %s assigned twice", a->monitor->connector);
+              return FALSE;
+            }
+
+          if (a->logical_monitor == b->logical_monitor)
+            continue;
+
+          if (rects_overlap (a, b))
+            {
+              g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                           "Logical monitors %s and %s overlap",
+                           a->monitor->connector, b->monitor->connector);
+              return FALSE;
+            }
+
+          if (rects_adjacent (a, b))
+            has_neighbour = TRUE;
+        }
+
+      if (!has_neighbour)
+        {
+          g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                       "Logical monitor %s not adjacent to any other",
+                       a->monitor->connector);
+          return FALSE;
+        }
+    }
+
+  if (pending->len == 0)
+    {
+      g_set_error_literal (error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                           "No logical monitors");
+      return FALSE;
+    }
+
+  if (min_x != 0 || min_y != 0)
+    {
+      g_set_error_literal (error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                           "Logical monitors positions are offset");
+      return FALSE;
+    }
+
+  if (n_primary != 1)
+    {
+      g_set_error (error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                   "Config has %u primary monitors", n_primary);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+handle_apply_monitors_config (MetaDBusDisplayConfig *skeleton,
+                              GDBusMethodInvocation *invocation,
+                              guint                  serial,
+                              guint                  method,
+                              GVariant              *logical_monitors,
+                              GVariant              *properties,
+                              MockDisplayConfig     *self)
+{
+  g_autoptr(GArray) pending = NULL;
+  g_autoptr(GError) error = NULL;
+  GVariantIter iter;
+  GVariantIter *monitors;
+  gint x, y;
+  gdouble scale;
+  guint rotation;
+  gboolean primary;
+  guint n_logical_monitors = 0;
+  guint i;
+
+  g_atomic_int_inc (&self->n_apply);
+
+  if (serial != (guint) self->serial)
+    {
+      g_dbus_method_invocation_return_error (invocation, G_DBUS_ERROR, G_DBUS_ERROR_ACCESS_DENIED,
+                                             "The requested configuration is based on stale information");
+      return TRUE;
+    }
+
+  pending = g_array_new (FALSE, TRUE, sizeof (PendingMonitor));
+
+  g_variant_iter_init (&iter, logical_monitors);
+  while (g_variant_iter_next (&iter, "(iiduba(ssa{sv}))", &x, &y, &scale, &rotation, &primary, &monitors))
+    {
+      const gchar *connector, *mode_id;
+
+      while (g_variant_iter_next (monitors, "(&s&s@a{sv})", &connector, &mode_id, NULL))
+        {
+          PendingMonitor p = { 0, };
+          MockMode *mode;
+
+          p.monitor = find_monitor (self, connector);
+          if (p.monitor)
+            p.mode = find_mode (p.monitor, mode_id);
+
+          if (!p.monitor || p.mode < 0)
+            {
+              g_set_error (&error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                           "Invalid mode '%s' for monitor '%s'", mode_id, connector);
+              break;
+            }
+
+          mode = &g_array_index (p.monitor->modes, MockMode, p.mode);
+          p.logical_monitor = n_logical_monitors;
+          p.x = x;
+          p.y = y;
+          p.scale = scale;
+          p.rotation = rotation;
+          p.primary = primary;
+          p.width = (gint) (mode->width / scale + 0.5);
+          p.height = (gint) (mode->height / scale + 0.5);
+          if (rotation % 2)
+            {
+              gint tmp = p.width;
+              p.width = p.height;
+              p.height = tmp;
+            }
+
+          g_array_append_val (pending, p);
+        }
+
+      g_variant_iter_free (monitors);
+      n_logical_monitors++;
+
+      if (error)
+        break;
+    }
+
+  if (error || !check_config (pending, n_logical_monitors, &error))
+    {
+      g_dbus_method_invocation_return_gerror (invocation, error);
+      return TRUE;
+    }
+
+  if (method != METHOD_VERIFY)
+    {
+      for (i = 0; i < self->monitors->len; i++)
+        g_array_index (self->monitors, MockMonitor, i).active = FALSE;
+
+      for (i = 0; i < pending->len; i++)
+        {
+          PendingMonitor *p = &g_array_index (pending, PendingMonitor, i);
+
+          p->monitor->active = TRUE;
+          p->monitor->current_mode = p->mode;
+          p->monitor->x = p->x;
+          p->monitor->y = p->y;
+          p->monitor->scale = p->scale;
+          p->monitor->rotation = p->rotation;
+          p->monitor->primary = p->primary;
+        }
+
+      g_atomic_int_inc (&self->serial);
+    }
+
+  meta_dbus_display_config_complete_apply_monitors_config (skeleton, invocation);
+
+  if (method != METHOD_VERIFY)
+    meta_dbus_display_config_emit_monitors_changed (skeleton);
+
+  return TRUE;
+}
+
+typedef struct
+{
+  MockDisplayConfig *self;
+  GSourceFunc        func;
+  gpointer           data;
+  gboolean           done;
+} SyncCall;
+
+static gboolean
+sync_call_cb (gpointer user_data)
+{
+  SyncCall *call = user_data;
+  MockDisplayConfig *self = call->self;
+
+  call->func (call->data);
+
+  g_mutex_lock (&self->lock);
+  call->done = TRUE;
+  g_cond_signal (&self->cond);
+  g_mutex_unlock (&self->lock);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Runs @func where the mock is served and waits for it to finish. */
+static void
+run_sync (MockDisplayConfig *self,
+          GSourceFunc        func,
+          gpointer           data)
+{
+  SyncCall call = { self, func, data, FALSE };
+
+  if (!self->thread)
+    {
+      func (data);
+      return;
+    }
+
+  g_main_context_invoke (self->context, sync_call_cb, &call);
+
+  g_mutex_lock (&self->lock);
+  while (!call.done)
+    g_cond_wait (&self->cond, &self->lock);
+  g_mutex_unlock (&self->lock);
+}
+
+static gpointer
+mock_thread_func (gpointer data)
+{
+  MockDisplayConfig *self = MOCK_DISPLAY_CONFIG (data);
+
+  g_main_context_push_thread_default (self->context);
+  g_main_loop_run (self->loop);
+  g_main_context_pop_thread_default (self->context);
+
+  return NULL;
+}
+
+static void
+mock_display_config_finalize (GObject *object)
+{
+  MockDisplayConfig *self = MOCK_DISPLAY_CONFIG (object);
+
+  if (self->thread)
+    {
+      g_main_loop_quit (self->loop);
+      g_thread_join (self->thread);
+    }
+
+  mock_display_config_unexport (self);
+  g_clear_object (&self->connection);
+  g_clear_pointer (&self->loop, g_main_loop_unref);
+  g_clear_pointer (&self->context, g_main_context_unref);
+  g_mutex_clear (&self->lock);
+  g_cond_clear (&self->cond);
+
+  g_clear_object (&self->skeleton);
+  g_clear_pointer (&self->monitors, g_array_unref);
+
+  G_OBJECT_CLASS (mock_display_config_parent_class)->finalize (object);
+}
+
+static void
+mock_display_config_init (MockDisplayConfig *self)
+{
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->cond);
+
+  self->monitors = g_array_new (FALSE, TRUE, sizeof (MockMonitor));
+  g_array_set_clear_func (self->monitors, (GDestroyNotify) clear_monitor);
+
+  self->skeleton = meta_dbus_display_config_skeleton_new ();
+  g_signal_connect (self->skeleton, "handle-get-current-state",
+                    G_CALLBACK (handle_get_current_state), self);
+  g_signal_connect (self->skeleton, "handle-apply-monitors-config",
+                    G_CALLBACK (handle_apply_monitors_config), self);
+}
+
+static void
+mock_display_config_class_init (MockDisplayConfigClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = mock_display_config_finalize;
+}
+
+/**
+ * mock_display_config_get_layouts:
+ *
+ * Returns: (transfer none): the names of the canned layouts, from the
+ * smallest to the largest.
+ */
+const gchar * const *
+mock_display_config_get_layouts (void)
+{
+  return layouts;
+}
+
+/**
+ * mock_display_config_new:
+ * @layout: one of mock_display_config_get_layouts()
+ *
+ * Returns: (transfer full) (nullable): a new mock, or %NULL if @layout is
+ * unknown.
+ */
+MockDisplayConfig *
+mock_display_config_new (const gchar *layout)
+{
+  g_autoptr(MockDisplayConfig) self = g_object_new (MOCK_TYPE_DISPLAY_CONFIG, NULL);
+
+  if (!load_layout (self, layout))
+    return NULL;
+
+  return g_steal_pointer (&self);
+}
+
+typedef struct
+{
+  MockDisplayConfig *self;
+  const gchar       *layout;
+  guint              count;
+} MockCall;
+
+static gboolean
+set_layout_cb (gpointer data)
+{
+  MockCall *call = data;
+
+  load_layout (call->self, call->layout);
+  meta_dbus_display_config_emit_monitors_changed (call->self->skeleton);
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * mock_display_config_set_layout:
+ *
+ * Switches to another layout, as if monitors had been plugged or unplugged,
+ * and emits MonitorsChanged.
+ *
+ * Returns: %FALSE if @layout is unknown.
+ */
+gboolean
+mock_display_config_set_layout (MockDisplayConfig *self,
+                                const gchar       *layout)
+{
+  MockCall call = { self, layout, 0 };
+
+  g_return_val_if_fail (MOCK_IS_DISPLAY_CONFIG (self), FALSE);
+
+  if (!g_strv_contains (layouts, layout))
+    return FALSE;
+
+  run_sync (self, set_layout_cb, &call);
+
+  return TRUE;
+}
+
+guint
+mock_display_config_get_n_monitors (MockDisplayConfig *self)
+{
+  g_return_val_if_fail (MOCK_IS_DISPLAY_CONFIG (self), 0);
+
+  return self->monitors->len;
+}
+
+guint32
+mock_display_config_get_serial (MockDisplayConfig *self)
+{
+  g_return_val_if_fail (MOCK_IS_DISPLAY_CONFIG (self), 0);
+
+  return g_atomic_int_get (&self->serial);
+}
+
+typedef struct
+{
+  MockDisplayConfig *self;
+  GVariant          *state;
+} GetStateCall;
+
+static gboolean
+get_state_cb (gpointer data)
+{
+  GetStateCall *call = data;
+
+  call->state = g_variant_ref_sink (g_variant_new ("(u@*@*@*)",
+                                                   call->self->serial,
+                                                   build_monitors (call->self),
+                                                   build_logical_monitors (call->self),
+                                                   build_properties (call->self)));
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * mock_display_config_get_state:
+ *
+ * Returns: (transfer full): what GetCurrentState would currently return.
+ */
+GVariant *
+mock_display_config_get_state (MockDisplayConfig *self)
+{
+  GetStateCall call = { self, NULL };
+
+  g_return_val_if_fail (MOCK_IS_DISPLAY_CONFIG (self), NULL);
+
+  run_sync (self, get_state_cb, &call);
+
+  return call.state;
+}
+
+/**
+ * mock_display_config_export:
+ *
+ * Exports the mock on @connection. Owning the org.cinnamon.Muffin.DisplayConfig
+ * name is left to the caller.
+ */
+gboolean
+mock_display_config_export (MockDisplayConfig *self,
+                            GDBusConnection   *connection,
+                            GError           **error)
+{
+  g_return_val_if_fail (MOCK_IS_DISPLAY_CONFIG (self), FALSE);
+
+  return g_dbus_interface_skeleton_export (G_DBUS_INTERFACE_SKELETON (self->skeleton),
+                                           connection,
+                                           "/org/cinnamon/Muffin/DisplayConfig",
+                                           error);
+}
+
+void
+mock_display_config_unexport (MockDisplayConfig *self)
+{
+  g_return_if_fail (MOCK_IS_DISPLAY_CONFIG (self));
+
+  if (g_dbus_interface_skeleton_get_connection (G_DBUS_INTERFACE_SKELETON (self->skeleton)))
+    g_dbus_interface_skeleton_unexport (G_DBUS_INTERFACE_SKELETON (self->skeleton));
+}
+
+/**
+ * mock_display_config_start:
+ * @address: the address of the bus to serve on
+ *
+ * Connects to @address, exports the mock, owns the
+ * org.cinnamon.Muffin.DisplayConfig name and serves calls from a thread of
+ * its own until the mock is finalized. This lets code under test make
+ * synchronous calls (e.g. cc_display_config_apply()) from the main thread.
+ */
+gboolean
+mock_display_config_start (MockDisplayConfig *self,
+                           const gchar       *address,
+                           GError           **error)
+{
+  g_autoptr(GVariant) reply = NULL;
+  guint32 result;
+
+  g_return_val_if_fail (MOCK_IS_DISPLAY_CONFIG (self), FALSE);
+  g_return_val_if_fail (self->thread == NULL, FALSE);
+
+  self->context = g_main_context_new ();
+
+  /* Method calls get dispatched in the context the skeleton is exported in */
+  g_main_context_push_thread_default (self->context);
+
+  self->connection = g_dbus_connection_new_for_address_sync (address,
+                                                             G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                                                             G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+                                                             NULL, NULL, error);
+  if (self->connection &&
+      mock_display_config_export (self, self->connection, error))
+    {
+      reply = g_dbus_connection_call_sync (self->connection,
+                                           "org.freedesktop.DBus",
+                                           "/org/freedesktop/DBus",
+                                           "org.freedesktop.DBus",
+                                           "RequestName",
+                                           g_variant_new ("(su)", "org.cinnamon.Muffin.DisplayConfig",
+                                                          G_BUS_NAME_OWNER_FLAGS_NONE),
+                                           G_VARIANT_TYPE ("(u)"),
+                                           G_DBUS_CALL_FLAGS_NONE,
+                                           -1, NULL, error);
+    }
+
+  g_main_context_pop_thread_default (self->context);
+
+  if (!reply)
+    return FALSE;
+
+  g_variant_get (reply, "(u)", &result);
+  if (result != 1 /* DBUS_REQUEST_NAME_REPLY_PRIMARY_OWNER */)
+    {
+      g_set_error_literal (error, G_DBUS_ERROR, G_DBUS_ERROR_ADDRESS_IN_USE,
+                           "org.cinnamon.Muffin.DisplayConfig is already owned");
+      return FALSE;
+    }
+
+  self->loop = g_main_loop_new (self->context, FALSE);
+  self->thread = g_thread_new ("mock-display-config", mock_thread_func, self);
+
+  return TRUE;
+}
+
+static gboolean
+emit_monitors_changed_cb (gpointer data)
+{
+  MockCall *call = data;
+  guint i;
+
+  for (i = 0; i < call->count; i++)
+    meta_dbus_display_config_emit_monitors_changed (call->self->skeleton);
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * mock_display_config_emit_monitors_changed:
+ * @count: how many signals to emit
+ *
+ * Emits MonitorsChanged @count times in a row without changing the state,
+ * like Muffin does while a dock is being connected.
+ */
+void
+mock_display_config_emit_monitors_changed (MockDisplayConfig *self,
+                                           guint              count)
+{
+  MockCall call = { self, NULL, count };
+
+  g_return_if_fail (MOCK_IS_DISPLAY_CONFIG (self));
+
+  run_sync (self, emit_monitors_changed_cb, &call);
+}
+
+guint
+mock_display_config_get_n_get_current_state (MockDisplayConfig *self)
+{
+  g_return_val_if_fail (MOCK_IS_DISPLAY_CONFIG (self), 0);
+
+  return g_atomic_int_get (&self->n_get_current_state);
+}
+
+guint
+mock_display_config_get_n_apply (MockDisplayConfig *self)
+{
+  g_return_val_if_fail (MOCK_IS_DISPLAY_CONFIG (self), 0);
+
+  return g_atomic_int_get (&self->n_apply);
+}
+
+void
+mock_display_config_reset_counters (MockDisplayConfig *self)
+{
+  g_return_if_fail (MOCK_IS_DISPLAY_CONFIG (self));
+
+  g_atomic_int_set (&self->n_get_current_state, 0);
+  g_atomic_int_set (&self->n_apply, 0);
+}
@@ -0,0 +1,60 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/*
+ * MockDisplayConfig:
+ *
+ *   A stand-in for Muffin's org.cinnamon.Muffin.DisplayConfig, for tests and
+ *   benchmarks. It serves GetCurrentState for one of a few canned layouts,
+ *   checks and applies ApplyMonitorsConfig the way Muffin does (serial,
+ *   known connectors and modes, no overlaps, no detached monitors) and emits
+ *   MonitorsChanged on any change, or as often as asked to.
+ */
+
+#define MOCK_TYPE_DISPLAY_CONFIG (mock_display_config_get_type ())
+G_DECLARE_FINAL_TYPE (MockDisplayConfig, mock_display_config, MOCK, DISPLAY_CONFIG, GObject)
+
+const gchar * const * mock_display_config_get_layouts             (void);
+
+MockDisplayConfig *   mock_display_config_new                     (const gchar       *layout);
+gboolean              mock_display_config_set_layout              (MockDisplayConfig *self,
+                                                                   const gchar       *layout);
+guint                 mock_display_config_get_n_monitors          (MockDisplayConfig *self);
+guint32               mock_display_config_get_serial              (MockDisplayConfig *self);
+GVariant *            mock_display_config_get_state               (MockDisplayConfig *self);
+
+gboolean              mock_display_config_export                  (MockDisplayConfig *self,
+                                                                   GDBusConnection   *connection,
+                                                                   GError           **error);
+gboolean              mock_display_config_start                   (MockDisplayConfig *self,
+                                                                   const gchar       *address,
+                                                                   GError           **error);
+void                  mock_display_config_unexport                (MockDisplayConfig *self);
+void                  mock_display_config_emit_monitors_changed   (MockDisplayConfig *self,
+                                                                   guint              count);
+
+guint                 mock_display_config_get_n_get_current_state (MockDisplayConfig *self);
+guint                 mock_display_config_get_n_apply             (MockDisplayConfig *self);
+void                  mock_display_config_reset_counters          (MockDisplayConfig *self);
+
+G_END_DECLS
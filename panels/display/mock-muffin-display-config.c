@@ -0,0 +1,154 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * Stand-alone mock of Muffin's DisplayConfig service, to try the display
+ * panel on hardware one doesn't have:
+ *
+ *   dbus-run-session -- sh -c 'mock-muffin-display-config 24-way & cinnamon-settings display'
+ *
+ * Commands are read from stdin, if any, one per line:
+ *
+ *   layout NAME   switch to another layout
+ *   storm N       emit N MonitorsChanged signals in a row
+ *   quit
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "mock-display-config.h"
+
+static GMainLoop *loop;
+static MockDisplayConfig *mock;
+
+static void
+print_layouts (void)
+{
+  g_autofree gchar *names = g_strjoinv (", ", (gchar **) mock_display_config_get_layouts ());
+
+  g_printerr ("Layouts: %s\n", names);
+}
+
+static void
+run_command (const gchar *line)
+{
+  g_auto(GStrv) argv = g_strsplit (g_strstrip ((gchar *) line), " ", 2);
+
+  if (argv[0] == NULL || *argv[0] == '\0')
+    return;
+
+  if (g_str_equal (argv[0], "layout") && argv[1] != NULL)
+    {
+      if (!mock_display_config_set_layout (mock, argv[1]))
+        print_layouts ();
+    }
+  else if (g_str_equal (argv[0], "storm") && argv[1] != NULL)
+    {
+      mock_display_config_emit_monitors_changed (mock, atoi (argv[1]));
+    }
+  else if (g_str_equal (argv[0], "quit"))
+    {
+      g_main_loop_quit (loop);
+    }
+  else
+    {
+      g_printerr ("Unknown command: %s\n", line);
+    }
+
+  g_printerr ("serial %u, %u GetCurrentState, %u ApplyMonitorsConfig\n",
+              mock_display_config_get_serial (mock),
+              mock_display_config_get_n_get_current_state (mock),
+              mock_display_config_get_n_apply (mock));
+}
+
+static gboolean
+stdin_cb (GIOChannel   *channel,
+          GIOCondition  condition,
+          gpointer      user_data)
+{
+  g_autofree gchar *line = NULL;
+
+  /* Keep serving when started without a terminal */
+  if (g_io_channel_read_line (channel, &line, NULL, NULL, NULL) != G_IO_STATUS_NORMAL)
+    return G_SOURCE_REMOVE;
+
+  run_command (line);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+bus_acquired_cb (GDBusConnection *connection,
+                 const gchar     *name,
+                 gpointer         user_data)
+{
+  g_autoptr(GError) error = NULL;
+
+  if (!mock_display_config_export (mock, connection, &error))
+    {
+      g_printerr ("Failed to export the mock: %s\n", error->message);
+      g_main_loop_quit (loop);
+    }
+}
+
+static void
+name_lost_cb (GDBusConnection *connection,
+              const gchar     *name,
+              gpointer         user_data)
+{
+  g_printerr ("Couldn't own %s, is Muffin running on this bus?\n", name);
+  g_main_loop_quit (loop);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_autoptr(GIOChannel) channel = NULL;
+  guint owner_id;
+
+  mock = mock_display_config_new (argc > 1 ? argv[1] : "laptop");
+  if (!mock)
+    {
+      print_layouts ();
+      return EXIT_FAILURE;
+    }
+
+  loop = g_main_loop_new (NULL, FALSE);
+
+  owner_id = g_bus_own_name (G_BUS_TYPE_SESSION,
+                             "org.cinnamon.Muffin.DisplayConfig",
+                             G_BUS_NAME_OWNER_FLAGS_NONE,
+                             bus_acquired_cb,
+                             NULL,
+                             name_lost_cb,
+                             NULL,
+                             NULL);
+
+  channel = g_io_channel_unix_new (STDIN_FILENO);
+  g_io_add_watch (channel, G_IO_IN | G_IO_HUP, stdin_cb, NULL);
+
+  g_main_loop_run (loop);
+
+  g_bus_unown_name (owner_id);
+  g_clear_object (&mock);
+  g_main_loop_unref (loop);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,505 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * Replays the mock Muffin layouts through CcDisplayConfigDBus on a private
+ * session bus. Run with -m perf to also time construction, snapping and
+ * apply round-trips for each layout.
+ */
+
+#include "config.h"
+
+#include <gtk/gtk.h>
+#include <math.h>
+
+#include "cc-display-arrangement.h"
+#include "cc-display-config-manager-dbus.h"
+#include "cc-display-state.h"
+#include "mock-display-config.h"
+
+#define TIMEOUT_USEC (5 * G_USEC_PER_SEC)
+#define PERF_ITERATIONS 100
+
+static MockDisplayConfig *mock;
+static CcDisplayConfigManager *manager;
+static guint n_changed;
+
+static gboolean
+wake_up_cb (gpointer user_data)
+{
+  return G_SOURCE_CONTINUE;
+}
+
+/* Spins the main loop until the shared display state caught up with the
+ * mock. */
+static void
+wait_for_state (void)
+{
+  gint64 deadline = g_get_monotonic_time () + TIMEOUT_USEC;
+  guint wake_up_id = g_timeout_add (10, wake_up_cb, NULL);
+
+  while (TRUE)
+    {
+      g_autoptr(CcDisplayStateSnapshot) snapshot = NULL;
+
+      snapshot = cc_display_state_get_snapshot (cc_display_state_get_default ());
+      if (snapshot &&
+          cc_display_state_snapshot_get_serial (snapshot) == mock_display_config_get_serial (mock))
+        break;
+
+      g_assert_cmpint (g_get_monotonic_time (), <, deadline);
+      g_main_context_iteration (NULL, TRUE);
+    }
+
+  g_source_remove (wake_up_id);
+}
+
+static void
+spin (guint msec)
+{
+  gint64 deadline = g_get_monotonic_time () + msec * 1000;
+  guint wake_up_id = g_timeout_add (10, wake_up_cb, NULL);
+
+  while (g_get_monotonic_time () < deadline)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_source_remove (wake_up_id);
+}
+
+static CcDisplayConfig *
+load_layout (const gchar *layout)
+{
+  g_assert_true (mock_display_config_set_layout (mock, layout));
+  wait_for_state ();
+
+  return cc_display_config_manager_get_current (manager);
+}
+
+static void
+get_layout_geometry (CcDisplayConfig  *config,
+                     CcDisplayMonitor *output,
+                     gint             *x,
+                     gint             *y,
+                     gint             *w,
+                     gint             *h)
+{
+  cc_display_monitor_get_geometry (output, x, y, w, h);
+
+  if (cc_display_config_is_layout_logical (config))
+    {
+      *w = round (*w / cc_display_monitor_get_scale (output));
+      *h = round (*h / cc_display_monitor_get_scale (output));
+    }
+}
+
+static void
+assert_no_overlaps (CcDisplayConfig *config)
+{
+  GList *l, *k;
+
+  for (l = cc_display_config_get_monitors (config); l != NULL; l = l->next)
+    {
+      gint x1, y1, w1, h1;
+
+      if (!cc_display_monitor_is_useful (l->data))
+        continue;
+
+      get_layout_geometry (config, l->data, &x1, &y1, &w1, &h1);
+
+      for (k = l->next; k != NULL; k = k->next)
+        {
+          gint x2, y2, w2, h2;
+
+          if (!cc_display_monitor_is_useful (k->data))
+            continue;
+
+          get_layout_geometry (config, k->data, &x2, &y2, &w2, &h2);
+          g_assert_false (x1 < x2 + w2 && x2 < x1 + w1 &&
+                          y1 < y2 + h2 && y2 < y1 + h1);
+        }
+    }
+}
+
+/* Drags the last monitor far away from the others and drops it. */
+static CcDisplayMonitor *
+move_and_snap (CcDisplayConfig *config)
+{
+  CcDisplayMonitor *output;
+  gint x, y, w, h;
+
+  output = g_list_last (cc_display_config_get_monitors (config))->data;
+  cc_display_monitor_get_geometry (output, &x, &y, &w, &h);
+  cc_display_monitor_set_position (output, x + 10000, y + 10000);
+  cc_display_config_snap_output (config, output);
+
+  return output;
+}
+
+static void
+test_construct (gconstpointer data)
+{
+  const gchar *layout = data;
+  g_autoptr(CcDisplayConfig) config = NULL;
+  guint n_primary = 0;
+  GList *l;
+
+  config = load_layout (layout);
+  g_assert_nonnull (config);
+
+  g_assert_cmpuint (g_list_length (cc_display_config_get_monitors (config)), ==,
+                    mock_display_config_get_n_monitors (mock));
+  g_assert_cmpint (cc_display_config_count_useful_monitors (config), ==,
+                   mock_display_config_get_n_monitors (mock));
+
+  for (l = cc_display_config_get_monitors (config); l != NULL; l = l->next)
+    {
+      if (cc_display_monitor_is_primary (l->data))
+        n_primary++;
+    }
+  g_assert_cmpuint (n_primary, ==, 1);
+
+  assert_no_overlaps (config);
+  g_assert_true (cc_display_config_is_applicable (config));
+}
+
+static void
+test_snap (gconstpointer data)
+{
+  const gchar *layout = data;
+  g_autoptr(CcDisplayConfig) config = NULL;
+
+  config = load_layout (layout);
+  if (cc_display_config_count_useful_monitors (config) < 2)
+    {
+      g_test_skip ("Nothing to snap to");
+      return;
+    }
+
+  move_and_snap (config);
+
+  assert_no_overlaps (config);
+  /* Muffin (and the mock) refuse detached monitors */
+  g_assert_true (cc_display_config_is_applicable (config));
+}
+
+static void
+test_apply (gconstpointer data)
+{
+  const gchar *layout = data;
+  g_autoptr(CcDisplayConfig) config = NULL;
+  g_autoptr(CcDisplayConfig) applied = NULL;
+  g_autoptr(GError) error = NULL;
+  guint32 serial;
+
+  config = load_layout (layout);
+  if (cc_display_config_count_useful_monitors (config) > 1)
+    move_and_snap (config);
+
+  serial = mock_display_config_get_serial (mock);
+  mock_display_config_reset_counters (mock);
+
+  g_assert_true (cc_display_config_apply (config, &error));
+  g_assert_no_error (error);
+  g_assert_cmpuint (mock_display_config_get_n_apply (mock), ==, 1);
+  g_assert_cmpuint (mock_display_config_get_serial (mock), ==, serial + 1);
+
+  wait_for_state ();
+  applied = cc_display_config_manager_get_current (manager);
+  g_assert_true (cc_display_config_equal (config, applied));
+
+  /* The old config is stale now */
+  g_assert_false (cc_display_config_apply (config, &error));
+  g_assert_error (error, G_DBUS_ERROR, G_DBUS_ERROR_ACCESS_DENIED);
+}
+
+/* What cc_display_config_get_maximum_scaling() computes, without the cache */
+static gdouble
+compute_maximum_scaling (CcDisplayConfig *config)
+{
+  gdouble max_scale = 1.0;
+  GList *l;
+
+  for (l = cc_display_config_get_monitors (config); l != NULL; l = l->next)
+    if (cc_display_monitor_is_useful (l->data))
+      max_scale = MAX (max_scale, cc_display_monitor_get_scale (l->data));
+
+  return max_scale;
+}
+
+static void
+test_maximum_scaling (gconstpointer data)
+{
+  const gchar *layout = data;
+  g_autoptr(CcDisplayConfig) config = NULL;
+  CcDisplayMonitor *output = NULL;
+  const gdouble *scales;
+  GList *l;
+
+  config = load_layout (layout);
+
+  for (l = cc_display_config_get_monitors (config); l != NULL; l = l->next)
+    if (cc_display_monitor_is_useful (l->data))
+      output = l->data;
+  g_assert_nonnull (output);
+
+  g_assert_cmpfloat (cc_display_config_get_maximum_scaling (config), ==,
+                     compute_maximum_scaling (config));
+
+  /* The cached value follows the monitors */
+  for (scales = cc_display_mode_get_supported_scales (cc_display_monitor_get_mode (output));
+       *scales != 0.0; scales++)
+    {
+      cc_display_monitor_set_scale (output, *scales);
+      g_assert_cmpfloat (cc_display_config_get_maximum_scaling (config), ==,
+                         compute_maximum_scaling (config));
+    }
+
+  if (cc_display_config_count_useful_monitors (config) > 1 &&
+      !cc_display_config_is_cloning (config))
+    {
+      cc_display_monitor_set_active (output, FALSE);
+      g_assert_cmpfloat (cc_display_config_get_maximum_scaling (config), ==,
+                         compute_maximum_scaling (config));
+      cc_display_monitor_set_active (output, TRUE);
+      g_assert_cmpfloat (cc_display_config_get_maximum_scaling (config), ==,
+                         compute_maximum_scaling (config));
+    }
+}
+
+static void
+layout_applied_cb (GObject      *source,
+                   GAsyncResult *res,
+                   gpointer      user_data)
+{
+  GAsyncResult **result = user_data;
+
+  *result = g_object_ref (res);
+}
+
+static void
+test_layout_profile (gconstpointer data)
+{
+  const gchar *layout = data;
+  g_autoptr(CcDisplayConfig) config = NULL;
+  g_autoptr(CcDisplayConfig) applied = NULL;
+  g_autoptr(GVariant) saved = NULL;
+  g_autoptr(GVariant) restored = NULL;
+  g_autoptr(GAsyncResult) result = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autofree gchar *key = NULL;
+
+  config = load_layout (layout);
+  if (cc_display_config_count_useful_monitors (config) < 2)
+    {
+      g_test_skip ("Nothing to rearrange");
+      return;
+    }
+
+  key = g_strdup (cc_display_config_get_monitors_key (config));
+  g_assert_nonnull (key);
+
+  saved = cc_display_config_get_layout (config);
+  restored = cc_display_config_get_layout (config);
+  g_assert_true (g_variant_equal (saved, restored));
+  g_clear_pointer (&restored, g_variant_unref);
+
+  move_and_snap (config);
+  g_assert_true (cc_display_config_apply (config, &error));
+  g_assert_no_error (error);
+  wait_for_state ();
+
+  /* Same displays, same key */
+  applied = cc_display_config_manager_get_current (manager);
+  g_assert_cmpstr (cc_display_config_get_monitors_key (applied), ==, key);
+
+  mock_display_config_reset_counters (mock);
+  cc_display_config_apply_layout_async (applied, saved, NULL, layout_applied_cb, &result);
+  while (result == NULL)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert_true (cc_display_config_apply_layout_finish (applied, result, &error));
+  g_assert_no_error (error);
+  g_assert_cmpuint (mock_display_config_get_n_apply (mock), ==, 1);
+
+  wait_for_state ();
+  g_clear_object (&applied);
+  applied = cc_display_config_manager_get_current (manager);
+  restored = cc_display_config_get_layout (applied);
+  g_assert_true (g_variant_equal (saved, restored));
+}
+
+static void
+test_port_swap (void)
+{
+  g_autoptr(CcDisplayConfig) config = NULL;
+  g_autoptr(CcDisplayConfig) swapped = NULL;
+  g_autoptr(GVariant) saved = NULL;
+  g_autoptr(GVariant) restored = NULL;
+
+  config = load_layout ("triple");
+  saved = cc_display_config_get_layout (config);
+
+  /* The same displays on other ports keep their key, and the layout
+   * saved for it describes them in the same places */
+  swapped = load_layout ("triple-swapped");
+  g_assert_cmpstr (cc_display_config_get_monitors_key (swapped), ==,
+                   cc_display_config_get_monitors_key (config));
+
+  restored = cc_display_config_get_layout (swapped);
+  g_assert_true (g_variant_equal (saved, restored));
+}
+
+static void
+test_storm (void)
+{
+  g_autoptr(CcDisplayConfig) config = NULL;
+
+  config = load_layout ("triple");
+  spin (300);
+
+  /* Nothing changed, so nothing should be rebuilt. How many times the
+   * state is fetched depends on how the burst lines up with the
+   * debounce, so only the outcome is checked. */
+  n_changed = 0;
+  mock_display_config_emit_monitors_changed (mock, 200);
+  spin (300);
+  wait_for_state ();
+
+  g_assert_cmpuint (n_changed, ==, 0);
+
+  /* A hotplug in the middle of a storm is picked up once */
+  mock_display_config_set_layout (mock, "24-way");
+  mock_display_config_emit_monitors_changed (mock, 200);
+  wait_for_state ();
+  spin (300);
+
+  g_assert_cmpuint (n_changed, ==, 1);
+}
+
+static void
+test_perf (gconstpointer data)
+{
+  const gchar *layout = data;
+  g_autoptr(CcDisplayConfig) config = NULL;
+  GTimer *timer;
+  guint i;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("Only run with -m perf");
+      return;
+    }
+
+  config = load_layout (layout);
+  timer = g_timer_new ();
+
+  for (i = 0; i < PERF_ITERATIONS; i++)
+    g_object_unref (cc_display_config_manager_get_current (manager));
+  g_test_minimized_result (g_timer_elapsed (timer, NULL) / PERF_ITERATIONS,
+                           "%s: construct %g s", layout,
+                           g_timer_elapsed (timer, NULL) / PERF_ITERATIONS);
+
+  if (cc_display_config_count_useful_monitors (config) > 1)
+    {
+      g_timer_start (timer);
+      for (i = 0; i < PERF_ITERATIONS; i++)
+        move_and_snap (config);
+      g_test_minimized_result (g_timer_elapsed (timer, NULL) / PERF_ITERATIONS,
+                               "%s: snap %g s", layout,
+                               g_timer_elapsed (timer, NULL) / PERF_ITERATIONS);
+    }
+
+  g_timer_start (timer);
+  for (i = 0; i < PERF_ITERATIONS / 10; i++)
+    {
+      g_autoptr(GError) error = NULL;
+
+      g_clear_object (&config);
+      config = cc_display_config_manager_get_current (manager);
+      g_assert_true (cc_display_config_apply (config, &error));
+      wait_for_state ();
+    }
+  g_test_minimized_result (g_timer_elapsed (timer, NULL) / (PERF_ITERATIONS / 10),
+                           "%s: apply round-trip %g s", layout,
+                           g_timer_elapsed (timer, NULL) / (PERF_ITERATIONS / 10));
+
+  g_timer_destroy (timer);
+}
+
+static void
+add_layout_tests (const gchar *name,
+                  GTestDataFunc func)
+{
+  const gchar * const *layout;
+
+  for (layout = mock_display_config_get_layouts (); *layout != NULL; layout++)
+    {
+      g_autofree gchar *path = g_strdup_printf ("/display/%s/%s", name, *layout);
+
+      g_test_add_data_func (path, *layout, func);
+    }
+}
+
+static void
+changed_cb (void)
+{
+  n_changed++;
+}
+
+int
+main (int argc, char **argv)
+{
+  GTestDBus *bus;
+  g_autoptr(GError) error = NULL;
+  int ret;
+
+  /* Don't touch the user's muffin settings */
+  g_setenv ("GSETTINGS_BACKEND", "memory", TRUE);
+
+  g_test_init (&argc, &argv, NULL);
+  gtk_init_check (&argc, &argv);
+
+  bus = g_test_dbus_new (G_TEST_DBUS_NONE);
+  g_test_dbus_up (bus);
+
+  mock = mock_display_config_new ("laptop");
+  if (!mock_display_config_start (mock, g_test_dbus_get_bus_address (bus), &error))
+    g_error ("Failed to start the mock: %s", error->message);
+
+  manager = cc_display_config_manager_dbus_new ();
+  g_signal_connect (manager, "changed", G_CALLBACK (changed_cb), NULL);
+
+  add_layout_tests ("construct", test_construct);
+  add_layout_tests ("snap", test_snap);
+  add_layout_tests ("apply", test_apply);
+  add_layout_tests ("maximum-scaling", test_maximum_scaling);
+  add_layout_tests ("layout-profile", test_layout_profile);
+  g_test_add_func ("/display/port-swap", test_port_swap);
+  g_test_add_func ("/display/storm", test_storm);
+  add_layout_tests ("perf", test_perf);
+
+  ret = g_test_run ();
+
+  g_clear_object (&manager);
+  g_clear_object (&mock);
+
+  /* The shared display state keeps the session bus connection alive for
+   * the lifetime of the process, so don't wait for it to go away. */
+  g_test_dbus_stop (bus);
+
+  return ret;
+}
@@ -0,0 +1,342 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * Unit tests for the display layout rules. Run with -m perf to also time
+ * validation and snapping on growing layouts, and with --seed to replay a
+ * failing fuzz run.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+
+#include "cc-display-layout.h"
+
+#define FUZZ_ITERATIONS 10000
+#define PERF_ITERATIONS 10000
+
+static void
+test_rects (void)
+{
+  CcDisplayLayoutRect a = { 0, 0, 1920, 1080 };
+  CcDisplayLayoutRect right = { 1920, 0, 1280, 1024 };
+  CcDisplayLayoutRect below = { 100, 1080, 1280, 1024 };
+  CcDisplayLayoutRect corner = { 1920, 1080, 1280, 1024 };
+  CcDisplayLayoutRect inside = { 100, 100, 640, 480 };
+  CcDisplayLayoutRect away = { 2000, 0, 1280, 1024 };
+
+  g_assert_false (cc_display_layout_rects_overlap (&a, &right));
+  g_assert_true (cc_display_layout_rects_adjacent (&a, &right));
+  g_assert_true (cc_display_layout_rects_adjacent (&right, &a));
+
+  g_assert_false (cc_display_layout_rects_overlap (&a, &below));
+  g_assert_true (cc_display_layout_rects_adjacent (&a, &below));
+
+  /* Touching corners is not enough for Muffin */
+  g_assert_false (cc_display_layout_rects_overlap (&a, &corner));
+  g_assert_false (cc_display_layout_rects_adjacent (&a, &corner));
+
+  g_assert_true (cc_display_layout_rects_overlap (&a, &inside));
+  g_assert_true (cc_display_layout_rects_overlap (&inside, &a));
+  g_assert_false (cc_display_layout_rects_adjacent (&a, &inside));
+
+  g_assert_false (cc_display_layout_rects_overlap (&a, &away));
+  g_assert_false (cc_display_layout_rects_adjacent (&a, &away));
+}
+
+static void
+test_validate (void)
+{
+  CcDisplayLayoutRect rects[3] = {
+    { 0, 0, 1920, 1080 },
+    { 1920, 0, 1920, 1080 },
+    { 0, 1080, 1920, 1080 },
+  };
+  guint culprit;
+
+  g_assert_cmpint (cc_display_layout_validate (rects, 0, NULL), ==, CC_DISPLAY_LAYOUT_EMPTY);
+  g_assert_cmpint (cc_display_layout_validate (rects, 1, NULL), ==, CC_DISPLAY_LAYOUT_VALID);
+  g_assert_cmpint (cc_display_layout_validate (rects, 3, NULL), ==, CC_DISPLAY_LAYOUT_VALID);
+
+  /* Offsets are fixed up before applying, not refused */
+  rects[0].x -= 100;
+  rects[1].x -= 100;
+  rects[2].x -= 100;
+  g_assert_cmpint (cc_display_layout_validate (rects, 3, NULL), ==, CC_DISPLAY_LAYOUT_VALID);
+
+  rects[2].x = 1000;
+  g_assert_cmpint (cc_display_layout_validate (rects, 3, &culprit), ==, CC_DISPLAY_LAYOUT_VALID);
+
+  rects[2].y = 1000;
+  g_assert_cmpint (cc_display_layout_validate (rects, 3, &culprit), ==, CC_DISPLAY_LAYOUT_OVERLAPPING);
+  g_assert_cmpuint (culprit, ==, 0);
+
+  rects[2].x = 3820;
+  rects[2].y = 1080;
+  g_assert_cmpint (cc_display_layout_validate (rects, 3, &culprit), ==, CC_DISPLAY_LAYOUT_DETACHED);
+  g_assert_cmpuint (culprit, ==, 2);
+}
+
+static void
+test_normalize (void)
+{
+  CcDisplayLayoutRect rects[2] = {
+    { -1920, 200, 1920, 1080 },
+    { 0, 0, 1920, 1200 },
+  };
+
+  cc_display_layout_normalize (rects, G_N_ELEMENTS (rects));
+
+  g_assert_cmpint (rects[0].x, ==, 0);
+  g_assert_cmpint (rects[0].y, ==, 200);
+  g_assert_cmpint (rects[1].x, ==, 1920);
+  g_assert_cmpint (rects[1].y, ==, 0);
+}
+
+static void
+test_make_linear (void)
+{
+  CcDisplayLayoutRect rects[3] = {
+    { 500, 500, 1280, 1024 },
+    { -10, 20, 1920, 1080 },
+    { 30, 40, 1024, 768 },
+  };
+
+  cc_display_layout_make_linear (rects, G_N_ELEMENTS (rects), 1);
+
+  g_assert_cmpint (rects[1].x, ==, 0);
+  g_assert_cmpint (rects[0].x, ==, 1920);
+  g_assert_cmpint (rects[2].x, ==, 1920 + 1280);
+  g_assert_cmpint (rects[0].y, ==, 0);
+  g_assert_cmpint (rects[1].y, ==, 0);
+  g_assert_cmpint (rects[2].y, ==, 0);
+
+  cc_display_layout_make_linear (rects, G_N_ELEMENTS (rects), -1);
+
+  g_assert_cmpint (rects[0].x, ==, 0);
+  g_assert_cmpint (rects[1].x, ==, 1280);
+  g_assert_cmpint (rects[2].x, ==, 1280 + 1920);
+}
+
+static void
+test_snap (void)
+{
+  CcDisplayLayoutRect rects[2] = {
+    { 0, 0, 1920, 1080 },
+    { 1930, 3, 1280, 1024 },
+  };
+  gint x, y;
+
+  /* Within reach, snaps to the edge and lines up the tops */
+  g_assert_true (cc_display_layout_snap (rects, 2, 1, 1.0, 25, &x, &y));
+  g_assert_cmpint (x, ==, 1920);
+  g_assert_cmpint (y, ==, 0);
+
+  /* Snap distances are on-screen pixels */
+  g_assert_false (cc_display_layout_snap (rects, 2, 1, 10.0, 25, &x, &y));
+  g_assert_cmpint (x, ==, 1930);
+  g_assert_cmpint (y, ==, 3);
+
+  /* Dropped far away, it still ends up attached */
+  rects[1].x = 10000;
+  rects[1].y = -7000;
+  g_assert_true (cc_display_layout_snap (rects, 2, 1, 1.0, G_MAXUINT, &x, &y));
+  rects[1].x = x;
+  rects[1].y = y;
+  g_assert_false (cc_display_layout_rects_overlap (&rects[0], &rects[1]));
+
+  /* Nothing to snap to */
+  g_assert_false (cc_display_layout_snap (rects, 1, 0, 1.0, G_MAXUINT, &x, &y));
+}
+
+static void
+test_scale (void)
+{
+  const gdouble scales[] = { 1.0, 1.5, 2.0 };
+  CcDisplayLayoutModeInfo modes[2] = {
+    { 2880, 1800, scales, G_N_ELEMENTS (scales) },
+    { 1920, 1080, scales, 1 },
+  };
+
+  g_assert_true (cc_display_layout_is_scale_allowed (&modes[0], 2.0, 1024, 768));
+  g_assert_false (cc_display_layout_is_scale_allowed (&modes[0], 1.25, 1024, 768));
+  g_assert_false (cc_display_layout_is_scale_allowed (&modes[0], 2.0, 1920, 768));
+
+  /* Portrait modes count as landscape */
+  modes[0].width = 1800;
+  modes[0].height = 2880;
+  g_assert_true (cc_display_layout_is_scale_allowed (&modes[0], 2.0, 1024, 768));
+
+  g_assert_true (cc_display_layout_is_scale_allowed_by_all (modes, 2, 1.0, 1024, 768));
+  g_assert_false (cc_display_layout_is_scale_allowed_by_all (modes, 2, 2.0, 1024, 768));
+  g_assert_true (cc_display_layout_is_scale_allowed_by_all (modes, 0, 2.0, 1024, 768));
+}
+
+static void
+fill_random (CcDisplayLayoutRect *rects,
+             guint                n_rects)
+{
+  guint i;
+
+  for (i = 0; i < n_rects; i++)
+    {
+      rects[i].x = g_test_rand_int_range (-20000, 20000);
+      rects[i].y = g_test_rand_int_range (-20000, 20000);
+      rects[i].width = g_test_rand_int_range (1, 40) * 64;
+      rects[i].height = g_test_rand_int_range (1, 40) * 64;
+    }
+}
+
+static void
+test_fuzz_linear (void)
+{
+  CcDisplayLayoutRect rects[24];
+  CcDisplayLayoutRect moved[24];
+  guint i, j;
+
+  for (i = 0; i < FUZZ_ITERATIONS; i++)
+    {
+      guint n_rects = g_test_rand_int_range (1, G_N_ELEMENTS (rects) + 1);
+      gint primary = g_test_rand_int_range (-1, n_rects);
+      gint dx = g_test_rand_int_range (-20000, 20000);
+      gint dy = g_test_rand_int_range (-20000, 20000);
+
+      fill_random (rects, n_rects);
+      cc_display_layout_make_linear (rects, n_rects, primary);
+      g_assert_cmpint (cc_display_layout_validate (rects, n_rects, NULL), ==, CC_DISPLAY_LAYOUT_VALID);
+      if (primary >= 0)
+        {
+          g_assert_cmpint (rects[primary].x, ==, 0);
+          g_assert_cmpint (rects[primary].y, ==, 0);
+        }
+
+      /* Moving the whole layout doesn't make it any less valid, and
+       * normalizing moves it right back */
+      for (j = 0; j < n_rects; j++)
+        {
+          moved[j] = rects[j];
+          moved[j].x += dx;
+          moved[j].y += dy;
+        }
+      g_assert_cmpint (cc_display_layout_validate (moved, n_rects, NULL), ==, CC_DISPLAY_LAYOUT_VALID);
+
+      cc_display_layout_normalize (moved, n_rects);
+      for (j = 0; j < n_rects; j++)
+        {
+          g_assert_cmpint (moved[j].x, ==, rects[j].x);
+          g_assert_cmpint (moved[j].y, ==, rects[j].y);
+        }
+    }
+}
+
+static void
+test_fuzz_snap (void)
+{
+  CcDisplayLayoutRect rects[2];
+  guint i;
+
+  for (i = 0; i < FUZZ_ITERATIONS; i++)
+    {
+      gint x, y;
+
+      fill_random (rects, G_N_ELEMENTS (rects));
+
+      g_assert_true (cc_display_layout_snap (rects, 2, 1, 1.0, G_MAXUINT, &x, &y));
+      rects[1].x = x;
+      rects[1].y = y;
+      g_assert_false (cc_display_layout_rects_overlap (&rects[0], &rects[1]));
+
+      /* Snapping again doesn't move it any further */
+      cc_display_layout_snap (rects, 2, 1, 1.0, G_MAXUINT, &x, &y);
+      g_assert_cmpint (x, ==, rects[1].x);
+      g_assert_cmpint (y, ==, rects[1].y);
+    }
+}
+
+static void
+test_perf (gconstpointer data)
+{
+  guint n_rects = GPOINTER_TO_UINT (data);
+  g_autofree CcDisplayLayoutRect *rects = NULL;
+  GTimer *timer;
+  guint i, side;
+  gint x, y;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("Only run with -m perf");
+      return;
+    }
+
+  /* A grid of 1080p monitors, as close to square as it gets */
+  rects = g_new (CcDisplayLayoutRect, n_rects);
+  side = 1;
+  while (side * side < n_rects)
+    side++;
+  for (i = 0; i < n_rects; i++)
+    {
+      rects[i].x = (i % side) * 1920;
+      rects[i].y = (i / side) * 1080;
+      rects[i].width = 1920;
+      rects[i].height = 1080;
+    }
+
+  timer = g_timer_new ();
+  for (i = 0; i < PERF_ITERATIONS; i++)
+    g_assert_cmpint (cc_display_layout_validate (rects, n_rects, NULL), ==, CC_DISPLAY_LAYOUT_VALID);
+  g_test_minimized_result (g_timer_elapsed (timer, NULL) / PERF_ITERATIONS,
+                           "%u monitors: validate %g s", n_rects,
+                           g_timer_elapsed (timer, NULL) / PERF_ITERATIONS);
+
+  rects[n_rects - 1].x += 10000;
+  g_timer_start (timer);
+  for (i = 0; i < PERF_ITERATIONS; i++)
+    cc_display_layout_snap (rects, n_rects, n_rects - 1, 1.0, G_MAXUINT, &x, &y);
+  g_test_minimized_result (g_timer_elapsed (timer, NULL) / PERF_ITERATIONS,
+                           "%u monitors: snap %g s", n_rects,
+                           g_timer_elapsed (timer, NULL) / PERF_ITERATIONS);
+
+  g_timer_destroy (timer);
+}
+
+int
+main (int argc, char **argv)
+{
+  const guint sizes[] = { 2, 8, 24, 64 };
+  guint i;
+
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/display/layout/rects", test_rects);
+  g_test_add_func ("/display/layout/validate", test_validate);
+  g_test_add_func ("/display/layout/normalize", test_normalize);
+  g_test_add_func ("/display/layout/make-linear", test_make_linear);
+  g_test_add_func ("/display/layout/snap", test_snap);
+  g_test_add_func ("/display/layout/scale", test_scale);
+  g_test_add_func ("/display/layout/fuzz/linear", test_fuzz_linear);
+  g_test_add_func ("/display/layout/fuzz/snap", test_fuzz_snap);
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++)
+    {
+      g_autofree gchar *path = g_strdup_printf ("/display/layout/perf/%u", sizes[i]);
+
+      g_test_add_data_func (path, GUINT_TO_POINTER (sizes[i]), test_perf);
+    }
+
+  return g_test_run ();
+}
@@ -0,0 +1,180 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Times the strongest-access-point filter of the Wi-Fi page on synthetic
+ * scan results of 10 to 2000 BSSIDs (about four per SSID, some hidden,
+ * some with a trailing NUL), against the pairwise scan it replaced, and
+ * checks both keep the same access points.
+ *
+ *   bench-wifi-ssid [ITERATIONS]
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "net-wifi-ssid.h"
+
+#define DEFAULT_ITERATIONS 50
+
+typedef struct {
+        GBytes *ssid;
+        guint8  strength;
+} FakeAp;
+
+static GBytes *
+fake_ap_get_ssid (gpointer item)
+{
+        return ((FakeAp *) item)->ssid;
+}
+
+static guint8
+fake_ap_get_strength (gpointer item)
+{
+        return ((FakeAp *) item)->strength;
+}
+
+static void
+fake_ap_free (FakeAp *ap)
+{
+        g_clear_pointer (&ap->ssid, g_bytes_unref);
+        g_free (ap);
+}
+
+static GPtrArray *
+make_aps (guint n_aps)
+{
+        GPtrArray *aps;
+        guint n_ssids = MAX (1, n_aps / 4);
+        guint i;
+
+        aps = g_ptr_array_new_with_free_func ((GDestroyNotify) fake_ap_free);
+        for (i = 0; i < n_aps; i++) {
+                FakeAp *ap = g_new0 (FakeAp, 1);
+                guint32 r = g_random_int ();
+
+                ap->strength = r % 101;
+                if (r % 50 != 0) {
+                        g_autofree gchar *name = g_strdup_printf ("Network %u", g_random_int_range (0, n_ssids));
+
+                        /* some drivers report the trailing NUL */
+                        ap->ssid = g_bytes_new (name, strlen (name) + (r % 7 == 0));
+                }
+                g_ptr_array_add (aps, ap);
+        }
+
+        return aps;
+}
+
+/* The filter as it was: every AP against every one kept so far */
+static GPtrArray *
+get_strongest_unique_pairwise (const GPtrArray *aps)
+{
+        GPtrArray *aps_unique;
+        guint i, j;
+
+        aps_unique = g_ptr_array_new ();
+        for (i = 0; i < aps->len; i++) {
+                FakeAp *ap = g_ptr_array_index (aps, i);
+                gboolean add_ap = TRUE;
+
+                if (!ap->ssid)
+                        continue;
+
+                for (j = 0; j < aps_unique->len; j++) {
+                        FakeAp *ap_tmp = g_ptr_array_index (aps_unique, j);
+
+                        if (net_wifi_ssid_equal (ap->ssid, ap_tmp->ssid)) {
+                                if (ap->strength > ap_tmp->strength)
+                                        g_ptr_array_remove (aps_unique, ap_tmp);
+                                else
+                                        add_ap = FALSE;
+                                break;
+                        }
+                }
+                if (add_ap)
+                        g_ptr_array_add (aps_unique, ap);
+        }
+
+        return aps_unique;
+}
+
+static gboolean
+same_aps (GPtrArray *a, GPtrArray *b)
+{
+        g_autoptr(GHashTable) set = NULL;
+        guint i;
+
+        if (a->len != b->len)
+                return FALSE;
+
+        set = g_hash_table_new (NULL, NULL);
+        for (i = 0; i < a->len; i++)
+                g_hash_table_add (set, g_ptr_array_index (a, i));
+        for (i = 0; i < b->len; i++)
+                if (!g_hash_table_contains (set, g_ptr_array_index (b, i)))
+                        return FALSE;
+
+        return TRUE;
+}
+
+int
+main (int argc, char **argv)
+{
+        const guint sizes[] = { 10, 50, 100, 300, 1000, 2000 };
+        guint iterations = DEFAULT_ITERATIONS;
+        guint i, j;
+
+        if (argc > 1)
+                iterations = MAX (1, g_ascii_strtoull (argv[1], NULL, 10));
+
+        g_random_set_seed (42);
+
+        g_print ("%8s %8s %16s %16s\n", "aps", "unique", "pairwise (us)", "hashed (us)");
+
+        for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+                g_autoptr(GPtrArray) aps = make_aps (sizes[i]);
+                g_autoptr(GPtrArray) expected = get_strongest_unique_pairwise (aps);
+                g_autoptr(GPtrArray) unique = NULL;
+                gint64 start, pairwise, hashed;
+
+                unique = net_wifi_get_strongest_unique (aps, fake_ap_get_ssid, fake_ap_get_strength);
+                if (!same_aps (expected, unique))
+                        g_error ("Different access points kept for %u APs", sizes[i]);
+
+                start = g_get_monotonic_time ();
+                for (j = 0; j < iterations; j++)
+                        g_ptr_array_unref (get_strongest_unique_pairwise (aps));
+                pairwise = g_get_monotonic_time () - start;
+
+                start = g_get_monotonic_time ();
+                for (j = 0; j < iterations; j++)
+                        g_ptr_array_unref (net_wifi_get_strongest_unique (aps, fake_ap_get_ssid, fake_ap_get_strength));
+                hashed = g_get_monotonic_time () - start;
+
+                g_print ("%8u %8u %16.1f %16.1f\n", sizes[i], unique->len,
+                         (gdouble) pairwise / iterations,
+                         (gdouble) hashed / iterations);
+        }
+
+        return 0;
+}
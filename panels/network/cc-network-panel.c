@@ -27,6 +27,7 @@
 #include "cc-network-resources.h"
 
 #include <NetworkManager.h>
+#include <polkit/polkit.h>
 
 #include "net-device.h"
 #ifdef BUILD_MODEM
@@ -73,6 +74,21 @@ struct _CcNetworkPanelPrivate
         void             *modem_manager;
 #endif
         gboolean          updating_device;
+        GSettings        *settings;
+
+        /* NM and MM clients still being created */
+        guint             n_pending_clients;
+
+        /* object id → GtkTreeIter in liststore_devices, whose iters persist */
+        GHashTable       *rows_by_id;
+        guint             refresh_titles_id;
+
+        /* looked up in the background and kept current for the Wi-Fi
+         * connect and hotspot paths */
+        GPermission      *modify_system_permission;
+        gboolean          allowed_to_modify_system;
+        GDBusProxy       *hostname_proxy;
+        gchar            *pretty_hostname;
 
         /* wireless dialog stuff */
         CmdlineOperation  arg_operation;
@@ -223,7 +239,20 @@ cc_network_panel_dispose (GObject *object)
         if (priv->cancellable != NULL)
                 g_cancellable_cancel (priv->cancellable);
 
+        if (priv->refresh_titles_id != 0) {
+                g_source_remove (priv->refresh_titles_id);
+                priv->refresh_titles_id = 0;
+        }
+
+        if (priv->modify_system_permission != NULL)
+                g_signal_handlers_disconnect_by_data (priv->modify_system_permission, object);
+
         g_clear_object (&priv->cancellable);
+        g_clear_object (&priv->modify_system_permission);
+        if (priv->hostname_proxy != NULL)
+                g_signal_handlers_disconnect_by_data (priv->hostname_proxy, object);
+        g_clear_object (&priv->hostname_proxy);
+        g_clear_object (&priv->settings);
         g_clear_object (&priv->client);
         g_clear_object (&priv->modem_manager);
         g_clear_object (&priv->builder);
@@ -237,6 +266,8 @@ cc_network_panel_finalize (GObject *object)
         CcNetworkPanel *panel = CC_NETWORK_PANEL (object);
 
         reset_command_line_args (panel);
+        g_clear_pointer (&panel->priv->rows_by_id, g_hash_table_destroy);
+        g_free (panel->priv->pretty_hostname);
 
         G_OBJECT_CLASS (cc_network_panel_parent_class)->finalize (object);
 }
@@ -309,40 +340,72 @@ select_tree_iter (CcNetworkPanel *panel, GtkTreeIter *iter)
         gtk_tree_selection_select_iter (selection, iter);
 }
 
+static void
+panel_append_row (CcNetworkPanel *panel,
+                  const gchar    *icon_name,
+                  NetObject      *object)
+{
+        GtkListStore *liststore_devices;
+        GtkTreeIter iter;
+
+        liststore_devices = GTK_LIST_STORE (gtk_builder_get_object (panel->priv->builder,
+                                            "liststore_devices"));
+        gtk_list_store_append (liststore_devices, &iter);
+        gtk_list_store_set (liststore_devices,
+                            &iter,
+                            PANEL_DEVICES_COLUMN_ICON, icon_name,
+                            PANEL_DEVICES_COLUMN_OBJECT, object,
+                            -1);
+        g_hash_table_insert (panel->priv->rows_by_id,
+                             g_strdup (net_object_get_id (object)),
+                             gtk_tree_iter_copy (&iter));
+}
+
+/* returns TRUE if there was a row for the id */
+static gboolean
+panel_remove_row (CcNetworkPanel *panel, const gchar *id)
+{
+        GtkListStore *liststore_devices;
+        GtkTreeIter *iter;
+        GtkTreeIter iter_tmp;
+
+        if (id == NULL)
+                return FALSE;
+
+        iter = g_hash_table_lookup (panel->priv->rows_by_id, id);
+        if (iter == NULL)
+                return FALSE;
+
+        iter_tmp = *iter;
+        g_hash_table_remove (panel->priv->rows_by_id, id);
+
+        liststore_devices = GTK_LIST_STORE (gtk_builder_get_object (panel->priv->builder,
+                                            "liststore_devices"));
+        gtk_list_store_remove (liststore_devices, &iter_tmp);
+
+        return TRUE;
+}
+
 static void
 object_removed_cb (NetObject *object, CcNetworkPanel *panel)
 {
-        gboolean ret;
-        NetObject *object_tmp;
         GtkTreeIter iter;
         GtkTreeModel *model;
         GtkTreeSelection *selection;
+        GtkWidget *page;
 
         selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (panel->priv->treeview));
 
         /* remove device from model */
         model = GTK_TREE_MODEL (gtk_builder_get_object (panel->priv->builder,
                                                         "liststore_devices"));
-        ret = gtk_tree_model_get_iter_first (model, &iter);
-        if (!ret)
-                return;
-
-        /* get the other elements */
-        do {
-                gtk_tree_model_get (model, &iter,
-                                    PANEL_DEVICES_COLUMN_OBJECT, &object_tmp,
-                                    -1);
-                if (g_strcmp0 (net_object_get_id (object),
-                               net_object_get_id (object_tmp)) == 0) {
-                        g_object_unref (object_tmp);
-                        if (gtk_list_store_remove (GTK_LIST_STORE (model), &iter)) {
-                                if (gtk_tree_model_get_iter_first (model, &iter))
-                                        gtk_tree_selection_select_iter (selection, &iter);
-                        }
-                        break;
-                }
-                g_object_unref (object_tmp);
-        } while (gtk_tree_model_iter_next (model, &iter));
+        page = net_object_get_page (object);
+        if (panel_remove_row (panel, net_object_get_id (object))) {
+                if (page != NULL)
+                        gtk_widget_destroy (page);
+                if (gtk_tree_model_get_iter_first (model, &iter))
+                        gtk_tree_selection_select_iter (selection, &iter);
+        }
 }
 
 GPtrArray *
@@ -480,6 +543,28 @@ panel_refresh_device_titles (CcNetworkPanel *panel)
         g_ptr_array_free (nmdarray, TRUE);
 }
 
+static gboolean
+refresh_device_titles_cb (gpointer user_data)
+{
+        CcNetworkPanel *panel = user_data;
+
+        panel->priv->refresh_titles_id = 0;
+        panel_refresh_device_titles (panel);
+
+        return G_SOURCE_REMOVE;
+}
+
+/* devices tend to come and go in bursts, e.g. when containers start, and
+ * the titles depend on all of them, so only work them out once per burst */
+static void
+panel_queue_refresh_device_titles (CcNetworkPanel *panel)
+{
+        if (panel->priv->refresh_titles_id != 0)
+                return;
+
+        panel->priv->refresh_titles_id = g_idle_add (refresh_device_titles_cb, panel);
+}
+
 static gboolean
 handle_argv_for_device (CcNetworkPanel *panel,
 			NMDevice       *device,
@@ -618,25 +703,61 @@ state_changed_cb (NMDevice *device,
                            -1);
 }
 
+static gboolean
+panel_device_is_virtual (NMDevice *device)
+{
+        switch (nm_device_get_device_type (device)) {
+        /* not going to set up a cluster in GNOME */
+        case NM_DEVICE_TYPE_VETH:
+        /* enterprise features */
+        case NM_DEVICE_TYPE_BOND:
+        case NM_DEVICE_TYPE_TEAM:
+        case NM_DEVICE_TYPE_OVS_BRIDGE:
+        case NM_DEVICE_TYPE_OVS_PORT:
+        case NM_DEVICE_TYPE_OVS_INTERFACE:
+        case NM_DEVICE_TYPE_VRF:
+        /* Don't need the libvirtd bridge */
+        case NM_DEVICE_TYPE_BRIDGE:
+        case NM_DEVICE_TYPE_MACVLAN:
+        case NM_DEVICE_TYPE_VXLAN:
+        case NM_DEVICE_TYPE_DUMMY:
+        /* Don't add VPN devices */
+        case NM_DEVICE_TYPE_TUN:
+        case NM_DEVICE_TYPE_IP_TUNNEL:
+                return TRUE;
+        default:
+                return FALSE;
+        }
+}
+
+static gboolean
+panel_device_is_shown (CcNetworkPanel *panel, NMDevice *device)
+{
+        if (!nm_device_get_managed (device))
+                return FALSE;
+
+        if (panel_device_is_virtual (device) &&
+            !g_settings_get_boolean (panel->priv->settings, "show-virtual-devices"))
+                return FALSE;
+
+        return TRUE;
+}
+
 static gboolean
 panel_add_device (CcNetworkPanel *panel, NMDevice *device)
 {
-        GtkListStore *liststore_devices;
-        GtkTreeIter iter;
         NMDeviceType type;
         NetDevice *net_device;
         CcNetworkPanelPrivate *priv = panel->priv;
-        GtkNotebook *notebook;
-        GtkSizeGroup *size_group;
         GType device_g_type;
         const char *udi;
 
-        if (!nm_device_get_managed (device))
+        if (!panel_device_is_shown (panel, device))
                 goto out;
 
         /* do we have an existing object with this id? */
         udi = nm_device_get_udi (device);
-        if (find_in_model_by_id (panel, udi, NULL) != NULL)
+        if (g_hash_table_contains (priv->rows_by_id, udi))
                 goto out;
 
         type = nm_device_get_device_type (device);
@@ -657,16 +778,6 @@ panel_add_device (CcNetworkPanel *panel, NMDevice *device)
         case NM_DEVICE_TYPE_WIFI:
                 device_g_type = NET_TYPE_DEVICE_WIFI;
                 break;
-        /* not going to set up a cluster in GNOME */
-        case NM_DEVICE_TYPE_VETH:
-        /* enterprise features */
-        case NM_DEVICE_TYPE_BOND:
-        case NM_DEVICE_TYPE_TEAM:
-        /* Don't need the libvirtd bridge */
-        case NM_DEVICE_TYPE_BRIDGE:
-        /* Don't add VPN devices */
-        case NM_DEVICE_TYPE_TUN:
-                goto out;
         default:
                 device_g_type = NET_TYPE_DEVICE_SIMPLE;
                 break;
@@ -707,27 +818,11 @@ panel_add_device (CcNetworkPanel *panel, NMDevice *device)
                 g_object_unref (modem_object);
         }
 
-        /* add as a panel */
-        if (device_g_type != NET_TYPE_DEVICE) {
-                notebook = GTK_NOTEBOOK (gtk_builder_get_object (panel->priv->builder,
-                                                                 "notebook_types"));
-                size_group = GTK_SIZE_GROUP (gtk_builder_get_object (panel->priv->builder,
-                                                                     "sizegroup1"));
-                net_object_add_to_notebook (NET_OBJECT (net_device),
-                                            notebook,
-                                            size_group);
-        }
-
-        liststore_devices = GTK_LIST_STORE (gtk_builder_get_object (priv->builder,
-                                            "liststore_devices"));
         g_signal_connect_object (net_device, "removed",
                                  G_CALLBACK (object_removed_cb), panel, 0);
-        gtk_list_store_append (liststore_devices, &iter);
-        gtk_list_store_set (liststore_devices,
-                            &iter,
-                            PANEL_DEVICES_COLUMN_ICON, panel_device_to_icon_name (device, TRUE),
-                            PANEL_DEVICES_COLUMN_OBJECT, net_device,
-                            -1);
+        panel_append_row (panel,
+                          panel_device_to_icon_name (device, TRUE),
+                          NET_OBJECT (net_device));
         g_signal_connect (net_device, "notify::title",
                           G_CALLBACK (panel_net_object_notify_title_cb), panel);
 
@@ -742,31 +837,61 @@ out:
 static void
 panel_remove_device (CcNetworkPanel *panel, NMDevice *device)
 {
-        gboolean ret;
-        NetObject *object_tmp;
-        GtkTreeIter iter;
-        GtkTreeModel *model;
+        NetObject *object;
+        GtkWidget *page;
+        const gchar *udi;
+
+        udi = nm_device_get_udi (device);
+        object = find_in_model_by_id (panel, udi, NULL);
+        if (object == NULL)
+                return;
+
+        /* the page, if it was ever shown, goes too so the device can be
+         * added again if it's shown again */
+        page = net_object_get_page (object);
 
         /* remove device from model */
-        model = GTK_TREE_MODEL (gtk_builder_get_object (panel->priv->builder,
-                                                        "liststore_devices"));
-        ret = gtk_tree_model_get_iter_first (model, &iter);
-        if (!ret)
+        panel_remove_row (panel, udi);
+        g_signal_handlers_disconnect_by_func (device, state_changed_cb, panel);
+
+        if (page != NULL)
+                gtk_widget_destroy (page);
+}
+
+/* adds the devices that should be listed and removes the others */
+static void
+panel_sync_devices (CcNetworkPanel *panel)
+{
+        const GPtrArray *devices;
+        GtkTreeSortable *sortable;
+        NMDevice *device;
+        guint i;
+
+        devices = nm_client_get_devices (panel->priv->client);
+        if (devices == NULL)
                 return;
 
-        /* get the other elements */
-        do {
-                gtk_tree_model_get (model, &iter,
-                                    PANEL_DEVICES_COLUMN_OBJECT, &object_tmp,
-                                    -1);
-                if (g_strcmp0 (net_object_get_id (object_tmp),
-                               nm_device_get_udi (device)) == 0) {
-                        gtk_list_store_remove (GTK_LIST_STORE (model), &iter);
-                        g_object_unref (object_tmp);
-                        break;
-                }
-                g_object_unref (object_tmp);
-        } while (gtk_tree_model_iter_next (model, &iter));
+        /* keeping hundreds of rows sorted one at a time is slow,
+         * sort them once at the end instead */
+        sortable = GTK_TREE_SORTABLE (gtk_builder_get_object (panel->priv->builder,
+                                                              "liststore_devices"));
+        gtk_tree_sortable_set_sort_column_id (sortable,
+                                              GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID,
+                                              GTK_SORT_ASCENDING);
+
+        for (i = 0; i < devices->len; i++) {
+                device = g_ptr_array_index (devices, i);
+                if (panel_device_is_shown (panel, device))
+                        panel_add_device (panel, device);
+                else
+                        panel_remove_device (panel, device);
+        }
+
+        panel_refresh_device_titles (panel);
+
+        gtk_tree_sortable_set_sort_column_id (sortable,
+                                              PANEL_DEVICES_COLUMN_OBJECT,
+                                              GTK_SORT_ASCENDING);
 }
 
 static void
@@ -839,77 +964,55 @@ static void
 nm_devices_treeview_clicked_cb (GtkTreeSelection *selection, CcNetworkPanel *panel)
 {
         CcNetworkPanelPrivate *priv = panel->priv;
-        const gchar *id_tmp;
-        const gchar *needle;
-        GList *l;
-        GList *panels = NULL;
         GtkNotebook *notebook;
-        GtkTreeIter iter;
-        GtkTreeModel *model;
+        GtkSizeGroup *size_group;
+        GtkWidget *page;
         GtkWidget *widget;
-        guint i = 0;
-        NetObject *object = NULL;
+        NetObject *object;
 
-        if (!gtk_tree_selection_get_selected (selection, &model, &iter)) {
+        if (!gtk_tree_selection_get_selected (selection, NULL, NULL)) {
                 g_debug ("no row selected");
-                goto out;
+                return;
         }
 
-        /* find the widget in the notebook that matches the object ID */
         object = get_selected_object (panel);
-        needle = net_object_get_id (object);
         notebook = GTK_NOTEBOOK (gtk_builder_get_object (priv->builder,
                                                          "notebook_types"));
-        panels = gtk_container_get_children (GTK_CONTAINER (notebook));
-        for (l = panels; l != NULL; l = l->next) {
-                widget = GTK_WIDGET (l->data);
-                id_tmp = g_object_get_data (G_OBJECT (widget), "NetObject::id");
-                if (g_strcmp0 (needle, id_tmp) == 0) {
-                        gtk_notebook_set_current_page (notebook, i);
-
-                        /* object is deletable? */
-                        widget = GTK_WIDGET (gtk_builder_get_object (priv->builder,
-                                                                     "remove_toolbutton"));
-                        gtk_widget_set_sensitive (widget,
-                                                  net_object_get_removable (object));
-                        break;
-                }
-                i++;
+
+        /* pages are only built the first time their object is shown,
+         * most of them never are */
+        page = net_object_get_page (object);
+        if (page == NULL) {
+                size_group = GTK_SIZE_GROUP (gtk_builder_get_object (priv->builder,
+                                                                     "sizegroup1"));
+                page = net_object_add_to_notebook (object, notebook, size_group);
+                if (page != NULL)
+                        gtk_widget_show (page);
+        }
+
+        if (page != NULL) {
+                gtk_notebook_set_current_page (notebook,
+                                               gtk_notebook_page_num (notebook, page));
+
+                /* object is deletable? */
+                widget = GTK_WIDGET (gtk_builder_get_object (priv->builder,
+                                                             "remove_toolbutton"));
+                gtk_widget_set_sensitive (widget,
+                                          net_object_get_removable (object));
         }
         g_object_unref (object);
-out:
-        g_list_free (panels);
 }
 
 static void
 panel_add_proxy_device (CcNetworkPanel *panel)
 {
-        GtkListStore *liststore_devices;
-        GtkTreeIter iter;
         NetProxy *proxy;
-        GtkNotebook *notebook;
-        GtkSizeGroup *size_group;
 
-        /* add proxy to notebook */
         proxy = net_proxy_new ();
-        notebook = GTK_NOTEBOOK (gtk_builder_get_object (panel->priv->builder,
-                                                         "notebook_types"));
-        size_group = GTK_SIZE_GROUP (gtk_builder_get_object (panel->priv->builder,
-                                                             "sizegroup1"));
-        net_object_add_to_notebook (NET_OBJECT (proxy),
-                                    notebook,
-                                    size_group);
 
         /* add proxy to device list */
-        liststore_devices = GTK_LIST_STORE (gtk_builder_get_object (panel->priv->builder,
-                                            "liststore_devices"));
         net_object_set_title (NET_OBJECT (proxy), _("Network proxy"));
-        gtk_list_store_append (liststore_devices, &iter);
-        gtk_list_store_set (liststore_devices,
-                            &iter,
-                            PANEL_DEVICES_COLUMN_ICON, "xsi-network-symbolic",
-                            PANEL_DEVICES_COLUMN_OBJECT, proxy,
-                            -1);
+        panel_append_row (panel, "xsi-network-symbolic", NET_OBJECT (proxy));
 
         /* NOTE: No connect to notify::title here as it is guaranteed to not
          *       be changed by anyone.*/
@@ -956,7 +1059,7 @@ device_added_cb (NMClient *client, NMDevice *device, CcNetworkPanel *panel)
 {
         g_debug ("New device added");
         panel_add_device (panel, device);
-        panel_refresh_device_titles (panel);
+        panel_queue_refresh_device_titles (panel);
 }
 
 static void
@@ -964,17 +1067,13 @@ device_removed_cb (NMClient *client, NMDevice *device, CcNetworkPanel *panel)
 {
         g_debug ("Device removed");
         panel_remove_device (panel, device);
-        panel_refresh_device_titles (panel);
+        panel_queue_refresh_device_titles (panel);
 }
 
 static void
 manager_running (NMClient *client, GParamSpec *pspec, gpointer user_data)
 {
-        const GPtrArray *devices;
-        int i;
-        NMDevice *device_tmp;
         GtkListStore *liststore_devices;
-        gboolean selected = FALSE;
         CcNetworkPanel *panel = CC_NETWORK_PANEL (user_data);
 
         /* clear all devices we added */
@@ -983,27 +1082,20 @@ manager_running (NMClient *client, GParamSpec *pspec, gpointer user_data)
                 liststore_devices = GTK_LIST_STORE (gtk_builder_get_object (panel->priv->builder,
                                                     "liststore_devices"));
                 gtk_list_store_clear (liststore_devices);
+                g_hash_table_remove_all (panel->priv->rows_by_id);
                 panel_add_proxy_device (panel);
                 goto out;
         }
 
         g_debug ("coldplugging devices");
-        devices = nm_client_get_devices (client);
-        if (devices == NULL) {
+        if (nm_client_get_devices (client) == NULL) {
                 g_debug ("No devices to add");
                 return;
         }
-        for (i = 0; i < devices->len; i++) {
-                device_tmp = g_ptr_array_index (devices, i);
-                selected = panel_add_device (panel, device_tmp) || selected;
-        }
+        panel_sync_devices (panel);
 out:
-        if (!selected) {
-                /* select the first device */
-                select_first_device (panel);
-        }
-
-        panel_refresh_device_titles (panel);
+        /* select the first device */
+        select_first_device (panel);
 
         g_debug ("Calling handle_argv() after cold-plugging devices");
         handle_argv (panel);
@@ -1012,35 +1104,27 @@ out:
 static NetObject *
 find_in_model_by_id (CcNetworkPanel *panel, const gchar *id, GtkTreeIter *iter_out)
 {
-        gboolean ret;
-        NetObject *object_tmp;
-        GtkTreeIter iter;
+        GtkTreeIter *iter;
         GtkTreeModel *model;
         NetObject *object = NULL;
 
-        /* find in model */
+        if (id == NULL)
+                return NULL;
+
+        iter = g_hash_table_lookup (panel->priv->rows_by_id, id);
+        if (iter == NULL)
+                return NULL;
+
         model = GTK_TREE_MODEL (gtk_builder_get_object (panel->priv->builder,
                                                         "liststore_devices"));
-        ret = gtk_tree_model_get_iter_first (model, &iter);
-        if (!ret)
-                goto out;
+        gtk_tree_model_get (model, iter,
+                            PANEL_DEVICES_COLUMN_OBJECT, &object,
+                            -1);
+        if (object != NULL)
+                g_object_unref (object);
 
-        /* get the other elements */
-        ret = FALSE;
-        do {
-                gtk_tree_model_get (model, &iter,
-                                    PANEL_DEVICES_COLUMN_OBJECT, &object_tmp,
-                                    -1);
-                if (object_tmp != NULL) {
-                        g_debug ("got %s", net_object_get_id (object_tmp));
-                        if (g_strcmp0 (net_object_get_id (object_tmp), id) == 0)
-                                object = object_tmp;
-                        g_object_unref (object_tmp);
-                }
-        } while (object == NULL && gtk_tree_model_iter_next (model, &iter));
-out:
         if (iter_out)
-                *iter_out = iter;
+                *iter_out = *iter;
         return object;
 }
 
@@ -1048,16 +1132,12 @@ static void
 panel_add_vpn_device (CcNetworkPanel *panel, NMConnection *connection)
 {
         gchar *title;
-        GtkListStore *liststore_devices;
-        GtkTreeIter iter;
         NetVpn *net_vpn;
         const gchar *id;
-        GtkNotebook *notebook;
-        GtkSizeGroup *size_group;
 
         /* does already exist */
         id = nm_connection_get_path (connection);
-        if (find_in_model_by_id (panel, id, NULL) != NULL)
+        if (g_hash_table_contains (panel->priv->rows_by_id, id))
                 return;
 
         /* add as a VPN object */
@@ -1071,26 +1151,10 @@ panel_add_vpn_device (CcNetworkPanel *panel, NMConnection *connection)
         g_signal_connect_object (net_vpn, "removed",
                                  G_CALLBACK (object_removed_cb), panel, 0);
 
-        /* add as a panel */
-        notebook = GTK_NOTEBOOK (gtk_builder_get_object (panel->priv->builder,
-                                                         "notebook_types"));
-        size_group = GTK_SIZE_GROUP (gtk_builder_get_object (panel->priv->builder,
-                                                             "sizegroup1"));
-        net_object_add_to_notebook (NET_OBJECT (net_vpn),
-                                    notebook,
-                                    size_group);
-
-        liststore_devices = GTK_LIST_STORE (gtk_builder_get_object (panel->priv->builder,
-                                            "liststore_devices"));
         title = g_strdup_printf (_("%s VPN"), nm_connection_get_id (connection));
 
         net_object_set_title (NET_OBJECT (net_vpn), title);
-        gtk_list_store_append (liststore_devices, &iter);
-        gtk_list_store_set (liststore_devices,
-                            &iter,
-                            PANEL_DEVICES_COLUMN_ICON, "xsi-network-vpn-symbolic",
-                            PANEL_DEVICES_COLUMN_OBJECT, net_vpn,
-                            -1);
+        panel_append_row (panel, "xsi-network-vpn-symbolic", NET_OBJECT (net_vpn));
         g_signal_connect (net_vpn, "notify::title",
                           G_CALLBACK (panel_net_object_notify_title_cb), panel);
 
@@ -1140,7 +1204,7 @@ panel_check_network_manager_version (CcNetworkPanel *panel)
         const gchar *version;
 
         /* parse running version */
-        version = nm_client_get_version (panel->priv->client);
+        version = panel->priv->client ? nm_client_get_version (panel->priv->client) : NULL;
         if (version == NULL) {
                 gtk_container_remove (GTK_CONTAINER (panel), gtk_bin_get_child (GTK_BIN (panel)));
 
@@ -1209,11 +1273,302 @@ static void
 on_toplevel_map (GtkWidget      *widget,
                  CcNetworkPanel *panel)
 {
+        /* wait for the clients, see panel_clients_ready() */
+        if (panel->priv->n_pending_clients > 0)
+                return;
+
         /* is the user compiling against a new version, but not running
          * the daemon? */
         panel_check_network_manager_version (panel);
 }
 
+static void
+panel_clients_ready (CcNetworkPanel *panel)
+{
+        CcNetworkPanelPrivate *priv = panel->priv;
+        const GPtrArray *connections;
+        GtkWidget *widget;
+        guint i;
+
+        if (priv->client != NULL) {
+                g_signal_connect (priv->client, "notify::nm-running" ,
+                                  G_CALLBACK (manager_running), panel);
+                g_signal_connect (priv->client, "notify::active-connections",
+                                  G_CALLBACK (active_connections_changed), panel);
+                g_signal_connect (priv->client, "device-added",
+                                  G_CALLBACK (device_added_cb), panel);
+                g_signal_connect (priv->client, "device-removed",
+                                  G_CALLBACK (device_removed_cb), panel);
+                g_signal_connect_swapped (priv->settings, "changed::show-virtual-devices",
+                                          G_CALLBACK (panel_sync_devices), panel);
+
+                /* add remote settings such as VPN settings as virtual devices */
+                g_signal_connect (priv->client, NM_CLIENT_CONNECTION_ADDED,
+                                  G_CALLBACK (notify_connection_added_cb), panel);
+
+                widget = GTK_WIDGET (gtk_builder_get_object (priv->builder,
+                                                             "add_toolbutton"));
+                gtk_widget_set_sensitive (widget, TRUE);
+
+                /* Cold-plug existing connections */
+                connections = nm_client_get_connections (priv->client);
+                if (connections) {
+                        for (i = 0; i < connections->len; i++)
+                                add_connection (panel, connections->pdata[i]);
+                }
+        }
+
+        /* devices are cold-plugged once the panel is shown */
+        if (gtk_widget_get_mapped (GTK_WIDGET (panel)))
+                panel_check_network_manager_version (panel);
+}
+
+static void
+client_ready_cb (GObject      *source_object,
+                 GAsyncResult *res,
+                 gpointer      user_data)
+{
+        CcNetworkPanel *panel;
+        NMClient *client;
+        GError *error = NULL;
+
+        client = nm_client_new_finish (res, &error);
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+                g_error_free (error);
+                return;
+        }
+
+        panel = CC_NETWORK_PANEL (user_data);
+        if (client == NULL) {
+                g_warning ("Error connecting to NetworkManager: %s",
+                           error->message);
+                g_clear_error (&error);
+        }
+        panel->priv->client = client;
+
+        if (--panel->priv->n_pending_clients == 0)
+                panel_clients_ready (panel);
+}
+
+#ifdef BUILD_MODEM
+static void
+modem_manager_ready_cb (GObject      *source_object,
+                        GAsyncResult *res,
+                        gpointer      user_data)
+{
+        CcNetworkPanel *panel;
+        MMManager *modem_manager;
+        GError *error = NULL;
+
+        modem_manager = mm_manager_new_finish (res, &error);
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+                g_error_free (error);
+                return;
+        }
+
+        panel = CC_NETWORK_PANEL (user_data);
+        if (modem_manager == NULL) {
+                g_warning ("Error connecting to ModemManager: %s",
+                           error->message);
+                g_clear_error (&error);
+        }
+        panel->priv->modem_manager = modem_manager;
+
+        if (--panel->priv->n_pending_clients == 0)
+                panel_clients_ready (panel);
+}
+
+static void
+system_bus_ready_cb (GObject      *source_object,
+                     GAsyncResult *res,
+                     gpointer      user_data)
+{
+        CcNetworkPanel *panel;
+        GDBusConnection *system_bus;
+        GError *error = NULL;
+
+        system_bus = g_bus_get_finish (res, &error);
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+                g_error_free (error);
+                return;
+        }
+
+        panel = CC_NETWORK_PANEL (user_data);
+        if (system_bus == NULL) {
+                g_warning ("Error connecting to system D-Bus: %s",
+                           error->message);
+                g_clear_error (&error);
+
+                if (--panel->priv->n_pending_clients == 0)
+                        panel_clients_ready (panel);
+                return;
+        }
+
+        mm_manager_new (system_bus,
+                        G_DBUS_OBJECT_MANAGER_CLIENT_FLAGS_NONE,
+                        panel->priv->cancellable,
+                        modem_manager_ready_cb,
+                        panel);
+        g_object_unref (system_bus);
+}
+#endif
+
+static void
+modify_system_allowed_cb (GPermission    *permission,
+                          GParamSpec     *pspec,
+                          CcNetworkPanel *panel)
+{
+        panel->priv->allowed_to_modify_system = g_permission_get_allowed (permission);
+}
+
+static void
+modify_system_permission_ready_cb (GObject      *source_object,
+                                   GAsyncResult *res,
+                                   gpointer      user_data)
+{
+        CcNetworkPanel *panel;
+        GPermission *permission;
+        GError *error = NULL;
+
+        permission = polkit_permission_new_finish (res, &error);
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+                g_error_free (error);
+                return;
+        }
+
+        if (permission == NULL) {
+                g_warning ("Cannot create permission for system connections: %s",
+                           error->message);
+                g_error_free (error);
+                return;
+        }
+
+        panel = CC_NETWORK_PANEL (user_data);
+        panel->priv->modify_system_permission = permission;
+        g_signal_connect (permission, "notify::allowed",
+                          G_CALLBACK (modify_system_allowed_cb), panel);
+        modify_system_allowed_cb (permission, NULL, panel);
+}
+
+static void
+set_pretty_hostname (CcNetworkPanel *panel, GVariant *value)
+{
+        g_free (panel->priv->pretty_hostname);
+        panel->priv->pretty_hostname = g_variant_dup_string (value, NULL);
+}
+
+/* hostnamed exits when idle, which empties the proxy's cache; the copy
+ * is only replaced by actual changes, never by the invalidation */
+static void
+hostname_properties_changed_cb (GDBusProxy      *proxy,
+                                GVariant        *changed_properties,
+                                const gchar    **invalidated_properties,
+                                CcNetworkPanel  *panel)
+{
+        GVariant *value;
+
+        value = g_variant_lookup_value (changed_properties, "PrettyHostname", G_VARIANT_TYPE_STRING);
+        if (value == NULL)
+                return;
+
+        set_pretty_hostname (panel, value);
+        g_variant_unref (value);
+}
+
+static void
+pretty_hostname_get_cb (GObject      *source_object,
+                        GAsyncResult *res,
+                        gpointer      user_data)
+{
+        GVariant *result;
+        GVariant *value;
+        GError *error = NULL;
+
+        result = g_dbus_proxy_call_finish (G_DBUS_PROXY (source_object), res, &error);
+        if (result == NULL) {
+                if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+                        g_warning ("Getting pretty hostname failed: %s", error->message);
+                g_error_free (error);
+                return;
+        }
+
+        g_variant_get (result, "(v)", &value);
+        if (g_variant_is_of_type (value, G_VARIANT_TYPE_STRING))
+                set_pretty_hostname (CC_NETWORK_PANEL (user_data), value);
+        g_variant_unref (value);
+        g_variant_unref (result);
+}
+
+static void
+hostname_proxy_ready_cb (GObject      *source_object,
+                         GAsyncResult *res,
+                         gpointer      user_data)
+{
+        CcNetworkPanel *panel;
+        GDBusProxy *proxy;
+        GVariant *value;
+        GError *error = NULL;
+
+        proxy = g_dbus_proxy_new_for_bus_finish (res, &error);
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+                g_error_free (error);
+                return;
+        }
+
+        if (proxy == NULL) {
+                g_warning ("Cannot connect to hostnamed: %s", error->message);
+                g_error_free (error);
+                return;
+        }
+
+        panel = CC_NETWORK_PANEL (user_data);
+        panel->priv->hostname_proxy = proxy;
+        g_signal_connect (proxy, "g-properties-changed",
+                          G_CALLBACK (hostname_properties_changed_cb), panel);
+
+        value = g_dbus_proxy_get_cached_property (proxy, "PrettyHostname");
+        if (value != NULL) {
+                set_pretty_hostname (panel, value);
+                g_variant_unref (value);
+                return;
+        }
+
+        /* not loaded with the proxy, e.g. hostnamed was still starting */
+        g_dbus_proxy_call (proxy,
+                           "org.freedesktop.DBus.Properties.Get",
+                           g_variant_new ("(ss)", "org.freedesktop.hostname1", "PrettyHostname"),
+                           G_DBUS_CALL_FLAGS_NONE,
+                           -1,
+                           panel->priv->cancellable,
+                           pretty_hostname_get_cb,
+                           panel);
+}
+
+/**
+ * cc_network_panel_get_allowed_to_modify_system:
+ *
+ * Whether the user may add system-wide connections, FALSE while polkit
+ * has not answered yet.
+ **/
+gboolean
+cc_network_panel_get_allowed_to_modify_system (CcNetworkPanel *panel)
+{
+        g_return_val_if_fail (CC_IS_NETWORK_PANEL (panel), FALSE);
+        return panel->priv->allowed_to_modify_system;
+}
+
+/**
+ * cc_network_panel_dup_pretty_hostname:
+ *
+ * Returns: the pretty hostname, or NULL if hostnamed is not (yet) known
+ **/
+gchar *
+cc_network_panel_dup_pretty_hostname (CcNetworkPanel *panel)
+{
+        g_return_val_if_fail (CC_IS_NETWORK_PANEL (panel), NULL);
+        return g_strdup (panel->priv->pretty_hostname);
+}
+
 static void
 cc_network_panel_init (CcNetworkPanel *panel)
 {
@@ -1222,10 +1577,7 @@ cc_network_panel_init (CcNetworkPanel *panel)
         GtkTreeSelection *selection;
         GtkWidget *widget;
         GtkWidget *toplevel;
-        GDBusConnection *system_bus;
         GtkCssProvider *provider;
-        const GPtrArray *connections;
-        guint i;
 
         panel->priv = NETWORK_PANEL_PRIVATE (panel);
         g_resources_register (cc_network_get_resource ());
@@ -1241,6 +1593,9 @@ cc_network_panel_init (CcNetworkPanel *panel)
         }
 
         panel->priv->cancellable = g_cancellable_new ();
+        panel->priv->rows_by_id = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                         g_free, (GDestroyNotify) gtk_tree_iter_free);
+        panel->priv->settings = g_settings_new ("org.cinnamon.control-center.network");
 
         panel->priv->treeview = GTK_WIDGET (gtk_builder_get_object (panel->priv->builder,
                                                                     "treeview_devices"));
@@ -1264,42 +1619,40 @@ cc_network_panel_init (CcNetworkPanel *panel)
         /* add the virtual proxy device */
         panel_add_proxy_device (panel);
 
-        /* use NetworkManager client */
-        panel->priv->client = nm_client_new (NULL, NULL);
-        g_signal_connect (panel->priv->client, "notify::nm-running" ,
-                          G_CALLBACK (manager_running), panel);
-        g_signal_connect (panel->priv->client, "notify::active-connections",
-                          G_CALLBACK (active_connections_changed), panel);
-        g_signal_connect (panel->priv->client, "device-added",
-                          G_CALLBACK (device_added_cb), panel);
-        g_signal_connect (panel->priv->client, "device-removed",
-                          G_CALLBACK (device_removed_cb), panel);
+        /* use NetworkManager client; until it and the ModemManager one
+         * are ready the panel only lists the proxy, see panel_clients_ready() */
+        panel->priv->n_pending_clients++;
+        nm_client_new_async (panel->priv->cancellable, client_ready_cb, panel);
 
 #ifdef BUILD_MODEM
         /* Setup ModemManager client */
-        system_bus = g_bus_get_sync (G_BUS_TYPE_SYSTEM, NULL, &error);
-        if (system_bus == NULL) {
-                g_warning ("Error connecting to system D-Bus: %s",
-                           error->message);
-                g_clear_error (&error);
-        } else {
-                panel->priv->modem_manager = mm_manager_new_sync (system_bus,
-                                                                  G_DBUS_OBJECT_MANAGER_CLIENT_FLAGS_NONE,
-                                                                  NULL,
-                                                                  &error);
-                if (panel->priv->modem_manager == NULL) {
-                        g_warning ("Error connecting to ModemManager: %s",
-                                   error->message);
-                        g_clear_error (&error);
-                }
-                g_object_unref (system_bus);
-        }
+        panel->priv->n_pending_clients++;
+        g_bus_get (G_BUS_TYPE_SYSTEM, panel->priv->cancellable,
+                   system_bus_ready_cb, panel);
 #else
         panel->priv->modem_manager = NULL;
 #endif
 
+        /* for the Wi-Fi pages, so connecting or starting a hotspot does
+         * not wait on polkit or hostnamed */
+        polkit_permission_new ("org.freedesktop.NetworkManager.settings.modify.system",
+                               NULL,
+                               panel->priv->cancellable,
+                               modify_system_permission_ready_cb,
+                               panel);
+        g_dbus_proxy_new_for_bus (G_BUS_TYPE_SYSTEM,
+                                  G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS,
+                                  NULL,
+                                  "org.freedesktop.hostname1",
+                                  "/org/freedesktop/hostname1",
+                                  "org.freedesktop.hostname1",
+                                  panel->priv->cancellable,
+                                  hostname_proxy_ready_cb,
+                                  panel);
+
         widget = GTK_WIDGET (gtk_builder_get_object (panel->priv->builder,
                                                      "add_toolbutton"));
+        gtk_widget_set_sensitive (widget, FALSE);
         g_signal_connect (widget, "clicked",
                           G_CALLBACK (add_connection_cb), panel);
 
@@ -1309,10 +1662,6 @@ cc_network_panel_init (CcNetworkPanel *panel)
         g_signal_connect (widget, "clicked",
                           G_CALLBACK (remove_connection), panel);
 
-        /* add remote settings such as VPN settings as virtual devices */
-        g_signal_connect (panel->priv->client, NM_CLIENT_CONNECTION_ADDED,
-                          G_CALLBACK (notify_connection_added_cb), panel);
-
         toplevel = gtk_widget_get_toplevel (GTK_WIDGET (panel));
         g_signal_connect_after (toplevel, "map", G_CALLBACK (on_toplevel_map), panel);
 
@@ -1331,16 +1680,6 @@ cc_network_panel_init (CcNetworkPanel *panel)
                                                    GTK_STYLE_PROVIDER (provider),
                                                    GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
         g_object_unref (provider);
-
-        /* Cold-plug existing connections */
-        connections = nm_client_get_connections (panel->priv->client);
-        if (connections) {
-                for (i = 0; i < connections->len; i++)
-                        add_connection (panel, connections->pdata[i]);
-        }
-
-        g_debug ("Calling handle_argv() after cold-plugging connections");
-        handle_argv (panel);
 }
 
 void
@@ -66,6 +66,9 @@ GType cc_network_panel_get_type (void) G_GNUC_CONST;
 
 GPtrArray *cc_network_panel_get_devices (CcNetworkPanel *panel);
 
+gboolean cc_network_panel_get_allowed_to_modify_system (CcNetworkPanel *panel);
+gchar *cc_network_panel_dup_pretty_hostname (CcNetworkPanel *panel);
+
 void cc_network_panel_register (GIOModule *module);
 
 G_END_DECLS
@@ -98,7 +98,7 @@ ce_page_8021x_security_new (NMConnection     *connection,
 	                                            connection,
 	                                            client,
 	                                            "/org/cinnamon/control-center/network/8021x-security-page.ui",
-	                                            _("Security")));
+	                                            _(CE_PAGE_8021X_SECURITY_TITLE)));
 
 	if (nm_connection_get_setting_802_1x (connection))
 		page->initial_have_8021x = TRUE;
@@ -57,6 +57,8 @@ struct CEPage8021xSecurityClass {
 
 GType ce_page_8021x_security_get_type (void);
 
+#define CE_PAGE_8021X_SECURITY_TITLE N_("Security")
+
 CEPage *ce_page_8021x_security_new (NMConnection     *connection,
                                     NMClient         *client);
 
@@ -230,7 +230,7 @@ ce_page_details_new (NMConnection     *connection,
                                              connection,
                                              client,
                                              "/org/cinnamon/control-center/network/details-page.ui",
-                                             _("Details")));
+                                             _(CE_PAGE_DETAILS_TITLE)));
 
         page->device = device;
         page->ap = ap;
@@ -54,6 +54,8 @@ struct _CEPageDetailsClass
 
 GType   ce_page_details_get_type (void);
 
+#define CE_PAGE_DETAILS_TITLE N_("Details")
+
 CEPage *ce_page_details_new      (NMConnection     *connection,
                                   NMClient         *client,
                                   NMDevice         *device,
@@ -212,7 +212,7 @@ ce_page_ethernet_new (NMConnection     *connection,
                                               connection,
                                               client,
                                               "/org/cinnamon/control-center/network/ethernet-page.ui",
-                                              _("Identity")));
+                                              _(CE_PAGE_ETHERNET_TITLE)));
 
         page->name = GTK_ENTRY (gtk_builder_get_object (CE_PAGE (page)->builder, "entry_name"));
         page->device_mac = GTK_COMBO_BOX_TEXT (gtk_builder_get_object (CE_PAGE (page)->builder, "combo_mac"));
@@ -62,6 +62,8 @@ struct _CEPageEthernetClass
 
 GType   ce_page_ethernet_get_type (void);
 
+#define CE_PAGE_ETHERNET_TITLE N_("Identity")
+
 CEPage *ce_page_ethernet_new      (NMConnection     *connection,
                                    NMClient         *client);
 
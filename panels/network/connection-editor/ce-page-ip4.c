@@ -977,7 +977,7 @@ ce_page_ip4_new (NMConnection     *connection,
                                            connection,
                                            client,
                                            "/org/cinnamon/control-center/network/ip4-page.ui",
-                                           _("IPv4")));
+                                           _(CE_PAGE_IP4_TITLE)));
 
         page->setting = nm_connection_get_setting_ip4_config (connection);
         if (!page->setting) {
@@ -62,6 +62,8 @@ struct _CEPageIP4Class
 
 GType   ce_page_ip4_get_type (void);
 
+#define CE_PAGE_IP4_TITLE N_("IPv4")
+
 CEPage *ce_page_ip4_new      (NMConnection     *connection,
                               NMClient         *client);
 
@@ -895,7 +895,7 @@ ce_page_ip6_new (NMConnection     *connection,
                                            connection,
                                            client,
                                            "/org/cinnamon/control-center/network/ip6-page.ui",
-                                           _("IPv6")));
+                                           _(CE_PAGE_IP6_TITLE)));
 
         page->setting = nm_connection_get_setting_ip6_config (connection);
         if (!page->setting) {
@@ -62,6 +62,8 @@ struct _CEPageIP6Class
 
 GType   ce_page_ip6_get_type (void);
 
+#define CE_PAGE_IP6_TITLE N_("IPv6")
+
 CEPage *ce_page_ip6_new      (NMConnection     *connection,
                               NMClient         *client);
 
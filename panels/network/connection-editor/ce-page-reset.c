@@ -75,7 +75,7 @@ ce_page_reset_new (NMConnection        *connection,
                                            connection,
                                            client,
                                            "/org/cinnamon/control-center/network/reset-page.ui",
-                                           _("Reset")));
+                                           _(CE_PAGE_RESET_TITLE)));
         page->editor = editor;
 
         connect_reset_page (page);
@@ -54,6 +54,8 @@ struct _CEPageResetClass
 
 GType   ce_page_reset_get_type (void);
 
+#define CE_PAGE_RESET_TITLE N_("Reset")
+
 CEPage *ce_page_reset_new      (NMConnection        *connection,
                                 NMClient            *client,
                                 NetConnectionEditor *editor);
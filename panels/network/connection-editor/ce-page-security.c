@@ -497,7 +497,7 @@ ce_page_security_new (NMConnection      *connection,
                                               connection,
                                               client,
                                               "/org/cinnamon/control-center/network/security-page.ui",
-                                              _("Security")));
+                                              _(CE_PAGE_SECURITY_TITLE)));
 
         sws = nm_connection_get_setting_wireless_security (connection);
         if (sws)
@@ -58,6 +58,8 @@ struct _CEPageSecurityClass
 
 GType   ce_page_security_get_type (void);
 
+#define CE_PAGE_SECURITY_TITLE N_("Security")
+
 CEPage *ce_page_security_new      (NMConnection     *connection,
                                    NMClient         *client);
 
@@ -223,7 +223,7 @@ ce_page_vpn_new (NMConnection     *connection,
 					 connection,
 					 client,
 					 "/org/cinnamon/control-center/network/vpn-page.ui",
-					 _("Identity")));
+					 _(CE_PAGE_VPN_TITLE)));
 
         page->name = GTK_ENTRY (gtk_builder_get_object (CE_PAGE (page)->builder, "entry_name"));
         page->box = GTK_BOX (gtk_builder_get_object (CE_PAGE (page)->builder, "page"));
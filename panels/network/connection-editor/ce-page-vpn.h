@@ -62,6 +62,8 @@ struct _CEPageVpnClass
 
 GType   ce_page_vpn_get_type (void);
 
+#define CE_PAGE_VPN_TITLE N_("Identity")
+
 CEPage *ce_page_vpn_new      (NMConnection     *connection,
 			      NMClient         *client);
 
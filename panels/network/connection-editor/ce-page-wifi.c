@@ -224,7 +224,7 @@ ce_page_wifi_new (NMConnection     *connection,
                                           connection,
                                           client,
                                           "/org/cinnamon/control-center/network/wifi-page.ui",
-                                          _("Identity")));
+                                          _(CE_PAGE_WIFI_TITLE)));
 
         page->setting = nm_connection_get_setting_wireless (connection);
 
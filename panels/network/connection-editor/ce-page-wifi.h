@@ -53,6 +53,8 @@ struct _CEPageWifiClass
 
 GType   ce_page_wifi_get_type (void);
 
+#define CE_PAGE_WIFI_TITLE N_("Identity")
+
 CEPage *ce_page_wifi_new      (NMConnection     *connection,
                                NMClient         *client);
 
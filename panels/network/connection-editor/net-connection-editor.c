@@ -50,23 +50,84 @@ static guint signals[LAST_SIGNAL] = { 0 };
 
 G_DEFINE_TYPE (NetConnectionEditor, net_connection_editor, G_TYPE_OBJECT)
 
+typedef enum {
+        PAGE_DETAILS,
+        PAGE_SECURITY,
+        PAGE_8021X_SECURITY,
+        PAGE_WIFI,
+        PAGE_ETHERNET,
+        PAGE_VPN,
+        PAGE_IP4,
+        PAGE_IP6,
+        PAGE_RESET
+} PageKind;
+
+typedef struct {
+        PageKind  kind;
+        CEPage   *page;
+
+        /* the last ce_page_validate() result, redone once the page
+         * changed since */
+        gboolean  dirty;
+        gboolean  valid;
+} PageSlot;
+
 static void page_changed (CEPage *page, gpointer user_data);
+static void page_initialized (CEPage *page, GError *error, NetConnectionEditor *editor);
+static void ensure_page (NetConnectionEditor *editor, gint position);
 
-static void
-selection_changed (GtkTreeSelection *selection, NetConnectionEditor *editor)
+static gint
+get_selected_position (NetConnectionEditor *editor)
 {
-        GtkWidget *widget;
+        GtkTreeSelection *selection;
         GtkTreeModel *model;
         GtkTreeIter iter;
-        gint page;
+        gint position;
 
+        selection = GTK_TREE_SELECTION (gtk_builder_get_object (editor->builder,
+                                                                "details_page_list_selection"));
         if (!gtk_tree_selection_get_selected (selection, &model, &iter))
+                return -1;
+        gtk_tree_model_get (model, &iter, 1, &position, -1);
+
+        return position;
+}
+
+/* shows the selected page, if it is built and initialized */
+static void
+show_selected_page (NetConnectionEditor *editor)
+{
+        GtkNotebook *notebook;
+        PageSlot *slot;
+        gint position;
+        gint num;
+
+        position = get_selected_position (editor);
+        if (position < 0 || editor->page_slots == NULL ||
+            position >= (gint) editor->page_slots->len)
+                return;
+
+        slot = &g_array_index (editor->page_slots, PageSlot, position);
+        if (slot->page == NULL || !ce_page_get_initialized (slot->page))
                 return;
-        gtk_tree_model_get (model, &iter, 1, &page, -1);
 
-        widget = GTK_WIDGET (gtk_builder_get_object (editor->builder,
-                                                     "details_notebook"));
-        gtk_notebook_set_current_page (GTK_NOTEBOOK (widget), page);
+        notebook = GTK_NOTEBOOK (gtk_builder_get_object (editor->builder, "details_notebook"));
+        num = gtk_notebook_page_num (notebook, ce_page_get_page (slot->page));
+        if (num >= 0)
+                gtk_notebook_set_current_page (notebook, num);
+}
+
+static void
+selection_changed (GtkTreeSelection *selection, NetConnectionEditor *editor)
+{
+        gint position;
+
+        position = get_selected_position (editor);
+        if (position < 0)
+                return;
+
+        ensure_page (editor, position);
+        show_selected_page (editor);
 }
 
 static void
@@ -138,9 +199,56 @@ added_connection_cb (GObject            *source_object,
         update_complete (editor, success);
 }
 
+static gboolean validate_page (NetConnectionEditor *editor, CEPage *page);
+static void validate (NetConnectionEditor *editor);
+static void net_connection_editor_error_dialog (NetConnectionEditor *editor,
+                                                const char *primary_text,
+                                                const char *secondary_text);
+
+/* Every page writes its settings again and the whole connection is
+ * verified; validate() only redoes the pages that changed. */
+static gboolean
+validate_all (NetConnectionEditor *editor, GError **error)
+{
+        gboolean valid = TRUE;
+        guint i;
+
+        for (i = 0; i < editor->page_slots->len; i++) {
+                PageSlot *slot = &g_array_index (editor->page_slots, PageSlot, i);
+
+                if (slot->page == NULL)
+                        continue;
+                slot->valid = validate_page (editor, slot->page);
+                slot->dirty = FALSE;
+                if (!slot->valid)
+                        valid = FALSE;
+        }
+        if (!valid)
+                return FALSE;
+
+        editor->verify_failed = !nm_connection_verify (editor->connection, error);
+
+        return !editor->verify_failed;
+}
+
 static void
 apply_edits (NetConnectionEditor *editor)
 {
+        GError *error = NULL;
+
+        if (!validate_all (editor, &error)) {
+                /* the failure is recorded for validate(), which keeps
+                 * Apply off until the next change */
+                gtk_widget_set_sensitive (GTK_WIDGET (gtk_builder_get_object (editor->builder, "details_apply_button")), FALSE);
+                if (error != NULL) {
+                        net_connection_editor_error_dialog (editor,
+                                                            _("The connection settings are not valid"),
+                                                            error->message);
+                        g_error_free (error);
+                }
+                return;
+        }
+
         update_connection (editor);
 
         eap_method_ca_cert_ignore_save (editor->connection);
@@ -166,6 +274,7 @@ net_connection_editor_init (NetConnectionEditor *editor)
         GError *error = NULL;
         GtkTreeSelection *selection;
 
+        editor->cancellable = g_cancellable_new ();
         editor->builder = gtk_builder_new ();
         gtk_builder_add_from_resource (editor->builder,
                                        "/org/cinnamon/control-center/network/connection-editor.ui",
@@ -205,10 +314,22 @@ static void
 net_connection_editor_finalize (GObject *object)
 {
         NetConnectionEditor *editor = NET_CONNECTION_EDITOR (object);
-        GSList *l;
-
-        for (l = editor->pages; l != NULL; l = l->next)
-                g_signal_handlers_disconnect_by_func (l->data, page_changed, editor);
+        guint i;
+
+        /* pages still waiting for secrets would report back otherwise */
+        g_cancellable_cancel (editor->cancellable);
+        g_clear_object (&editor->cancellable);
+        for (i = 0; editor->page_slots != NULL && i < editor->page_slots->len; i++) {
+                CEPage *page = g_array_index (editor->page_slots, PageSlot, i).page;
+
+                if (page == NULL)
+                        continue;
+                g_signal_handlers_disconnect_by_func (page, page_changed, editor);
+                g_signal_handlers_disconnect_by_func (page, page_initialized, editor);
+        }
+        g_clear_pointer (&editor->page_slots, g_array_unref);
+        if (editor->validate_id != 0)
+                g_source_remove (editor->validate_id);
 
         if (editor->permission_id > 0 && editor->client)
                 g_signal_handler_disconnect (editor->client, editor->permission_id);
@@ -361,28 +482,46 @@ update_sensitivity (NetConnectionEditor *editor)
         }
 }
 
+static gboolean
+validate_page (NetConnectionEditor *editor, CEPage *page)
+{
+        GError *error = NULL;
+
+        if (ce_page_validate (page, editor->connection, &error))
+                return TRUE;
+
+        if (error) {
+                g_debug ("Invalid setting %s: %s", ce_page_get_title (page), error->message);
+                g_error_free (error);
+        } else {
+                g_debug ("Invalid setting %s", ce_page_get_title (page));
+        }
+
+        return FALSE;
+}
+
 static void
 validate (NetConnectionEditor *editor)
 {
         gboolean valid = FALSE;
-        GSList *l;
+        guint i;
 
-        if (!editor_is_initialized (editor))
+        if (!editor_is_initialized (editor) || editor->page_slots == NULL)
                 goto done;
 
-        valid = TRUE;
-        for (l = editor->pages; l; l = l->next) {
-                GError *error = NULL;
+        /* only the pages that changed since they were last validated */
+        valid = !editor->verify_failed;
+        for (i = 0; i < editor->page_slots->len; i++) {
+                PageSlot *slot = &g_array_index (editor->page_slots, PageSlot, i);
 
-                if (!ce_page_validate (CE_PAGE (l->data), editor->connection, &error)) {
-                        valid = FALSE;
-                        if (error) {
-                                g_debug ("Invalid setting %s: %s", ce_page_get_title (CE_PAGE (l->data)), error->message);
-                                g_error_free (error);
-                        } else {
-                                g_debug ("Invalid setting %s", ce_page_get_title (CE_PAGE (l->data)));
-                        }
+                if (slot->page == NULL)
+                        continue;
+                if (slot->dirty) {
+                        slot->valid = validate_page (editor, slot->page);
+                        slot->dirty = FALSE;
                 }
+                if (!slot->valid)
+                        valid = FALSE;
         }
 
         update_sensitivity (editor);
@@ -390,39 +529,53 @@ done:
         gtk_widget_set_sensitive (GTK_WIDGET (gtk_builder_get_object (editor->builder, "details_apply_button")), valid && editor->is_changed);
 }
 
-static void
-page_changed (CEPage *page, gpointer user_data)
+static gboolean
+idle_validate (gpointer user_data)
 {
-        NetConnectionEditor *editor= user_data;
+        NetConnectionEditor *editor = NET_CONNECTION_EDITOR (user_data);
 
-        if (editor_is_initialized (editor))
-                editor->is_changed = TRUE;
+        editor->validate_id = 0;
         validate (editor);
+
+        return G_SOURCE_REMOVE;
 }
 
-static gboolean
-idle_validate (gpointer user_data)
+/* keystrokes arriving together are validated once */
+static void
+queue_validate (NetConnectionEditor *editor)
 {
-        validate (NET_CONNECTION_EDITOR (user_data));
+        if (editor->validate_id == 0)
+                editor->validate_id = g_idle_add (idle_validate, editor);
+}
 
-        return G_SOURCE_REMOVE;
+static void
+page_changed (CEPage *page, gpointer user_data)
+{
+        NetConnectionEditor *editor= user_data;
+        gint position;
+
+        position = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (page), "position"));
+        g_array_index (editor->page_slots, PageSlot, position).dirty = TRUE;
+        editor->verify_failed = FALSE;
+
+        /* a page being set up reports its initial values */
+        if (g_slist_find (editor->initializing_pages, page) == NULL)
+                editor->is_changed = TRUE;
+        queue_validate (editor);
 }
 
 static void
 recheck_initialization (NetConnectionEditor *editor)
 {
-        GtkNotebook *notebook;
-
         if (!editor_is_initialized (editor))
                 return;
 
-        notebook = GTK_NOTEBOOK (gtk_builder_get_object (editor->builder, "details_notebook"));
-        gtk_notebook_set_current_page (notebook, 0);
+        show_selected_page (editor);
 
         if (editor->show_when_initialized)
                 gtk_window_present (GTK_WINDOW (editor->window));
 
-        g_idle_add (idle_validate, editor);
+        queue_validate (editor);
 }
 
 static void
@@ -497,39 +650,131 @@ get_secrets_for_page (NetConnectionEditor *editor,
 
         nm_remote_connection_get_secrets_async (NM_REMOTE_CONNECTION (editor->orig_connection),
                                                 setting_name,
-                                                NULL, //FIXME
+                                                editor->cancellable,
                                                 get_secrets_cb,
                                                 info);
 }
 
+/* the titles the pages give themselves, for listing them unbuilt */
+static const gchar *
+page_kind_get_title (PageKind kind)
+{
+        switch (kind) {
+        case PAGE_DETAILS:
+                return _(CE_PAGE_DETAILS_TITLE);
+        case PAGE_SECURITY:
+                return _(CE_PAGE_SECURITY_TITLE);
+        case PAGE_8021X_SECURITY:
+                return _(CE_PAGE_8021X_SECURITY_TITLE);
+        case PAGE_WIFI:
+                return _(CE_PAGE_WIFI_TITLE);
+        case PAGE_ETHERNET:
+                return _(CE_PAGE_ETHERNET_TITLE);
+        case PAGE_VPN:
+                return _(CE_PAGE_VPN_TITLE);
+        case PAGE_IP4:
+                return _(CE_PAGE_IP4_TITLE);
+        case PAGE_IP6:
+                return _(CE_PAGE_IP6_TITLE);
+        case PAGE_RESET:
+                return _(CE_PAGE_RESET_TITLE);
+        default:
+                g_assert_not_reached ();
+        }
+}
+
+static CEPage *
+page_kind_new_page (NetConnectionEditor *editor, PageKind kind)
+{
+        switch (kind) {
+        case PAGE_DETAILS:
+                return ce_page_details_new (editor->connection, editor->client, editor->device, editor->ap);
+        case PAGE_SECURITY:
+                return ce_page_security_new (editor->connection, editor->client);
+        case PAGE_8021X_SECURITY:
+                return ce_page_8021x_security_new (editor->connection, editor->client);
+        case PAGE_WIFI:
+                return ce_page_wifi_new (editor->connection, editor->client);
+        case PAGE_ETHERNET:
+                return ce_page_ethernet_new (editor->connection, editor->client);
+        case PAGE_VPN:
+                return ce_page_vpn_new (editor->connection, editor->client);
+        case PAGE_IP4:
+                return ce_page_ip4_new (editor->connection, editor->client);
+        case PAGE_IP6:
+                return ce_page_ip6_new (editor->connection, editor->client);
+        case PAGE_RESET:
+                return ce_page_reset_new (editor->connection, editor->client, editor);
+        default:
+                g_assert_not_reached ();
+        }
+}
+
 static void
-add_page (NetConnectionEditor *editor, CEPage *page)
+add_page (NetConnectionEditor *editor, PageKind kind)
 {
         GtkListStore *store;
         GtkTreeIter iter;
-        const gchar *title;
-        gint position;
+        PageSlot slot = { kind, NULL, TRUE, FALSE };
 
         store = GTK_LIST_STORE (gtk_builder_get_object (editor->builder,
                                                 "details_store"));
-        title = ce_page_get_title (page);
-        position = g_slist_length (editor->initializing_pages);
-        g_object_set_data (G_OBJECT (page), "position", GINT_TO_POINTER (position));
         gtk_list_store_insert_with_values (store, &iter, -1,
-                                           0, title,
-                                           1, position,
+                                           0, page_kind_get_title (kind),
+                                           1, editor->page_slots->len,
                                            -1);
+        g_array_append_val (editor->page_slots, slot);
+}
+
+/* Builds the page at @position the first time it is shown; only then are
+ * its secrets fetched. Pages never shown leave their settings as they are. */
+static void
+ensure_page (NetConnectionEditor *editor, gint position)
+{
+        PageSlot *slot;
+        CEPage *page;
+        const gchar *security_setting;
+
+        slot = &g_array_index (editor->page_slots, PageSlot, position);
+        if (slot->page != NULL)
+                return;
+
+        page = page_kind_new_page (editor, slot->kind);
+        if (page == NULL)
+                return;
+        slot->page = page;
+
+        g_object_set_data (G_OBJECT (page), "position", GINT_TO_POINTER (position));
         editor->initializing_pages = g_slist_append (editor->initializing_pages, page);
 
         g_signal_connect (page, "changed", G_CALLBACK (page_changed), editor);
         g_signal_connect (page, "initialized", G_CALLBACK (page_initialized), editor);
+
+        security_setting = ce_page_get_security_setting (page);
+        if (!security_setting || editor->is_new_connection)
+                ce_page_complete_init (page, NULL, NULL, NULL);
+        else
+                get_secrets_for_page (editor, page, security_setting);
+}
+
+static void
+ensure_ip_setting (NMConnection      *connection,
+                   NMSettingIPConfig *setting,
+                   GType              setting_type,
+                   const gchar       *default_method)
+{
+        if (setting == NULL) {
+                setting = NM_SETTING_IP_CONFIG (g_object_new (setting_type, NULL));
+                nm_connection_add_setting (connection, NM_SETTING (setting));
+        }
+        if (nm_setting_ip_config_get_method (setting) == NULL)
+                g_object_set (setting, NM_SETTING_IP_CONFIG_METHOD, default_method, NULL);
 }
 
 static void
 net_connection_editor_set_connection (NetConnectionEditor *editor,
                                       NMConnection        *connection)
 {
-        GSList *pages, *l;
         NMSettingConnection *sc;
         const gchar *type;
         GtkTreeSelection *selection;
@@ -556,45 +801,51 @@ net_connection_editor_set_connection (NetConnectionEditor *editor,
         sc = nm_connection_get_setting_connection (connection);
         type = nm_setting_connection_get_connection_type (sc);
 
+        /* unsupported types go to nm-connection-editor before any page */
+        if (strcmp (type, NM_SETTING_WIRELESS_SETTING_NAME) != 0 &&
+            strcmp (type, NM_SETTING_WIRED_SETTING_NAME) != 0 &&
+            strcmp (type, NM_SETTING_VPN_SETTING_NAME) != 0) {
+                net_connection_editor_do_fallback (editor, type);
+                return;
+        }
+
+        /* the IP pages add these when built and write "auto" when there
+         * is no method; do it now so that the connection is the same
+         * whether or not they are shown */
+        ensure_ip_setting (editor->connection,
+                           NM_SETTING_IP_CONFIG (nm_connection_get_setting_ip4_config (editor->connection)),
+                           NM_TYPE_SETTING_IP4_CONFIG,
+                           NM_SETTING_IP4_CONFIG_METHOD_AUTO);
+        ensure_ip_setting (editor->connection,
+                           NM_SETTING_IP_CONFIG (nm_connection_get_setting_ip6_config (editor->connection)),
+                           NM_TYPE_SETTING_IP6_CONFIG,
+                           NM_SETTING_IP6_CONFIG_METHOD_AUTO);
+
+        editor->page_slots = g_array_new (FALSE, FALSE, sizeof (PageSlot));
+
         if (!editor->is_new_connection)
-                add_page (editor, ce_page_details_new (editor->connection, editor->client, editor->device, editor->ap));
+                add_page (editor, PAGE_DETAILS);
 
         if (strcmp (type, NM_SETTING_WIRELESS_SETTING_NAME) == 0)
-                add_page (editor, ce_page_security_new (editor->connection, editor->client));
+                add_page (editor, PAGE_SECURITY);
         else if (strcmp (type, NM_SETTING_WIRED_SETTING_NAME) == 0)
-                add_page (editor, ce_page_8021x_security_new (editor->connection, editor->client));
+                add_page (editor, PAGE_8021X_SECURITY);
 
         if (strcmp (type, NM_SETTING_WIRELESS_SETTING_NAME) == 0)
-                add_page (editor, ce_page_wifi_new (editor->connection, editor->client));
+                add_page (editor, PAGE_WIFI);
         else if (strcmp (type, NM_SETTING_WIRED_SETTING_NAME) == 0)
-                add_page (editor, ce_page_ethernet_new (editor->connection, editor->client));
-        else if (strcmp (type, NM_SETTING_VPN_SETTING_NAME) == 0)
-                add_page (editor, ce_page_vpn_new (editor->connection, editor->client));
-        else {
-                /* Unsupported type */
-                net_connection_editor_do_fallback (editor, type);
-                return;
-        }
+                add_page (editor, PAGE_ETHERNET);
+        else
+                add_page (editor, PAGE_VPN);
 
-        add_page (editor, ce_page_ip4_new (editor->connection, editor->client));
-        add_page (editor, ce_page_ip6_new (editor->connection, editor->client));
+        add_page (editor, PAGE_IP4);
+        add_page (editor, PAGE_IP6);
 
         if (!editor->is_new_connection)
-                add_page (editor, ce_page_reset_new (editor->connection, editor->client, editor));
-
-        pages = g_slist_copy (editor->initializing_pages);
-        for (l = pages; l; l = l->next) {
-                CEPage *page = l->data;
-                const gchar *security_setting;
+                add_page (editor, PAGE_RESET);
 
-                security_setting = ce_page_get_security_setting (page);
-                if (!security_setting || editor->is_new_connection) {
-                        ce_page_complete_init (page, NULL, NULL, NULL);
-                } else {
-                        get_secrets_for_page (editor, page, security_setting);
-                }
-        }
-        g_slist_free (pages);
+        /* only the first page is built now, the rest when selected */
+        ensure_page (editor, 0);
 
         selection = GTK_TREE_SELECTION (gtk_builder_get_object (editor->builder,
                                                                 "details_page_list_selection"));
@@ -870,6 +1121,10 @@ net_connection_editor_new (GtkWindow        *parent_window,
 void
 net_connection_editor_present (NetConnectionEditor *editor)
 {
+        /* handed over to nm-connection-editor */
+        if (editor->connection != NULL && editor->page_slots == NULL)
+                return;
+
         if (!editor_is_initialized (editor)) {
                 editor->show_when_initialized = TRUE;
                 return;
@@ -909,10 +1164,16 @@ void
 net_connection_editor_reset (NetConnectionEditor *editor)
 {
         GVariant *settings;
+        guint i;
 
         settings = nm_connection_to_dbus (editor->orig_connection, NM_CONNECTION_SERIALIZE_ALL);
         nm_connection_replace_settings (editor->connection, settings, NULL);
         g_variant_unref (settings);
+
+        /* every page has to be looked at again */
+        for (i = 0; editor->page_slots != NULL && i < editor->page_slots->len; i++)
+                g_array_index (editor->page_slots, PageSlot, i).dirty = TRUE;
+        queue_validate (editor);
 }
 
 void
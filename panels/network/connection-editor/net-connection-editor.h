@@ -59,6 +59,17 @@ struct _NetConnectionEditor
         GSList *initializing_pages;
         GSList *pages;
 
+        /* the pages listed in details_store, by position; each is built
+         * when first selected */
+        GArray *page_slots;
+        guint   validate_id;
+
+        /* nm_connection_verify() failed on Apply, until the next change */
+        gboolean verify_failed;
+
+        /* secrets being fetched for pages */
+        GCancellable *cancellable;
+
         guint                    permission_id;
         NMClientPermissionResult can_modify;
 
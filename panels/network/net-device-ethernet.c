@@ -65,8 +65,10 @@ device_ethernet_add_to_notebook (NetObject    *object,
         return vbox;
 }
 
-static void
-add_details_row (GtkWidget *details, gint top, const gchar *heading, const gchar *value)
+/* returns the value label, whose heading is its "heading" data; both
+ * stay hidden until the row gets a value */
+static GtkWidget *
+add_details_row (GtkWidget *details, gint top, const gchar *heading)
 {
         GtkWidget *heading_label;
         GtkWidget *value_label;
@@ -76,16 +78,41 @@ add_details_row (GtkWidget *details, gint top, const gchar *heading, const gchar
         gtk_widget_set_halign (heading_label, GTK_ALIGN_END);
         gtk_widget_set_valign (heading_label, GTK_ALIGN_START);
         gtk_widget_set_hexpand (heading_label, TRUE);
+        gtk_widget_set_no_show_all (heading_label, TRUE);
 
         gtk_grid_attach (GTK_GRID (details), heading_label, 0, top, 1, 1);
 
-        value_label = gtk_label_new (value);
+        value_label = gtk_label_new (NULL);
         gtk_widget_set_halign (value_label, GTK_ALIGN_START);
         gtk_widget_set_hexpand (value_label, TRUE);
+        gtk_widget_set_no_show_all (value_label, TRUE);
 
         gtk_label_set_mnemonic_widget (GTK_LABEL (heading_label), value_label);
 
         gtk_grid_attach (GTK_GRID (details), value_label, 1, top, 1, 1);
+        g_object_set_data (G_OBJECT (value_label), "heading", heading_label);
+
+        return value_label;
+}
+
+static void
+set_details_heading (GtkWidget *value_label, const gchar *heading)
+{
+        GtkWidget *heading_label;
+
+        heading_label = g_object_get_data (G_OBJECT (value_label), "heading");
+        gtk_label_set_label (GTK_LABEL (heading_label), heading);
+}
+
+static void
+set_details_row (GtkWidget *value_label, const gchar *value)
+{
+        GtkWidget *heading_label;
+
+        heading_label = g_object_get_data (G_OBJECT (value_label), "heading");
+        gtk_label_set_label (GTK_LABEL (value_label), value != NULL ? value : "");
+        gtk_widget_set_visible (heading_label, value != NULL);
+        gtk_widget_set_visible (value_label, value != NULL);
 }
 
 static gchar *
@@ -128,66 +155,101 @@ out:
         return last_used;
 }
 
+/* the rows of add_details() that depend on the IP configs */
+typedef struct {
+        GtkWidget *ip4_address;
+        GtkWidget *ip6_address;
+        GtkWidget *route;
+        GtkWidget *ip4_dns;
+        GtkWidget *ip6_dns;
+
+        /* both families share the route row */
+        gchar     *ip4_route;
+        gchar     *ip6_route;
+} IpRows;
+
 static void
-add_details (GtkWidget *details, NMDevice *device, NMConnection *connection)
+ip_rows_free (IpRows *rows)
 {
-        NMIPConfig *ip4_config = NULL;
-        NMIPConfig *ip6_config = NULL;
-        g_autofree gchar *ip4_address = NULL;
-        g_autofree gchar *ip4_route = NULL;
-        g_autofree gchar *ip4_dns = NULL;
-        g_autofree gchar *ip6_address = NULL;
-        g_autofree gchar *ip6_route = NULL;
-        g_autofree gchar *ip6_dns = NULL;
-        gint i = 0;
-
-        ip4_config = nm_device_get_ip4_config (device);
-        if (ip4_config) {
-                ip4_address = panel_get_ip4_address_as_string (ip4_config, "address");
-                ip4_route = panel_get_ip4_address_as_string (ip4_config, "gateway");
-                ip4_dns = panel_get_dns_as_string (ip4_config);
-        }
-        ip6_config = nm_device_get_ip6_config (device);
-        if (ip6_config) {
-                ip6_address = panel_get_ip6_address_as_string (ip6_config, "address");
-                ip6_route = panel_get_ip6_address_as_string (ip6_config, "gateway");
-                ip6_dns = panel_get_dns_as_string (ip6_config);
+        g_free (rows->ip4_route);
+        g_free (rows->ip6_route);
+        g_free (rows);
+}
+
+static void
+ip_rows_update (IpRows *rows, NMDevice *device, int addr_family)
+{
+        NMIPConfig *config;
+        g_autofree gchar *address = NULL;
+        g_autofree gchar *dns = NULL;
+        gboolean has_ip4, has_ip6;
+
+        if (addr_family == AF_INET) {
+                config = nm_device_get_ip4_config (device);
+                g_clear_pointer (&rows->ip4_route, g_free);
+                if (config) {
+                        address = panel_get_ip4_address_as_string (config, "address");
+                        rows->ip4_route = panel_get_ip4_address_as_string (config, "gateway");
+                        dns = panel_get_dns_as_string (config);
+                }
+                set_details_row (rows->ip4_address, address);
+                set_details_row (rows->ip4_dns, dns);
+        } else {
+                config = nm_device_get_ip6_config (device);
+                g_clear_pointer (&rows->ip6_route, g_free);
+                if (config) {
+                        address = panel_get_ip6_address_as_string (config, "address");
+                        rows->ip6_route = panel_get_ip6_address_as_string (config, "gateway");
+                        dns = panel_get_dns_as_string (config);
+                }
+                set_details_row (rows->ip6_address, address);
+                set_details_row (rows->ip6_dns, dns);
         }
 
-        if (ip4_address && ip6_address) {
-                add_details_row (details, i++, _("IPv4 Address"), ip4_address);
-                add_details_row (details, i++, _("IPv6 Address"), ip6_address);
-        } else if (ip4_address) {
-                add_details_row (details, i++, _("IP Address"), ip4_address);
-        } else if (ip6_address) {
-                add_details_row (details, i++, _("IP Address"), ip6_address);
+        if (rows->ip4_route && rows->ip6_route) {
+                g_autofree gchar *ip_routes = g_strjoin ("\n", rows->ip4_route, rows->ip6_route, NULL);
+                set_details_row (rows->route, ip_routes);
+        } else {
+                set_details_row (rows->route, rows->ip4_route ? rows->ip4_route : rows->ip6_route);
         }
 
-        add_details_row (details, i++, _("Hardware Address"),
-                         nm_device_ethernet_get_hw_address (NM_DEVICE_ETHERNET (device)));
+        /* the headings say which family a row is for only when both
+         * have one */
+        has_ip4 = gtk_widget_get_visible (rows->ip4_address);
+        has_ip6 = gtk_widget_get_visible (rows->ip6_address);
+        set_details_heading (rows->ip4_address, has_ip6 ? _("IPv4 Address") : _("IP Address"));
+        set_details_heading (rows->ip6_address, has_ip4 ? _("IPv6 Address") : _("IP Address"));
+
+        has_ip4 = gtk_widget_get_visible (rows->ip4_dns);
+        has_ip6 = gtk_widget_get_visible (rows->ip6_dns);
+        set_details_heading (rows->ip4_dns, has_ip6 ? _("DNS4") : _("DNS"));
+        set_details_heading (rows->ip6_dns, has_ip4 ? _("DNS6") : _("DNS"));
+}
 
-        if (ip4_route && ip6_route) {
-                g_autofree gchar *ip_routes = g_strjoin ("\n", ip4_route, ip6_route, NULL);
-                add_details_row (details, i++, _("Default Route"), ip_routes);
-        } else if (ip4_route) {
-                add_details_row (details, i++, _("Default Route"), ip4_route);
-        } else if (ip6_route) {
-                add_details_row (details, i++, _("Default Route"), ip6_route);
-        }
-        
-        if (ip4_dns && ip6_dns) {
-                add_details_row (details, i++, _("DNS4"), ip4_dns);
-                add_details_row (details, i++, _("DNS6"), ip6_dns);
-        } else if (ip4_dns) {
-                add_details_row (details, i++, _("DNS"), ip4_dns);
-        } else if (ip6_dns) {
-                add_details_row (details, i++, _("DNS"), ip6_dns);
-        }
+static void
+add_details (GtkWidget *details, NMDevice *device, NMConnection *connection)
+{
+        IpRows *rows;
+        GtkWidget *row;
+
+        rows = g_new0 (IpRows, 1);
+        rows->ip4_address = add_details_row (details, 0, NULL);
+        rows->ip6_address = add_details_row (details, 1, NULL);
+        row = add_details_row (details, 2, _("Hardware Address"));
+        set_details_row (row, nm_device_ethernet_get_hw_address (NM_DEVICE_ETHERNET (device)));
+        rows->route = add_details_row (details, 3, _("Default Route"));
+        rows->ip4_dns = add_details_row (details, 4, NULL);
+        rows->ip6_dns = add_details_row (details, 5, NULL);
+
+        ip_rows_update (rows, device, AF_INET);
+        ip_rows_update (rows, device, AF_INET6);
+        g_object_set_data_full (G_OBJECT (details), "ip-rows", rows, (GDestroyNotify) ip_rows_free);
 
         if (nm_device_get_state (device) != NM_DEVICE_STATE_ACTIVATED) {
                 g_autofree gchar *last_used = NULL;
                 last_used = get_last_used_string (connection);
-                add_details_row (details, i++, _("Last used"), last_used);
+                row = add_details_row (details, 6, _("Last used"));
+                set_details_row (row, last_used);
         }
 }
 
@@ -338,6 +400,7 @@ add_row (NetDeviceEthernet *device, NMConnection *connection)
                 gtk_box_pack_start (GTK_BOX (row), details, FALSE, TRUE, 0);
 
                 add_details (details, nmdev, connection);
+                g_object_set_data (G_OBJECT (row), "details", details);
         }
 
         /* filler */
@@ -399,6 +462,7 @@ populate_ui (NetDeviceEthernet *device)
                 gtk_container_remove (GTK_CONTAINER (device->details), c->data);
         }
         g_list_free (children);
+        g_object_set_data (G_OBJECT (device->details), "ip-rows", NULL);
 
         connections = net_device_get_valid_connections (NET_DEVICE (device));
         for (l = connections; l; l = l->next) {
@@ -615,14 +679,48 @@ device_ethernet_refresh (NetObject *object)
         device_ethernet_refresh_ui (device);
 }
 
+static void
+update_details (GtkWidget *details, NMDevice *device, int addr_family)
+{
+        IpRows *rows;
+
+        rows = g_object_get_data (G_OBJECT (details), "ip-rows");
+        if (rows != NULL)
+                ip_rows_update (rows, device, addr_family);
+}
+
+static void
+device_ethernet_ip_config_changed (NetDevice *net_device, int addr_family)
+{
+        NetDeviceEthernet *device = NET_DEVICE_ETHERNET (net_device);
+        NMDevice *nmdev = net_device_get_nm_device (net_device);
+        GList *children, *c;
+
+        /* addresses show in the single connection view, and in the row
+         * of the active connection when there are several */
+        update_details (device->details, nmdev, addr_family);
+
+        children = gtk_container_get_children (GTK_CONTAINER (device->list));
+        for (c = children; c; c = c->next) {
+                GtkWidget *details;
+
+                details = g_object_get_data (G_OBJECT (gtk_bin_get_child (GTK_BIN (c->data))), "details");
+                if (details != NULL)
+                        update_details (details, nmdev, addr_family);
+        }
+        g_list_free (children);
+}
+
 static void
 net_device_ethernet_class_init (NetDeviceEthernetClass *klass)
 {
         NetDeviceSimpleClass *simple_class = NET_DEVICE_SIMPLE_CLASS (klass);
+        NetDeviceClass *device_class = NET_DEVICE_CLASS (klass);
         NetObjectClass *obj_class = NET_OBJECT_CLASS (klass);
         GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
         simple_class->get_speed = device_ethernet_get_speed;
+        device_class->ip_config_changed = device_ethernet_ip_config_changed;
         obj_class->refresh = device_ethernet_refresh;
         obj_class->add_to_notebook = device_ethernet_add_to_notebook;
         object_class->constructed = device_ethernet_constructed;
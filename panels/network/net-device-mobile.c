@@ -27,11 +27,11 @@
 
 #include <NetworkManager.h>
 #include <libmm-glib.h>
-#include <nma-mobile-providers.h>
 
 #include "panel-common.h"
 #include "network-dialogs.h"
 #include "net-device-mobile.h"
+#include "net-mobile-providers.h"
 
 #define NET_DEVICE_MOBILE_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NET_TYPE_DEVICE_MOBILE, NetDeviceMobilePrivate))
 
@@ -50,7 +50,8 @@ struct _NetDeviceMobilePrivate
         MMObject   *mm_object;
         guint       operator_name_updated;
 
-        NMAMobileProvidersDatabase *mpd;
+        /* set while the provider database loads */
+        GCancellable *providers_cancellable;
 };
 
 enum {
@@ -268,44 +269,26 @@ device_mobile_refresh_equipment_id (NetDeviceMobile *device_mobile)
         panel_set_device_widget_details (device_mobile->priv->builder, "imei", equipment_id);
 }
 
+static void device_mobile_load_providers (NetDeviceMobile *device_mobile);
+
 static gchar *
 device_mobile_find_provider (NetDeviceMobile *device_mobile,
                              const gchar     *mccmnc,
                              guint32          sid)
 {
-        NMAMobileProvider *provider;
-        GString *name = NULL;
-
-        if (device_mobile->priv->mpd == NULL) {
-                GError *error = NULL;
-
-                /* Use defaults */
-                device_mobile->priv->mpd = nma_mobile_providers_database_new_sync (NULL, NULL, NULL, &error);
-                if (device_mobile->priv->mpd == NULL) {
-                        g_debug ("Couldn't load mobile providers database: %s",
-                                 error ? error->message : "");
-                        g_clear_error (&error);
-                        return NULL;
-                }
-        }
+        NetMobileProviders *providers;
 
-        if (mccmnc != NULL) {
-                provider = nma_mobile_providers_database_lookup_3gpp_mcc_mnc (device_mobile->priv->mpd, mccmnc);
-                if (provider != NULL)
-                        name = g_string_new (nma_mobile_provider_get_name (provider));
-        }
+        if (mccmnc == NULL && sid == 0)
+                return NULL;
 
-        if (sid != 0) {
-                provider = nma_mobile_providers_database_lookup_cdma_sid (device_mobile->priv->mpd, sid);
-                if (provider != NULL) {
-                        if (name == NULL)
-                                name = g_string_new (nma_mobile_provider_get_name (provider));
-                        else
-                                g_string_append_printf (name, ", %s", nma_mobile_provider_get_name (provider));
-                }
+        /* looked up again once loaded, see providers_loaded_cb() */
+        providers = net_mobile_providers_peek ();
+        if (providers == NULL) {
+                device_mobile_load_providers (device_mobile);
+                return NULL;
         }
 
-        return (name != NULL ? g_string_free (name, FALSE) : NULL);
+        return net_mobile_providers_find_name (providers, mccmnc, sid);
 }
 
 static void
@@ -435,6 +418,19 @@ device_mobile_refresh (NetObject *object)
         nm_device_mobile_refresh_ui (device_mobile);
 }
 
+static void
+device_mobile_ip_config_changed (NetDevice *device, int addr_family)
+{
+        NetDeviceMobilePrivate *priv = NET_DEVICE_MOBILE (device)->priv;
+
+        if (priv->builder == NULL)
+                return;
+
+        panel_set_device_ip_widgets (priv->builder,
+                                     net_device_get_nm_device (device),
+                                     addr_family);
+}
+
 static void
 device_off_toggled (GtkSwitch *sw,
                     GParamSpec *pspec,
@@ -716,6 +712,70 @@ device_mobile_device_got_modem_manager_cdma_cb (GObject      *source_object,
                            device_mobile);
 }
 
+static void
+providers_loaded_cb (GObject      *source_object,
+                     GAsyncResult *res,
+                     gpointer      user_data)
+{
+        NetDeviceMobile *device_mobile;
+        NetDeviceMobilePrivate *priv;
+        NetMobileProviders *providers;
+        GError *error = NULL;
+
+        providers = net_mobile_providers_load_finish (res, &error);
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+                g_error_free (error);
+                return;
+        }
+
+        device_mobile = NET_DEVICE_MOBILE (user_data);
+        priv = device_mobile->priv;
+        g_clear_object (&priv->providers_cancellable);
+
+        if (providers == NULL) {
+                g_debug ("Couldn't load mobile providers database: %s",
+                         error->message);
+                g_error_free (error);
+                return;
+        }
+
+        /* redo the lookups that were made without it */
+        if (priv->mm_object != NULL)
+                device_mobile_refresh_operator_name (device_mobile);
+        if (priv->gsm_proxy != NULL)
+                g_dbus_proxy_call (priv->gsm_proxy,
+                                   "GetRegistrationInfo",
+                                   NULL,
+                                   G_DBUS_CALL_FLAGS_NONE,
+                                   -1,
+                                   NULL,
+                                   device_mobile_get_registration_info_cb,
+                                   device_mobile);
+        if (priv->cdma_proxy != NULL)
+                g_dbus_proxy_call (priv->cdma_proxy,
+                                   "GetServingSystem",
+                                   NULL,
+                                   G_DBUS_CALL_FLAGS_NONE,
+                                   -1,
+                                   NULL,
+                                   device_mobile_get_serving_system_cb,
+                                   device_mobile);
+}
+
+static void
+device_mobile_load_providers (NetDeviceMobile *device_mobile)
+{
+        NetDeviceMobilePrivate *priv = device_mobile->priv;
+
+        if (priv->providers_cancellable != NULL)
+                return;
+
+        priv->providers_cancellable = g_cancellable_new ();
+        net_mobile_providers_load_async (priv->providers_cancellable,
+                                         providers_loaded_cb,
+                                         device_mobile);
+}
+
 static void
 net_device_mobile_constructed (GObject *object)
 {
@@ -773,6 +833,11 @@ net_device_mobile_constructed (GObject *object)
                 }
         }
 
+        /* the first modem loads the provider database for everybody, have
+         * it ready before the operator is known */
+        if (net_mobile_providers_peek () == NULL)
+                device_mobile_load_providers (device_mobile);
+
         client = net_object_get_client (NET_OBJECT (device_mobile));
         g_signal_connect_object (client, "notify::wwan-enabled",
                                  G_CALLBACK (mobilebb_enabled_toggled),
@@ -865,7 +930,10 @@ net_device_mobile_dispose (GObject *object)
                 priv->operator_name_updated = 0;
         }
         g_clear_object (&priv->mm_object);
-        g_clear_object (&priv->mpd);
+        if (priv->providers_cancellable != NULL) {
+                g_cancellable_cancel (priv->providers_cancellable);
+                g_clear_object (&priv->providers_cancellable);
+        }
 
         G_OBJECT_CLASS (net_device_mobile_parent_class)->dispose (object);
 }
@@ -875,6 +943,7 @@ net_device_mobile_class_init (NetDeviceMobileClass *klass)
 {
         GObjectClass *object_class = G_OBJECT_CLASS (klass);
         NetObjectClass *parent_class = NET_OBJECT_CLASS (klass);
+        NetDeviceClass *device_class = NET_DEVICE_CLASS (klass);
 
         object_class->dispose = net_device_mobile_dispose;
         object_class->constructed = net_device_mobile_constructed;
@@ -882,6 +951,7 @@ net_device_mobile_class_init (NetDeviceMobileClass *klass)
         object_class->set_property = net_device_mobile_set_property;
         parent_class->add_to_notebook = device_mobile_proxy_add_to_notebook;
         parent_class->refresh = device_mobile_refresh;
+        device_class->ip_config_changed = device_mobile_ip_config_changed;
 
         g_type_class_add_private (klass, sizeof (NetDeviceMobilePrivate));
 
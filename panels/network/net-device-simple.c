@@ -41,25 +41,6 @@ struct _NetDeviceSimplePrivate
 
 G_DEFINE_TYPE (NetDeviceSimple, net_device_simple, NET_TYPE_DEVICE)
 
-static GtkWidget *
-device_simple_proxy_add_to_notebook (NetObject *object,
-                                     GtkNotebook *notebook,
-                                     GtkSizeGroup *heading_size_group)
-{
-        GtkWidget *widget;
-        NetDeviceSimple *device_simple = NET_DEVICE_SIMPLE (object);
-
-        /* add widgets to size group */
-        widget = GTK_WIDGET (gtk_builder_get_object (device_simple->priv->builder,
-                                                     "heading_ipv4"));
-        gtk_size_group_add_widget (heading_size_group, widget);
-
-        widget = GTK_WIDGET (gtk_builder_get_object (device_simple->priv->builder,
-                                                     "vbox6"));
-        gtk_notebook_append_page (notebook, widget, NULL);
-        return widget;
-}
-
 static void
 update_off_switch_from_device_state (GtkSwitch *sw,
                                      NMDeviceState state,
@@ -91,11 +72,13 @@ nm_device_simple_refresh_ui (NetDeviceSimple *device_simple)
         NMDevice *nm_device;
         NMDeviceState state;
 
+        /* the page is built when first shown */
+        if (priv->builder == NULL)
+                return;
+
         nm_device = net_device_get_nm_device (NET_DEVICE (device_simple));
 
         /* set device kind */
-        widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "label_device"));
-        g_object_bind_property (device_simple, "title", widget, "label", 0);
         widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "image_device"));
         gtk_image_set_from_icon_name (GTK_IMAGE (widget),
                                       panel_device_to_icon_name (nm_device, FALSE),
@@ -133,6 +116,19 @@ device_simple_refresh (NetObject *object)
         nm_device_simple_refresh_ui (device_simple);
 }
 
+static void
+device_simple_ip_config_changed (NetDevice *device, int addr_family)
+{
+        NetDeviceSimplePrivate *priv = NET_DEVICE_SIMPLE (device)->priv;
+
+        if (priv->builder == NULL)
+                return;
+
+        panel_set_device_ip_widgets (priv->builder,
+                                     net_device_get_nm_device (device),
+                                     addr_family);
+}
+
 static void
 device_off_toggled (GtkSwitch *sw,
                     GParamSpec *pspec,
@@ -183,6 +179,68 @@ edit_connection (GtkButton *button, NetDeviceSimple *device_simple)
         net_object_edit (NET_OBJECT (device_simple));
 }
 
+static gboolean
+device_simple_build_ui (NetDeviceSimple *device_simple)
+{
+        NetDeviceSimplePrivate *priv = device_simple->priv;
+        GError *error = NULL;
+        GtkWidget *widget;
+
+        if (priv->builder != NULL)
+                return TRUE;
+
+        priv->builder = gtk_builder_new ();
+        gtk_builder_add_from_resource (priv->builder,
+                                       "/org/cinnamon/control-center/network/network-simple.ui",
+                                       &error);
+        if (error != NULL) {
+                g_warning ("Could not load interface file: %s", error->message);
+                g_error_free (error);
+                g_clear_object (&priv->builder);
+                return FALSE;
+        }
+
+        widget = GTK_WIDGET (gtk_builder_get_object (priv->builder, "label_device"));
+        g_object_bind_property (device_simple, "title", widget, "label", G_BINDING_SYNC_CREATE);
+
+        /* setup simple combobox model */
+        widget = GTK_WIDGET (gtk_builder_get_object (priv->builder,
+                                                     "device_off_switch"));
+        g_signal_connect (widget, "notify::active",
+                          G_CALLBACK (device_off_toggled), device_simple);
+
+        widget = GTK_WIDGET (gtk_builder_get_object (priv->builder,
+                                                     "button_options"));
+        g_signal_connect (widget, "clicked",
+                          G_CALLBACK (edit_connection), device_simple);
+
+        return TRUE;
+}
+
+static GtkWidget *
+device_simple_proxy_add_to_notebook (NetObject *object,
+                                     GtkNotebook *notebook,
+                                     GtkSizeGroup *heading_size_group)
+{
+        GtkWidget *widget;
+        NetDeviceSimple *device_simple = NET_DEVICE_SIMPLE (object);
+
+        if (!device_simple_build_ui (device_simple))
+                return NULL;
+
+        nm_device_simple_refresh_ui (device_simple);
+
+        /* add widgets to size group */
+        widget = GTK_WIDGET (gtk_builder_get_object (device_simple->priv->builder,
+                                                     "heading_ipv4"));
+        gtk_size_group_add_widget (heading_size_group, widget);
+
+        widget = GTK_WIDGET (gtk_builder_get_object (device_simple->priv->builder,
+                                                     "vbox6"));
+        gtk_notebook_append_page (notebook, widget, NULL);
+        return widget;
+}
+
 static void
 net_device_simple_constructed (GObject *object)
 {
@@ -199,7 +257,7 @@ net_device_simple_finalize (GObject *object)
         NetDeviceSimple *device_simple = NET_DEVICE_SIMPLE (object);
         NetDeviceSimplePrivate *priv = device_simple->priv;
 
-        g_object_unref (priv->builder);
+        g_clear_object (&priv->builder);
 
         G_OBJECT_CLASS (net_device_simple_parent_class)->finalize (object);
 }
@@ -215,12 +273,14 @@ net_device_simple_class_init (NetDeviceSimpleClass *klass)
 {
         GObjectClass *object_class = G_OBJECT_CLASS (klass);
         NetObjectClass *parent_class = NET_OBJECT_CLASS (klass);
+        NetDeviceClass *device_class = NET_DEVICE_CLASS (klass);
         NetDeviceSimpleClass *simple_class = NET_DEVICE_SIMPLE_CLASS (klass);
 
         object_class->finalize = net_device_simple_finalize;
         object_class->constructed = net_device_simple_constructed;
         parent_class->add_to_notebook = device_simple_proxy_add_to_notebook;
         parent_class->refresh = device_simple_refresh;
+        device_class->ip_config_changed = device_simple_ip_config_changed;
         simple_class->get_speed = device_simple_get_speed;
 
         g_type_class_add_private (klass, sizeof (NetDeviceSimplePrivate));
@@ -229,31 +289,7 @@ net_device_simple_class_init (NetDeviceSimpleClass *klass)
 static void
 net_device_simple_init (NetDeviceSimple *device_simple)
 {
-        GError *error = NULL;
-        GtkWidget *widget;
-
         device_simple->priv = NET_DEVICE_SIMPLE_GET_PRIVATE (device_simple);
-
-        device_simple->priv->builder = gtk_builder_new ();
-        gtk_builder_add_from_resource (device_simple->priv->builder,
-                                       "/org/cinnamon/control-center/network/network-simple.ui",
-                                       &error);
-        if (error != NULL) {
-                g_warning ("Could not load interface file: %s", error->message);
-                g_error_free (error);
-                return;
-        }
-
-        /* setup simple combobox model */
-        widget = GTK_WIDGET (gtk_builder_get_object (device_simple->priv->builder,
-                                                     "device_off_switch"));
-        g_signal_connect (widget, "notify::active",
-                          G_CALLBACK (device_off_toggled), device_simple);
-
-        widget = GTK_WIDGET (gtk_builder_get_object (device_simple->priv->builder,
-                                                     "button_options"));
-        g_signal_connect (widget, "clicked",
-                          G_CALLBACK (edit_connection), device_simple);
 }
 
 char *
@@ -275,6 +311,9 @@ net_device_simple_add_row (NetDeviceSimple *device_simple,
         GtkStyleContext *context;
         gint top_attach;
 
+        if (!device_simple_build_ui (device_simple))
+                return;
+
         grid = GTK_GRID (gtk_builder_get_object (priv->builder, "grid"));
 
         label = gtk_label_new (label_string);
@@ -27,7 +27,6 @@
 #include <netinet/ether.h>
 
 #include <NetworkManager.h>
-#include <polkit/polkit.h>
 
 #include "shell/list-box-helper.h"
 #include "shell/hostname-helper.h"
@@ -36,9 +35,16 @@
 
 #include "connection-editor/net-connection-editor.h"
 #include "net-device-wifi.h"
+#include "net-wifi-ssid.h"
 
 #define NET_DEVICE_WIFI_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NET_TYPE_DEVICE_WIFI, NetDeviceWifiPrivate))
 
+/* Access points come and go in bursts while scanning */
+#define AP_LIST_UPDATE_DELAY 500 /* ms */
+
+/* Deletions in flight when forgetting networks from the history */
+#define FORGET_MAX_PENDING 4
+
 typedef enum {
   NM_AP_SEC_UNKNOWN,
   NM_AP_SEC_NONE,
@@ -65,6 +71,20 @@ struct _NetDeviceWifiPrivate
         gchar                   *selected_ssid_title;
         gchar                   *selected_connection_id;
         gchar                   *selected_ap_id;
+
+        /* SSID -> row of the access point list */
+        GHashTable              *ap_rows;
+        guint                    ap_list_update_id;
+
+        /* SSID -> GPtrArray of the Wi-Fi connections for it, in the
+         * client's order. Built on first use. */
+        GHashTable              *connections_by_ssid;
+
+        /* cancels the networks being forgotten */
+        GCancellable            *forget_cancellable;
+
+        /* watched for its signal strength */
+        NMAccessPoint           *active_ap;
 };
 
 G_DEFINE_TYPE (NetDeviceWifi, net_device_wifi, NET_TYPE_DEVICE)
@@ -140,68 +160,34 @@ get_access_point_security (NMAccessPoint *ap)
         return type;
 }
 
+static GBytes *
+ap_get_ssid (gpointer ap)
+{
+        return nm_access_point_get_ssid (NM_ACCESS_POINT (ap));
+}
+
+static guint8
+ap_get_strength (gpointer ap)
+{
+        return nm_access_point_get_strength (NM_ACCESS_POINT (ap));
+}
+
 static GPtrArray *
 panel_get_strongest_unique_aps (const GPtrArray *aps)
 {
-        GBytes *ssid, *ssid_tmp;
-        GPtrArray *aps_unique = NULL;
-        gboolean add_ap;
+        GPtrArray *aps_unique;
         guint i;
-        guint j;
-        NMAccessPoint *ap;
-        NMAccessPoint *ap_tmp;
 
         /* we will have multiple entries for typical hotspots, just
          * filter to the one with the strongest signal */
-        aps_unique = g_ptr_array_new_with_free_func ((GDestroyNotify) g_object_unref);
-        if (aps != NULL)
-                for (i = 0; i < aps->len; i++) {
-                        ap = NM_ACCESS_POINT (g_ptr_array_index (aps, i));
+        aps_unique = net_wifi_get_strongest_unique (aps, ap_get_ssid, ap_get_strength);
+        for (i = 0; i < aps_unique->len; i++)
+                g_object_ref (g_ptr_array_index (aps_unique, i));
+        g_ptr_array_set_free_func (aps_unique, (GDestroyNotify) g_object_unref);
 
-                        /* Hidden SSIDs don't get shown in the list */
-                        ssid = nm_access_point_get_ssid (ap);
-                        if (!ssid)
-                                continue;
-
-                        add_ap = TRUE;
-
-                        /* get already added list */
-                        for (j=0; j<aps_unique->len; j++) {
-                                ap_tmp = NM_ACCESS_POINT (g_ptr_array_index (aps_unique, j));
-                                ssid_tmp = nm_access_point_get_ssid (ap_tmp);
-                                g_assert (ssid_tmp);
-
-                                /* is this the same type and data? */
-                                if (nm_utils_same_ssid (g_bytes_get_data (ssid, NULL), g_bytes_get_size (ssid),
-                                                        g_bytes_get_data (ssid_tmp, NULL), g_bytes_get_size (ssid_tmp),
-                                                        TRUE)) {
-
-                                        g_debug ("found duplicate: %s",
-                                                 nm_utils_escape_ssid (g_bytes_get_data (ssid_tmp, NULL),
-                                                                       g_bytes_get_size (ssid_tmp)));
-
-                                        /* the new access point is stronger */
-                                        if (nm_access_point_get_strength (ap) >
-                                            nm_access_point_get_strength (ap_tmp)) {
-                                                g_debug ("removing %s",
-                                                         nm_utils_escape_ssid (g_bytes_get_data (ssid_tmp, NULL),
-                                                                               g_bytes_get_size (ssid_tmp)));
-                                                g_ptr_array_remove (aps_unique, ap_tmp);
-                                                add_ap = TRUE;
-                                        } else {
-                                                add_ap = FALSE;
-                                        }
+        g_debug ("%u access points, %u unique",
+                 aps ? aps->len : 0, aps_unique->len);
 
-                                        break;
-                                }
-                        }
-                        if (add_ap) {
-                                g_debug ("adding %s",
-                                         nm_utils_escape_ssid (g_bytes_get_data (ssid, NULL),
-                                                               g_bytes_get_size (ssid)));
-                                g_ptr_array_add (aps_unique, g_object_ref (ap));
-                        }
-                }
         return aps_unique;
 }
 
@@ -252,16 +238,32 @@ get_ap_security_string (NMAccessPoint *ap)
         return g_string_free (str, FALSE);
 }
 
+static gboolean
+ap_list_update_cb (gpointer user_data)
+{
+        NetDeviceWifi *device_wifi = NET_DEVICE_WIFI (user_data);
+
+        device_wifi->priv->ap_list_update_id = 0;
+        populate_ap_list (device_wifi);
+
+        return G_SOURCE_REMOVE;
+}
+
+static void
+queue_ap_list_update (NetDeviceWifi *device_wifi)
+{
+        if (device_wifi->priv->ap_list_update_id == 0)
+                device_wifi->priv->ap_list_update_id = g_timeout_add (AP_LIST_UPDATE_DELAY,
+                                                                      ap_list_update_cb,
+                                                                      device_wifi);
+}
+
 static void
 net_device_wifi_access_point_changed (NMDeviceWifi *nm_device_wifi,
                                       NMAccessPoint *ap,
                                       gpointer user_data)
 {
-        NetDeviceWifi *device_wifi;
-
-        device_wifi = NET_DEVICE_WIFI (user_data);
-
-        populate_ap_list (device_wifi);
+        queue_ap_list_update (NET_DEVICE_WIFI (user_data));
 }
 
 static void
@@ -318,6 +320,138 @@ connection_is_shared (NMConnection *c)
         return TRUE;
 }
 
+static GBytes *
+connection_get_ssid (NMConnection *connection)
+{
+        NMSettingWireless *sw;
+
+        sw = nm_connection_get_setting_wireless (connection);
+        if (sw == NULL)
+                return NULL;
+
+        return nm_setting_wireless_get_ssid (sw);
+}
+
+static void connection_index_invalidate (NetDeviceWifi *device_wifi);
+
+static void
+connection_index_add (NetDeviceWifi *device_wifi,
+                      NMConnection  *connection)
+{
+        GHashTable *index = device_wifi->priv->connections_by_ssid;
+        GPtrArray *connections;
+        GBytes *ssid;
+
+        ssid = connection_get_ssid (connection);
+        if (ssid == NULL)
+                return;
+
+        connections = g_hash_table_lookup (index, ssid);
+        if (connections == NULL) {
+                connections = g_ptr_array_new_with_free_func (g_object_unref);
+                g_hash_table_insert (index, g_bytes_ref (ssid), connections);
+        }
+        g_ptr_array_add (connections, g_object_ref (connection));
+
+        /* the SSID may be edited */
+        g_signal_connect_swapped (connection, NM_CONNECTION_CHANGED,
+                                  G_CALLBACK (connection_index_invalidate), device_wifi);
+}
+
+static void
+connection_index_invalidate (NetDeviceWifi *device_wifi)
+{
+        NetDeviceWifiPrivate *priv = device_wifi->priv;
+        GHashTableIter iter;
+        gpointer value;
+        guint i;
+
+        if (priv->connections_by_ssid == NULL)
+                return;
+
+        g_hash_table_iter_init (&iter, priv->connections_by_ssid);
+        while (g_hash_table_iter_next (&iter, NULL, &value)) {
+                GPtrArray *connections = value;
+
+                for (i = 0; i < connections->len; i++)
+                        g_signal_handlers_disconnect_by_func (g_ptr_array_index (connections, i),
+                                                              connection_index_invalidate,
+                                                              device_wifi);
+        }
+
+        g_clear_pointer (&priv->connections_by_ssid, g_hash_table_destroy);
+}
+
+static GHashTable *
+get_connection_index (NetDeviceWifi *device_wifi)
+{
+        NetDeviceWifiPrivate *priv = device_wifi->priv;
+        const GPtrArray *all;
+        guint i;
+
+        if (priv->connections_by_ssid != NULL)
+                return priv->connections_by_ssid;
+
+        priv->connections_by_ssid = g_hash_table_new_full (net_wifi_ssid_hash,
+                                                           net_wifi_ssid_equal,
+                                                           (GDestroyNotify) g_bytes_unref,
+                                                           (GDestroyNotify) g_ptr_array_unref);
+
+        all = nm_client_get_connections (net_object_get_client (NET_OBJECT (device_wifi)));
+        for (i = 0; all != NULL && i < all->len; i++)
+                connection_index_add (device_wifi, g_ptr_array_index (all, i));
+
+        return priv->connections_by_ssid;
+}
+
+static void
+connection_index_remove (NetDeviceWifi *device_wifi,
+                         NMConnection  *connection)
+{
+        GPtrArray *connections;
+        GBytes *ssid;
+
+        if (device_wifi->priv->connections_by_ssid == NULL)
+                return;
+
+        ssid = connection_get_ssid (connection);
+        if (ssid == NULL)
+                return;
+
+        connections = g_hash_table_lookup (device_wifi->priv->connections_by_ssid, ssid);
+        if (connections == NULL)
+                return;
+
+        g_signal_handlers_disconnect_by_func (connection, connection_index_invalidate, device_wifi);
+        g_ptr_array_remove (connections, connection);
+        if (connections->len == 0)
+                g_hash_table_remove (device_wifi->priv->connections_by_ssid, ssid);
+}
+
+/* The first of the valid connections for this SSID that isn't a hotspot */
+static NMConnection *
+find_connection_for_ssid (NetDeviceWifi *device_wifi,
+                          GHashTable    *valid,
+                          GBytes        *ssid)
+{
+        GPtrArray *connections;
+        guint i;
+
+        connections = g_hash_table_lookup (get_connection_index (device_wifi), ssid);
+        if (connections == NULL)
+                return NULL;
+
+        for (i = 0; i < connections->len; i++) {
+                NMConnection *connection = g_ptr_array_index (connections, i);
+
+                if (g_hash_table_contains (valid, connection) &&
+                    !connection_is_shared (connection))
+                        return connection;
+        }
+
+        return NULL;
+}
+
 static gboolean
 device_is_hotspot (NetDeviceWifi *device_wifi)
 {
@@ -517,13 +651,49 @@ out:
         g_free (last_used);
 }
 
+static const gchar *
+get_ap_strength_string (NMAccessPoint *ap)
+{
+        gint strength;
+
+        if (ap != NULL)
+                strength = nm_access_point_get_strength (ap);
+        else
+                strength = 0;
+        if (strength <= 0)
+                return NULL;
+        else if (strength < 20)
+                return C_("Signal strength", "None");
+        else if (strength < 40)
+                return C_("Signal strength", "Weak");
+        else if (strength < 50)
+                return C_("Signal strength", "Ok");
+        else if (strength < 80)
+                return C_("Signal strength", "Good");
+        else
+                return C_("Signal strength", "Excellent");
+}
+
+/* the access point the details are about, if they are about the active one */
+static NMAccessPoint *
+get_details_active_ap (NetDeviceWifi *device_wifi, gboolean *is_active)
+{
+        NMDevice *nm_device;
+        NMAccessPoint *ap;
+
+        nm_device = net_device_get_nm_device (NET_DEVICE (device_wifi));
+        ap = g_object_get_data (G_OBJECT (device_wifi->priv->details_dialog), "ap");
+        *is_active = !device_is_hotspot (device_wifi) &&
+                     ap == nm_device_wifi_get_active_access_point (NM_DEVICE_WIFI (nm_device));
+        return ap;
+}
+
 static void
 nm_device_wifi_refresh_ui (NetDeviceWifi *device_wifi)
 {
         const gchar *str;
         gboolean is_hotspot;
         gchar *str_tmp = NULL;
-        gint strength = 0;
         guint speed = 0;
         NMAccessPoint *active_ap;
         NMDevice *nm_device;
@@ -585,25 +755,9 @@ nm_device_wifi_refresh_ui (NetDeviceWifi *device_wifi)
         g_free (str_tmp);
 
         /* signal strength */
-        if (ap != NULL)
-                strength = nm_access_point_get_strength (ap);
-        else
-                strength = 0;
-        if (strength <= 0)
-                str = NULL;
-        else if (strength < 20)
-                str = C_("Signal strength", "None");
-        else if (strength < 40)
-                str = C_("Signal strength", "Weak");
-        else if (strength < 50)
-                str = C_("Signal strength", "Ok");
-        else if (strength < 80)
-                str = C_("Signal strength", "Good");
-        else
-                str = C_("Signal strength", "Excellent");
         panel_set_device_widget_details (device_wifi->priv->builder,
                                          "strength",
-                                         str);
+                                         get_ap_strength_string (ap));
 
         /* device MAC */
         if (ap != active_ap)
@@ -637,6 +791,67 @@ device_wifi_refresh (NetObject *object)
         nm_device_wifi_refresh_ui (device_wifi);
 }
 
+static void
+device_wifi_ip_config_changed (NetDevice *device, int addr_family)
+{
+        NetDeviceWifi *device_wifi = NET_DEVICE_WIFI (device);
+        gboolean is_active;
+
+        get_details_active_ap (device_wifi, &is_active);
+        if (!is_active)
+                return;
+
+        panel_set_device_ip_widgets (device_wifi->priv->builder,
+                                     net_device_get_nm_device (device),
+                                     addr_family);
+}
+
+static void
+active_ap_strength_changed_cb (NMAccessPoint *active_ap,
+                               GParamSpec    *pspec,
+                               NetDeviceWifi *device_wifi)
+{
+        NMAccessPoint *ap;
+        gboolean is_active;
+
+        ap = get_details_active_ap (device_wifi, &is_active);
+        if (!is_active)
+                return;
+
+        panel_set_device_widget_details (device_wifi->priv->builder,
+                                         "strength",
+                                         get_ap_strength_string (ap));
+}
+
+static void
+watch_active_ap (NetDeviceWifi *device_wifi, NMAccessPoint *active_ap)
+{
+        NetDeviceWifiPrivate *priv = device_wifi->priv;
+
+        if (priv->active_ap == active_ap)
+                return;
+
+        if (priv->active_ap != NULL) {
+                g_signal_handlers_disconnect_by_func (priv->active_ap,
+                                                      active_ap_strength_changed_cb,
+                                                      device_wifi);
+                g_clear_object (&priv->active_ap);
+        }
+        if (active_ap != NULL) {
+                priv->active_ap = g_object_ref (active_ap);
+                g_signal_connect (active_ap, "notify::" NM_ACCESS_POINT_STRENGTH,
+                                  G_CALLBACK (active_ap_strength_changed_cb), device_wifi);
+        }
+}
+
+static void
+active_ap_changed_cb (NMDeviceWifi  *nm_device,
+                      GParamSpec    *pspec,
+                      NetDeviceWifi *device_wifi)
+{
+        watch_active_ap (device_wifi, nm_device_wifi_get_active_access_point (nm_device));
+}
+
 static void
 device_off_toggled (GtkSwitch *sw,
                     GParamSpec *pspec,
@@ -806,18 +1021,14 @@ wireless_try_to_connect (NetDeviceWifi *device_wifi,
         g_debug ("no existing connection found for %s, creating", ssid_target);
 
         if (!is_8021x (device, ap_object_path)) {
-                GPermission *permission;
-                gboolean allowed_to_share = FALSE;
+                CcNetworkPanel *panel;
+                gboolean allowed_to_share;
                 NMConnection *partial = NULL;
                 NMAccessPoint *ap;
                 const char *forced_key_mgmt = NULL;
 
-                permission = polkit_permission_new_sync ("org.freedesktop.NetworkManager.settings.modify.system",
-                                                         NULL, NULL, NULL);
-                if (permission) {
-                        allowed_to_share = g_permission_get_allowed (permission);
-                        g_object_unref (permission);
-                }
+                panel = net_object_get_panel (NET_OBJECT (device_wifi));
+                allowed_to_share = cc_network_panel_get_allowed_to_modify_system (panel);
 
                 /* Pick the right key-mgmt up front for SAE-only or OWE APs.
                  * NM's auto-completion defaults to wpa-psk and never upgrades
@@ -925,61 +1136,13 @@ out:
         return;
 }
 
-static gchar *
-get_hostname (void)
-{
-        GDBusConnection *bus;
-        GVariant *res;
-        GVariant *inner;
-        gchar *str;
-        GError *error;
-
-        error = NULL;
-        bus = g_bus_get_sync (G_BUS_TYPE_SYSTEM, NULL, &error);
-        if (bus == NULL) {
-                g_warning ("Failed to get system bus connection: %s", error->message);
-                g_error_free (error);
-
-                return NULL;
-        }
-        res = g_dbus_connection_call_sync (bus,
-                                           "org.freedesktop.hostname1",
-                                           "/org/freedesktop/hostname1",
-                                           "org.freedesktop.DBus.Properties",
-                                           "Get",
-                                           g_variant_new ("(ss)",
-                                                          "org.freedesktop.hostname1",
-                                                          "PrettyHostname"),
-                                           (GVariantType*)"(v)",
-                                           G_DBUS_CALL_FLAGS_NONE,
-                                           -1,
-                                           NULL,
-                                           &error);
-        g_object_unref (bus);
-
-        if (res == NULL) {
-                g_warning ("Getting pretty hostname failed: %s", error->message);
-                g_error_free (error);
-        }
-
-        str = NULL;
-
-        if (res != NULL) {
-                g_variant_get (res, "(v)", &inner);
-                str = g_variant_dup_string (inner, NULL);
-                g_variant_unref (res);
-        }
-
-        return str;
-}
-
 static GBytes *
 generate_ssid_for_hotspot (NetDeviceWifi *device_wifi)
 {
         GBytes *ssid_bytes;
         gchar *hostname, *ssid;
 
-        hostname = get_hostname ();
+        hostname = cc_network_panel_dup_pretty_hostname (net_object_get_panel (NET_OBJECT (device_wifi)));
         ssid = pretty_hostname_to_ssid (hostname);
         g_free (hostname);
 
@@ -1468,6 +1631,9 @@ client_connection_added_cb (NMClient           *client,
 {
         gboolean is_hotspot;
 
+        if (device_wifi->priv->connections_by_ssid != NULL)
+                connection_index_add (device_wifi, NM_CONNECTION (connection));
+
         /* go straight to the hotspot UI */
         is_hotspot = device_is_hotspot (device_wifi);
         if (is_hotspot) {
@@ -1485,33 +1651,11 @@ client_connection_removed_cb (NMClient           *client,
                               NMRemoteConnection *connection,
                               NetDeviceWifi      *device_wifi)
 {
-        GtkWidget *swin;
-        GtkWidget *list;
-        GList *rows, *l;
-        const char *uuid;
+        connection_index_remove (device_wifi, NM_CONNECTION (connection));
 
-        uuid = nm_connection_get_uuid (NM_CONNECTION (connection));
-
-        swin = GTK_WIDGET (gtk_builder_get_object (device_wifi->priv->builder,
-                                                   "scrolledwindow_list"));
-        list = gtk_bin_get_child (GTK_BIN (gtk_bin_get_child (GTK_BIN (swin))));
-        rows = gtk_container_get_children (GTK_CONTAINER (list));
-        for (l = rows; l != NULL; l = l->next) {
-                GtkWidget *row = l->data;
-                NMConnection *connection;
-                const char *uuid_r;
-
-                connection = g_object_get_data (G_OBJECT (row), "connection");
-                if (!connection)
-                        continue;
-
-                uuid_r = nm_connection_get_uuid (connection);
-                if (g_strcmp0 (uuid_r, uuid) == 0) {
-                        gtk_widget_destroy (row);
-                        break;
-                }
-        }
-        g_list_free (rows);
+        /* the access point may still be in range; connections tend to
+         * go away in batches when forgetting them */
+        queue_ap_list_update (device_wifi);
 }
 
 static void
@@ -1538,6 +1682,11 @@ net_device_wifi_constructed (GObject *object)
         g_signal_connect_object (nm_device, "access-point-removed",
                                  G_CALLBACK (net_device_wifi_access_point_changed),
                                  device_wifi, 0);
+        g_signal_connect_object (nm_device, "notify::" NM_DEVICE_WIFI_ACTIVE_ACCESS_POINT,
+                                 G_CALLBACK (active_ap_changed_cb),
+                                 device_wifi, 0);
+        watch_active_ap (device_wifi,
+                         nm_device_wifi_get_active_access_point (NM_DEVICE_WIFI (nm_device)));
 
         /* only enable the button if the user can create a hotspot */
         widget = GTK_WIDGET (gtk_builder_get_object (device_wifi->priv->builder,
@@ -1578,6 +1727,13 @@ net_device_wifi_finalize (GObject *object)
         g_free (priv->selected_ssid_title);
         g_free (priv->selected_connection_id);
         g_free (priv->selected_ap_id);
+        if (priv->ap_list_update_id != 0)
+                g_source_remove (priv->ap_list_update_id);
+        g_clear_pointer (&priv->ap_rows, g_hash_table_destroy);
+        connection_index_invalidate (device_wifi);
+        g_cancellable_cancel (priv->forget_cancellable);
+        g_clear_object (&priv->forget_cancellable);
+        watch_active_ap (device_wifi, NULL);
 
         G_OBJECT_CLASS (net_device_wifi_parent_class)->finalize (object);
 }
@@ -1613,33 +1769,141 @@ net_device_wifi_class_init (NetDeviceWifiClass *klass)
 {
         GObjectClass *object_class = G_OBJECT_CLASS (klass);
         NetObjectClass *parent_class = NET_OBJECT_CLASS (klass);
+        NetDeviceClass *device_class = NET_DEVICE_CLASS (klass);
 
         object_class->finalize = net_device_wifi_finalize;
         object_class->constructed = net_device_wifi_constructed;
         parent_class->add_to_notebook = device_wifi_proxy_add_to_notebook;
         parent_class->refresh = device_wifi_refresh;
         parent_class->edit = device_wifi_edit;
+        device_class->ip_config_changed = device_wifi_ip_config_changed;
 
         g_type_class_add_private (klass, sizeof (NetDeviceWifiPrivate));
 }
 
+typedef struct {
+        NetDeviceWifi   *device_wifi;
+        GCancellable    *cancellable;
+        GQueue           queue;         /* NMRemoteConnection to delete */
+        guint            n_total;
+        guint            n_pending;
+        guint            n_done;
+        GPtrArray       *errors;
+        GtkWidget       *progress;      /* weak, the history may be closed */
+} ForgetBatch;
+
+static void forget_batch_next (ForgetBatch *batch);
+
 static void
-really_forgotten (GObject            *source_object,
-                  GAsyncResult       *res,
-                  gpointer            user_data)
+forget_batch_free (ForgetBatch *batch)
 {
+        /* the queue is embedded, only its links are freed; this is
+         * g_queue_clear_full(), which needs a newer GLib */
+        g_queue_foreach (&batch->queue, (GFunc) g_object_unref, NULL);
+        g_queue_clear (&batch->queue);
+        g_ptr_array_unref (batch->errors);
+        if (batch->progress != NULL)
+                g_object_remove_weak_pointer (G_OBJECT (batch->progress), (gpointer *) &batch->progress);
+        g_object_unref (batch->cancellable);
+        g_free (batch);
+}
+
+static void
+forget_batch_show_errors (ForgetBatch *batch)
+{
+        GtkWidget *dialog;
+        GtkWidget *window = NULL;
+        gchar *details;
+
+        if (batch->progress != NULL)
+                window = gtk_widget_get_toplevel (batch->progress);
+        else
+                window = gtk_widget_get_toplevel (GTK_WIDGET (net_object_get_panel (NET_OBJECT (batch->device_wifi))));
+
+        g_ptr_array_add (batch->errors, NULL);
+        details = g_strjoinv ("\n", (gchar **) batch->errors->pdata);
+
+        dialog = gtk_message_dialog_new (GTK_WINDOW (window),
+                                         GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+                                         GTK_MESSAGE_WARNING,
+                                         GTK_BUTTONS_CLOSE,
+                                         ngettext ("%u network could not be forgotten",
+                                                   "%u networks could not be forgotten",
+                                                   batch->errors->len - 1),
+                                         batch->errors->len - 1);
+        gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (dialog), "%s", details);
+        g_signal_connect (dialog, "response", G_CALLBACK (gtk_widget_destroy), NULL);
+        gtk_window_present (GTK_WINDOW (dialog));
+
+        g_free (details);
+}
+
+static void
+forget_batch_deleted_cb (GObject            *source_object,
+                         GAsyncResult       *res,
+                         gpointer            user_data)
+{
+        ForgetBatch *batch = user_data;
+        NMConnection *connection = NM_CONNECTION (source_object);
         GError *error = NULL;
 
         if (!nm_remote_connection_delete_finish (NM_REMOTE_CONNECTION (source_object), res, &error)) {
-                g_warning ("failed to delete connection %s: %s",
-                           nm_object_get_path (NM_OBJECT (source_object)),
-                           error->message);
+                if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+                        g_warning ("failed to delete connection %s: %s",
+                                   nm_object_get_path (NM_OBJECT (source_object)),
+                                   error->message);
+                        g_ptr_array_add (batch->errors,
+                                         g_strdup_printf ("%s: %s",
+                                                          nm_connection_get_id (connection),
+                                                          error->message));
+                }
                 g_error_free (error);
+        }
+        g_object_unref (connection);
+
+        batch->n_pending--;
+        batch->n_done++;
+
+        forget_batch_next (batch);
+}
+
+static void
+forget_batch_next (ForgetBatch *batch)
+{
+        NMRemoteConnection *connection;
+
+        /* the device is gone, leave the UI alone */
+        if (g_cancellable_is_cancelled (batch->cancellable)) {
+                if (batch->n_pending == 0)
+                        forget_batch_free (batch);
                 return;
         }
 
-        /* remove the entry from the list */
-        populate_ap_list (user_data);
+        while (batch->n_pending < FORGET_MAX_PENDING &&
+               (connection = g_queue_pop_head (&batch->queue)) != NULL) {
+                batch->n_pending++;
+                nm_remote_connection_delete_async (connection,
+                                                   batch->cancellable,
+                                                   forget_batch_deleted_cb,
+                                                   batch);
+        }
+
+        if (batch->progress != NULL)
+                gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (batch->progress),
+                                               (gdouble) batch->n_done / batch->n_total);
+
+        if (batch->n_pending > 0)
+                return;
+
+        /* all done, update the list once */
+        if (batch->progress != NULL)
+                gtk_widget_hide (batch->progress);
+        populate_ap_list (batch->device_wifi);
+
+        if (batch->errors->len > 0)
+                forget_batch_show_errors (batch);
+
+        forget_batch_free (batch);
 }
 
 static void
@@ -1651,6 +1915,7 @@ really_forget (GtkDialog *dialog, gint response, gpointer data)
         GList *r;
         NMRemoteConnection *connection;
         NetDeviceWifi *device_wifi;
+        ForgetBatch *batch;
 
         gtk_widget_destroy (GTK_WIDGET (dialog));
 
@@ -1658,15 +1923,38 @@ really_forget (GtkDialog *dialog, gint response, gpointer data)
                 return;
 
         device_wifi = NET_DEVICE_WIFI (g_object_get_data (G_OBJECT (forget), "net"));
+        if (device_wifi->priv->forget_cancellable == NULL)
+                device_wifi->priv->forget_cancellable = g_cancellable_new ();
+
+        batch = g_new0 (ForgetBatch, 1);
+        batch->device_wifi = device_wifi;
+        batch->cancellable = g_object_ref (device_wifi->priv->forget_cancellable);
+        batch->errors = g_ptr_array_new_with_free_func (g_free);
+        g_queue_init (&batch->queue);
+
         rows = g_object_steal_data (G_OBJECT (forget), "rows");
         for (r = rows; r; r = r->next) {
                 row = r->data;
                 connection = g_object_get_data (G_OBJECT (row), "connection");
-                //FIXME cancellable
-                nm_remote_connection_delete_async (connection, NULL, really_forgotten, device_wifi);
+                g_queue_push_tail (&batch->queue, g_object_ref (connection));
                 gtk_widget_destroy (row);
         }
         g_list_free (rows);
+
+        batch->n_total = g_queue_get_length (&batch->queue);
+        if (batch->n_total == 0) {
+                forget_batch_free (batch);
+                return;
+        }
+
+        batch->progress = g_object_get_data (G_OBJECT (forget), "progress");
+        if (batch->progress != NULL) {
+                g_object_add_weak_pointer (G_OBJECT (batch->progress), (gpointer *) &batch->progress);
+                gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (batch->progress), 0.0);
+                gtk_widget_show (batch->progress);
+        }
+
+        forget_batch_next (batch);
 }
 
 static void
@@ -1726,6 +2014,58 @@ update_forget (GtkWidget *forget,
         gtk_widget_set_sensitive (forget, rows != NULL);
 }
 
+static void
+get_ap_activation (NMDevice      *device,
+                   NMAccessPoint *ap,
+                   NMAccessPoint *active_ap,
+                   gboolean      *active,
+                   gboolean      *connecting)
+{
+        NMDeviceState state;
+
+        state = nm_device_get_state (device);
+
+        *active = (ap == active_ap) && (state == NM_DEVICE_STATE_ACTIVATED);
+        *connecting = (ap == active_ap) &&
+                      (state == NM_DEVICE_STATE_PREPARE ||
+                       state == NM_DEVICE_STATE_CONFIG ||
+                       state == NM_DEVICE_STATE_IP_CONFIG ||
+                       state == NM_DEVICE_STATE_IP_CHECK ||
+                       state == NM_DEVICE_STATE_NEED_AUTH);
+}
+
+static const gchar *
+get_strength_icon_name (guint strength)
+{
+        if (strength < 20)
+                return "xsi-network-wireless-signal-none-symbolic";
+        else if (strength < 40)
+                return "xsi-network-wireless-signal-weak-symbolic";
+        else if (strength < 50)
+                return "xsi-network-wireless-signal-ok-symbolic";
+        else if (strength < 80)
+                return "xsi-network-wireless-signal-good-symbolic";
+        else
+                return "xsi-network-wireless-signal-excellent-symbolic";
+}
+
+/* Everything an access point row shows, so that populate_ap_list() only
+ * rebuilds the rows that look different */
+static gchar *
+get_ap_row_state (NMDevice      *device,
+                  NMConnection  *connection,
+                  NMAccessPoint *ap,
+                  NMAccessPoint *active_ap)
+{
+        gboolean active, connecting;
+
+        get_ap_activation (device, ap, active_ap, &active, &connecting);
+
+        return g_strdup_printf ("%p:%d:%d:%u:%s", connection, active, connecting,
+                                get_access_point_security (ap),
+                                get_strength_icon_name (nm_access_point_get_strength (ap)));
+}
+
 static void
 make_row (GtkSizeGroup   *rows,
           GtkSizeGroup   *icons,
@@ -1750,14 +2090,10 @@ make_row (GtkSizeGroup   *rows,
         guint security;
         guint strength;
         GBytes *ssid;
-        const gchar *icon_name;
         guint64 timestamp;
-        NMDeviceState state;
 
         g_assert (connection || ap);
 
-        state = nm_device_get_state (device);
-
         if (connection != NULL) {
                 NMSettingWireless *sw;
                 NMSettingConnection *sc;
@@ -1772,13 +2108,7 @@ make_row (GtkSizeGroup   *rows,
 
         if (ap != NULL) {
                 in_range = TRUE;
-                active = (ap == active_ap) && (state == NM_DEVICE_STATE_ACTIVATED);
-                connecting = (ap == active_ap) &&
-                             (state == NM_DEVICE_STATE_PREPARE ||
-                              state == NM_DEVICE_STATE_CONFIG ||
-                              state == NM_DEVICE_STATE_IP_CONFIG ||
-                              state == NM_DEVICE_STATE_IP_CHECK ||
-                              state == NM_DEVICE_STATE_NEED_AUTH);
+                get_ap_activation (device, ap, active_ap, &active, &connecting);
                 security = get_access_point_security (ap);
                 strength = nm_access_point_get_strength (ap);
         } else {
@@ -1884,23 +2214,15 @@ make_row (GtkSizeGroup   *rows,
                 }
                 gtk_box_pack_start (GTK_BOX (box), widget, FALSE, FALSE, 0);
 
-                if (strength < 20)
-                        icon_name = "xsi-network-wireless-signal-none-symbolic";
-                else if (strength < 40)
-                        icon_name = "xsi-network-wireless-signal-weak-symbolic";
-                else if (strength < 50)
-                        icon_name = "xsi-network-wireless-signal-ok-symbolic";
-                else if (strength < 80)
-                        icon_name = "xsi-network-wireless-signal-good-symbolic";
-                else
-                        icon_name = "xsi-network-wireless-signal-excellent-symbolic";
-                widget = gtk_image_new_from_icon_name (icon_name, GTK_ICON_SIZE_MENU);
+                widget = gtk_image_new_from_icon_name (get_strength_icon_name (strength), GTK_ICON_SIZE_MENU);
                 gtk_box_pack_start (GTK_BOX (box), widget, FALSE, FALSE, 0);
         }
 
         gtk_widget_show_all (row);
 
-        g_object_set_data (G_OBJECT (row), "ap", ap);
+        /* the row may outlive the access point until the next update */
+        if (ap)
+                g_object_set_data_full (G_OBJECT (row), "ap", g_object_ref (ap), g_object_unref);
         if (connection)
                 g_object_set_data (G_OBJECT (row), "connection", connection);
         g_object_set_data (G_OBJECT (row), "timestamp", GUINT_TO_POINTER (timestamp));
@@ -1978,10 +2300,12 @@ open_history (NetDeviceWifi *device_wifi)
         GtkWidget *button;
         GtkWidget *forget;
         GtkWidget *swin;
+        GtkWidget *widget;
         GSList *connections;
         GSList *l;
         const GPtrArray *aps;
         GPtrArray *aps_unique = NULL;
+        GHashTable *aps_by_ssid;
         NMAccessPoint *active_ap;
         guint i;
         NMDevice *nm_device;
@@ -2025,6 +2349,13 @@ open_history (NetDeviceWifi *device_wifi)
         gtk_widget_set_margin_bottom (swin, 12);
         gtk_box_pack_start (GTK_BOX (gtk_dialog_get_content_area (GTK_DIALOG (dialog))), swin, TRUE, TRUE, 0);
 
+        /* shown while forgetting networks */
+        widget = gtk_progress_bar_new ();
+        gtk_widget_set_margin_start (widget, 50);
+        gtk_widget_set_margin_end (widget, 50);
+        gtk_box_pack_start (GTK_BOX (gtk_dialog_get_content_area (GTK_DIALOG (dialog))), widget, FALSE, FALSE, 0);
+        g_object_set_data (G_OBJECT (forget), "progress", widget);
+
         list = GTK_WIDGET (gtk_list_box_new ());
         gtk_widget_show (list);
         gtk_list_box_set_selection_mode (GTK_LIST_BOX (list), GTK_SELECTION_NONE);
@@ -2045,26 +2376,23 @@ open_history (NetDeviceWifi *device_wifi)
         aps_unique = panel_get_strongest_unique_aps (aps);
         active_ap = nm_device_wifi_get_active_access_point (NM_DEVICE_WIFI (nm_device));
 
+        aps_by_ssid = g_hash_table_new (net_wifi_ssid_hash, net_wifi_ssid_equal);
+        for (i = 0; i < aps_unique->len; i++) {
+                NMAccessPoint *ap = g_ptr_array_index (aps_unique, i);
+
+                g_hash_table_insert (aps_by_ssid, nm_access_point_get_ssid (ap), ap);
+        }
+
         for (l = connections; l; l = l->next) {
                 NMConnection *connection = l->data;
                 NMAccessPoint *ap = NULL;
-                NMSetting *setting;
                 GBytes *ssid;
                 if (connection_is_shared (connection))
                         continue;
 
-                setting = nm_connection_get_setting_by_name (connection, NM_SETTING_WIRELESS_SETTING_NAME);
-                ssid = nm_setting_wireless_get_ssid (NM_SETTING_WIRELESS (setting));
-                for (i = 0; i < aps_unique->len; i++) {
-                        GBytes *ssid_ap;
-                        ap = NM_ACCESS_POINT (g_ptr_array_index (aps_unique, i));
-                        ssid_ap = nm_access_point_get_ssid (ap);
-                        if (nm_utils_same_ssid (g_bytes_get_data (ssid, NULL), g_bytes_get_size (ssid),
-                                                g_bytes_get_data (ssid_ap, NULL), g_bytes_get_size (ssid_ap),
-                                                TRUE))
-                                break;
-                        ap = NULL;
-                }
+                ssid = connection_get_ssid (connection);
+                if (ssid != NULL)
+                        ap = g_hash_table_lookup (aps_by_ssid, ssid);
 
                 make_row (rows, icons, forget, nm_device, connection, ap, active_ap, &row, NULL, &button);
                 gtk_container_add (GTK_CONTAINER (list), row);
@@ -2074,6 +2402,7 @@ open_history (NetDeviceWifi *device_wifi)
                         g_object_set_data (G_OBJECT (button), "row", row);
                 }
         }
+        g_hash_table_destroy (aps_by_ssid);
         g_slist_free (connections);
         g_ptr_array_free (aps_unique, TRUE);
 
@@ -2083,8 +2412,10 @@ open_history (NetDeviceWifi *device_wifi)
 static void
 populate_ap_list (NetDeviceWifi *device_wifi)
 {
+        NetDeviceWifiPrivate *priv = device_wifi->priv;
         GtkWidget *swin;
         GtkWidget *list;
+        GtkWidget *focus;
         GtkSizeGroup *rows;
         GtkSizeGroup *icons;
         NMDevice *nm_device;
@@ -2093,20 +2424,23 @@ populate_ap_list (NetDeviceWifi *device_wifi)
         const GPtrArray *aps;
         GPtrArray *aps_unique = NULL;
         NMAccessPoint *active_ap;
+        GHashTable *seen;
+        GHashTable *valid;
+        GHashTableIter iter;
+        gpointer key, value;
         guint i;
         GtkWidget *row;
         GtkWidget *button;
-        GList *children, *child;
 
-        swin = GTK_WIDGET (gtk_builder_get_object (device_wifi->priv->builder,
+        if (priv->ap_list_update_id != 0) {
+                g_source_remove (priv->ap_list_update_id);
+                priv->ap_list_update_id = 0;
+        }
+
+        swin = GTK_WIDGET (gtk_builder_get_object (priv->builder,
                                                    "scrolledwindow_list"));
         list = gtk_bin_get_child (GTK_BIN (gtk_bin_get_child (GTK_BIN (swin))));
-
-        children = gtk_container_get_children (GTK_CONTAINER (list));
-        for (child = children; child; child = child->next) {
-                gtk_container_remove (GTK_CONTAINER (list), GTK_WIDGET (child->data));
-        }
-        g_list_free (children);
+        focus = gtk_container_get_focus_child (GTK_CONTAINER (list));
 
         rows = GTK_SIZE_GROUP (g_object_get_data (G_OBJECT (list), "rows"));
         icons = GTK_SIZE_GROUP (g_object_get_data (G_OBJECT (list), "icons"));
@@ -2114,45 +2448,67 @@ populate_ap_list (NetDeviceWifi *device_wifi)
         nm_device = net_device_get_nm_device (NET_DEVICE (device_wifi));
 
         connections = net_device_get_valid_connections (NET_DEVICE (device_wifi));
+        valid = g_hash_table_new (NULL, NULL);
+        for (l = connections; l; l = l->next)
+                g_hash_table_add (valid, l->data);
 
         aps = nm_device_wifi_get_access_points (NM_DEVICE_WIFI (nm_device));
         aps_unique = panel_get_strongest_unique_aps (aps);
         active_ap = nm_device_wifi_get_active_access_point (NM_DEVICE_WIFI (nm_device));
 
+        seen = g_hash_table_new (net_wifi_ssid_hash, net_wifi_ssid_equal);
+
         for (i = 0; i < aps_unique->len; i++) {
                 GBytes *ssid_ap;
                 NMAccessPoint *ap;
                 NMConnection *connection = NULL;
+                GtkWidget *old_row;
+                gchar *state;
+
                 ap = NM_ACCESS_POINT (g_ptr_array_index (aps_unique, i));
                 ssid_ap = nm_access_point_get_ssid (ap);
-                for (l = connections; l; l = l->next) {
-                        connection = l->data;
-                        NMSetting *setting;
-                        GBytes *ssid;
+                connection = find_connection_for_ssid (device_wifi, valid, ssid_ap);
 
-                        if (connection_is_shared (connection)) {
-                                connection = NULL;
-                                continue;
-                        }
+                g_hash_table_add (seen, ssid_ap);
 
-                        setting = nm_connection_get_setting_by_name (connection, NM_SETTING_WIRELESS_SETTING_NAME);
-                        ssid = nm_setting_wireless_get_ssid (NM_SETTING_WIRELESS (setting));
-                        if (nm_utils_same_ssid (g_bytes_get_data (ssid, NULL), g_bytes_get_size (ssid),
-                                                g_bytes_get_data (ssid_ap, NULL), g_bytes_get_size (ssid_ap),
-                                                TRUE))
-                                break;
-                        connection = NULL;
+                /* leave the row alone if it would look the same */
+                state = get_ap_row_state (nm_device, connection, ap, active_ap);
+                old_row = g_hash_table_lookup (priv->ap_rows, ssid_ap);
+                if (old_row != NULL &&
+                    g_strcmp0 (g_object_get_data (G_OBJECT (old_row), "state"), state) == 0) {
+                        g_object_set_data_full (G_OBJECT (old_row), "ap", g_object_ref (ap), g_object_unref);
+                        g_free (state);
+                        continue;
                 }
 
                 make_row (rows, icons, NULL, nm_device, connection, ap, active_ap, &row, NULL, &button);
+                g_object_set_data_full (G_OBJECT (row), "state", state, g_free);
                 gtk_container_add (GTK_CONTAINER (list), row);
                 if (button) {
                         g_signal_connect (button, "clicked",
                                           G_CALLBACK (show_details_for_row), device_wifi);
                         g_object_set_data (G_OBJECT (button), "row", row);
                 }
+
+                if (old_row != NULL) {
+                        if (old_row == focus)
+                                gtk_widget_grab_focus (row);
+                        gtk_widget_destroy (old_row);
+                }
+                g_hash_table_replace (priv->ap_rows, g_bytes_ref (ssid_ap), row);
+        }
+
+        /* and drop the networks that went out of range */
+        g_hash_table_iter_init (&iter, priv->ap_rows);
+        while (g_hash_table_iter_next (&iter, &key, &value)) {
+                if (g_hash_table_contains (seen, key))
+                        continue;
+                gtk_widget_destroy (GTK_WIDGET (value));
+                g_hash_table_iter_remove (&iter);
         }
 
+        g_hash_table_destroy (seen);
+        g_hash_table_destroy (valid);
         g_slist_free (connections);
         g_ptr_array_free (aps_unique, TRUE);
 }
@@ -2206,6 +2562,10 @@ net_device_wifi_init (NetDeviceWifi *device_wifi)
         GtkSizeGroup *icons;
 
         device_wifi->priv = NET_DEVICE_WIFI_GET_PRIVATE (device_wifi);
+        device_wifi->priv->ap_rows = g_hash_table_new_full (net_wifi_ssid_hash,
+                                                            net_wifi_ssid_equal,
+                                                            (GDestroyNotify) g_bytes_unref,
+                                                            NULL);
 
         device_wifi->priv->builder = gtk_builder_new ();
         gtk_builder_add_from_resource (device_wifi->priv->builder,
@@ -23,6 +23,7 @@
 
 #include <glib-object.h>
 #include <glib/gi18n.h>
+#include <sys/socket.h>
 #include <arpa/inet.h>
 #include <netinet/ether.h>
 
@@ -32,12 +33,34 @@
 
 #define NET_DEVICE_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NET_TYPE_DEVICE, NetDevicePrivate))
 
+#define CONNECTIONS_WATCH_KEY "net-device-connections-watch"
+
 struct _NetDevicePrivate
 {
         NMDevice                        *nm_device;
         guint                            changed_id;
+
+        /* net_device_get_valid_connections() as of the given connections
+         * generation and active connection; a generation of 0 is stale */
+        GSList                          *valid_connections;
+        guint                            valid_connections_generation;
+        gchar                           *valid_connections_active_uuid;
+
+        /* the IP configs whose changes are passed on to the
+         * ip_config_changed vfunc, batched in an idle */
+        NMIPConfig                      *ip4_config;
+        NMIPConfig                      *ip6_config;
+        guint                            ip_config_changed_id;
+        gboolean                         ip4_config_changed;
+        gboolean                         ip6_config_changed;
 };
 
+/* One per NMClient, shared by all devices. The generation is bumped
+ * whenever a connection is added, removed or changed. */
+typedef struct {
+        guint                            generation;
+} ConnectionsWatch;
+
 enum {
         PROP_0,
         PROP_DEVICE,
@@ -172,10 +195,130 @@ state_changed_cb (NMDevice *device,
                   NMDeviceStateReason reason,
                   NetDevice *net_device)
 {
+        /* which connections the device takes can depend on its state */
+        net_device->priv->valid_connections_generation = 0;
+
         net_object_emit_changed (NET_OBJECT (net_device));
         net_object_refresh (NET_OBJECT (net_device));
 }
 
+static gboolean
+ip_config_changed_idle_cb (gpointer user_data)
+{
+        NetDevice *net_device = NET_DEVICE (user_data);
+        NetDeviceClass *klass = NET_DEVICE_GET_CLASS (net_device);
+        NetDevicePrivate *priv = net_device->priv;
+        gboolean ip4_changed, ip6_changed;
+
+        ip4_changed = priv->ip4_config_changed;
+        ip6_changed = priv->ip6_config_changed;
+        priv->ip4_config_changed = FALSE;
+        priv->ip6_config_changed = FALSE;
+        priv->ip_config_changed_id = 0;
+
+        if (ip4_changed)
+                klass->ip_config_changed (net_device, AF_INET);
+        if (ip6_changed)
+                klass->ip_config_changed (net_device, AF_INET6);
+
+        return G_SOURCE_REMOVE;
+}
+
+static void
+queue_ip_config_changed (NetDevice *net_device, int addr_family)
+{
+        NetDevicePrivate *priv = net_device->priv;
+
+        if (addr_family == AF_INET)
+                priv->ip4_config_changed = TRUE;
+        else
+                priv->ip6_config_changed = TRUE;
+
+        /* a DHCP lease sets addresses, gateway and DNS one by one */
+        if (priv->ip_config_changed_id == 0)
+                priv->ip_config_changed_id = g_idle_add (ip_config_changed_idle_cb, net_device);
+}
+
+static void
+ip_config_notify_cb (NMIPConfig *config,
+                     GParamSpec *pspec,
+                     NetDevice  *net_device)
+{
+        queue_ip_config_changed (net_device, nm_ip_config_get_family (config));
+}
+
+static void
+watch_ip_config (NetDevice   *net_device,
+                 NMIPConfig **watched,
+                 NMIPConfig  *config)
+{
+        if (*watched == config)
+                return;
+
+        if (*watched != NULL) {
+                g_signal_handlers_disconnect_by_func (*watched, ip_config_notify_cb, net_device);
+                g_clear_object (watched);
+        }
+        if (config == NULL)
+                return;
+
+        *watched = g_object_ref (config);
+        g_signal_connect (config, "notify::" NM_IP_CONFIG_ADDRESSES,
+                          G_CALLBACK (ip_config_notify_cb), net_device);
+        g_signal_connect (config, "notify::" NM_IP_CONFIG_GATEWAY,
+                          G_CALLBACK (ip_config_notify_cb), net_device);
+        g_signal_connect (config, "notify::" NM_IP_CONFIG_NAMESERVERS,
+                          G_CALLBACK (ip_config_notify_cb), net_device);
+}
+
+static void
+device_ip4_config_notify_cb (NMDevice   *device,
+                             GParamSpec *pspec,
+                             NetDevice  *net_device)
+{
+        watch_ip_config (net_device, &net_device->priv->ip4_config,
+                         nm_device_get_ip4_config (device));
+        queue_ip_config_changed (net_device, AF_INET);
+}
+
+static void
+device_ip6_config_notify_cb (NMDevice   *device,
+                             GParamSpec *pspec,
+                             NetDevice  *net_device)
+{
+        watch_ip_config (net_device, &net_device->priv->ip6_config,
+                         nm_device_get_ip6_config (device));
+        queue_ip_config_changed (net_device, AF_INET6);
+}
+
+static void
+net_device_watch_ip_configs (NetDevice *net_device, NMDevice *device)
+{
+        NetDevicePrivate *priv = net_device->priv;
+
+        if (priv->nm_device != NULL) {
+                g_signal_handlers_disconnect_by_func (priv->nm_device, device_ip4_config_notify_cb, net_device);
+                g_signal_handlers_disconnect_by_func (priv->nm_device, device_ip6_config_notify_cb, net_device);
+        }
+        watch_ip_config (net_device, &priv->ip4_config, NULL);
+        watch_ip_config (net_device, &priv->ip6_config, NULL);
+        if (priv->ip_config_changed_id != 0) {
+                g_source_remove (priv->ip_config_changed_id);
+                priv->ip_config_changed_id = 0;
+        }
+
+        /* only classes that show addresses care */
+        if (device == NULL || NET_DEVICE_GET_CLASS (net_device)->ip_config_changed == NULL)
+                return;
+
+        g_signal_connect (device, "notify::" NM_DEVICE_IP4_CONFIG,
+                          G_CALLBACK (device_ip4_config_notify_cb), net_device);
+        g_signal_connect (device, "notify::" NM_DEVICE_IP6_CONFIG,
+                          G_CALLBACK (device_ip6_config_notify_cb), net_device);
+        watch_ip_config (net_device, &priv->ip4_config, nm_device_get_ip4_config (device));
+        watch_ip_config (net_device, &priv->ip6_config, nm_device_get_ip6_config (device));
+}
+
 NMDevice *
 net_device_get_nm_device (NetDevice *device)
 {
@@ -243,7 +386,9 @@ net_device_set_property (GObject *device_,
                         g_signal_handler_disconnect (priv->nm_device,
                                                      priv->changed_id);
                 }
+                net_device_watch_ip_configs (net_device, g_value_get_object (value));
                 priv->nm_device = g_value_dup_object (value);
+                priv->valid_connections_generation = 0;
                 if (priv->nm_device) {
                         priv->changed_id = g_signal_connect (priv->nm_device,
                                                              "state-changed",
@@ -268,8 +413,11 @@ net_device_finalize (GObject *object)
                 g_signal_handler_disconnect (priv->nm_device,
                                              priv->changed_id);
         }
+        net_device_watch_ip_configs (device, NULL);
         if (priv->nm_device != NULL)
                 g_object_unref (priv->nm_device);
+        g_slist_free (priv->valid_connections);
+        g_free (priv->valid_connections_active_uuid);
 
         G_OBJECT_CLASS (net_device_parent_class)->finalize (object);
 }
@@ -311,9 +459,65 @@ net_device_new (void)
         return NET_DEVICE (device);
 }
 
+static void
+watched_connection_changed_cb (NMConnection     *connection,
+                               ConnectionsWatch *watch)
+{
+        watch->generation++;
+}
+
+static void
+watched_connection_added_cb (NMClient           *client,
+                             NMRemoteConnection *connection,
+                             ConnectionsWatch   *watch)
+{
+        watch->generation++;
+        g_signal_connect (connection, NM_CONNECTION_CHANGED,
+                          G_CALLBACK (watched_connection_changed_cb), watch);
+}
+
+static void
+watched_connection_removed_cb (NMClient           *client,
+                               NMRemoteConnection *connection,
+                               ConnectionsWatch   *watch)
+{
+        watch->generation++;
+        g_signal_handlers_disconnect_by_func (connection, watched_connection_changed_cb, watch);
+}
+
+static guint
+get_connections_generation (NMClient *client)
+{
+        ConnectionsWatch *watch;
+        const GPtrArray *all;
+        guint i;
+
+        watch = g_object_get_data (G_OBJECT (client), CONNECTIONS_WATCH_KEY);
+        if (watch != NULL)
+                return watch->generation;
+
+        watch = g_new0 (ConnectionsWatch, 1);
+        watch->generation = 1;
+        g_object_set_data_full (G_OBJECT (client), CONNECTIONS_WATCH_KEY, watch, g_free);
+
+        g_signal_connect (client, NM_CLIENT_CONNECTION_ADDED,
+                          G_CALLBACK (watched_connection_added_cb), watch);
+        g_signal_connect (client, NM_CLIENT_CONNECTION_REMOVED,
+                          G_CALLBACK (watched_connection_removed_cb), watch);
+
+        all = nm_client_get_connections (client);
+        for (i = 0; all != NULL && i < all->len; i++)
+                g_signal_connect (g_ptr_array_index (all, i), NM_CONNECTION_CHANGED,
+                                  G_CALLBACK (watched_connection_changed_cb), watch);
+
+        return watch->generation;
+}
+
+/* return value must be freed by caller with g_slist_free() */
 GSList *
 net_device_get_valid_connections (NetDevice *device)
 {
+        NetDevicePrivate *priv = device->priv;
         GSList *valid;
         NMConnection *connection;
         NMSettingConnection *s_con;
@@ -321,15 +525,25 @@ net_device_get_valid_connections (NetDevice *device)
         const char *active_uuid;
         const GPtrArray *all;
         GPtrArray *filtered;
+        NMClient *client;
+        guint generation;
         guint i;
 
-        all = nm_client_get_connections (net_object_get_client (NET_OBJECT (device)));
-        filtered = nm_device_filter_connections (net_device_get_nm_device (device), all);
+        client = net_object_get_client (NET_OBJECT (device));
+        generation = get_connections_generation (client);
 
-        active_connection = nm_device_get_active_connection (net_device_get_nm_device (device));
+        active_connection = nm_device_get_active_connection (priv->nm_device);
 
         active_uuid = active_connection ? nm_active_connection_get_uuid (active_connection) : NULL;
 
+        /* filtering goes through every profile, only do it when needed */
+        if (priv->valid_connections_generation == generation &&
+            g_strcmp0 (priv->valid_connections_active_uuid, active_uuid) == 0)
+                return g_slist_copy (priv->valid_connections);
+
+        all = nm_client_get_connections (client);
+        filtered = nm_device_filter_connections (priv->nm_device, all);
+
         valid = NULL;
         for (i = 0; i < filtered->len; i++) {
                 connection = g_ptr_array_index (filtered, i);
@@ -345,5 +559,11 @@ net_device_get_valid_connections (NetDevice *device)
         }
         g_ptr_array_free (filtered, FALSE);
 
-        return g_slist_reverse (valid);
+        g_slist_free (priv->valid_connections);
+        priv->valid_connections = g_slist_reverse (valid);
+        priv->valid_connections_generation = generation;
+        g_free (priv->valid_connections_active_uuid);
+        priv->valid_connections_active_uuid = g_strdup (active_uuid);
+
+        return g_slist_copy (priv->valid_connections);
 }
@@ -51,6 +51,11 @@ struct _NetDeviceClass
         NetObjectClass               parent_class;
 
         NMConnection * (*get_find_connection) (NetDevice *device);
+
+        /* the addresses, gateway or DNS servers of one family changed;
+         * NULL if the class does not show them */
+        void           (*ip_config_changed)   (NetDevice *device,
+                                               int        addr_family);
 };
 
 GType            net_device_get_type                    (void);
@@ -0,0 +1,459 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <glib/gstdio.h>
+#include <nma-mobile-providers.h>
+
+#include "net-mobile-providers.h"
+
+/* version, database mtime and size, language the names were picked for,
+ * then MCCMNC → name and SID → name, both sorted by key */
+#define CACHE_VERSION   1
+#define CACHE_TYPE      "(uxtsa(ss)a(us))"
+
+struct _NetMobileProviders
+{
+        GVariant        *gsm;
+        GVariant        *cdma;
+};
+
+/* loaded once and kept for the life of the process */
+static NetMobileProviders *default_providers = NULL;
+
+/* load_async() calls waiting for the worker thread */
+static GSList *pending_tasks = NULL;
+
+/* why the last load failed, and the database mtime it failed with
+ * (-1 if it was missing) */
+static GError *load_error = NULL;
+static gint64 load_error_mtime = 0;
+
+static gint64
+get_database_mtime (void)
+{
+        GStatBuf st;
+
+        if (g_stat (MOBILE_BROADBAND_PROVIDER_INFO_DATABASE, &st) != 0)
+                return -1;
+
+        return st.st_mtime;
+}
+
+static gchar *
+get_cache_path (void)
+{
+        return g_build_filename (g_get_user_cache_dir (),
+                                 "cinnamon-control-center",
+                                 "mobile-providers.cache",
+                                 NULL);
+}
+
+static GVariant *
+load_cache (const gchar *path, const GStatBuf *st)
+{
+        GMappedFile *file;
+        GBytes *bytes;
+        GVariant *index;
+        const gchar *lang;
+        guint32 version;
+        gint64 mtime;
+        guint64 size;
+
+        file = g_mapped_file_new (path, FALSE, NULL);
+        if (file == NULL)
+                return NULL;
+
+        bytes = g_mapped_file_get_bytes (file);
+        g_mapped_file_unref (file);
+        index = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (CACHE_TYPE), bytes, FALSE));
+        g_bytes_unref (bytes);
+
+        g_variant_get_child (index, 0, "u", &version);
+        g_variant_get_child (index, 1, "x", &mtime);
+        g_variant_get_child (index, 2, "t", &size);
+        g_variant_get_child (index, 3, "&s", &lang);
+        if (version != CACHE_VERSION ||
+            mtime != (gint64) st->st_mtime ||
+            size != (guint64) st->st_size ||
+            g_strcmp0 (lang, g_get_language_names ()[0]) != 0) {
+                g_variant_unref (index);
+                return NULL;
+        }
+
+        return index;
+}
+
+static void
+save_cache (const gchar *path, GVariant *index)
+{
+        g_autofree gchar *dir = NULL;
+        g_autoptr(GError) error = NULL;
+
+        dir = g_path_get_dirname (path);
+        if (g_mkdir_with_parents (dir, 0700) != 0) {
+                g_debug ("Could not create %s: %s", dir, g_strerror (errno));
+                return;
+        }
+
+        if (!g_file_set_contents (path,
+                                  g_variant_get_data (index),
+                                  g_variant_get_size (index),
+                                  &error))
+                g_debug ("Could not save the mobile providers cache: %s", error->message);
+}
+
+static gint
+compare_strings (gconstpointer a, gconstpointer b)
+{
+        return strcmp (*(const gchar **) a, *(const gchar **) b);
+}
+
+static gint
+compare_sids (gconstpointer a, gconstpointer b)
+{
+        guint32 sid_a = GPOINTER_TO_UINT (*(gpointer *) a);
+        guint32 sid_b = GPOINTER_TO_UINT (*(gpointer *) b);
+
+        return sid_a < sid_b ? -1 : sid_a > sid_b;
+}
+
+static GVariant *
+build_index (const GStatBuf *st, GError **error)
+{
+        NMAMobileProvidersDatabase *mpd;
+        g_autoptr(GHashTable) gsm = NULL;
+        g_autoptr(GHashTable) cdma = NULL;
+        g_autoptr(GPtrArray) keys = NULL;
+        GVariantBuilder builder;
+        GVariant *index;
+        GHashTableIter iter;
+        NMACountryInfo *country;
+        gpointer key;
+        GSList *p, *l;
+        guint i;
+
+        mpd = nma_mobile_providers_database_new_sync (NULL,
+                                                      MOBILE_BROADBAND_PROVIDER_INFO_DATABASE,
+                                                      NULL, error);
+        if (mpd == NULL)
+                return NULL;
+
+        /* first provider wins, as with the database's own lookups */
+        gsm = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+        cdma = g_hash_table_new (NULL, NULL);
+
+        g_hash_table_iter_init (&iter, nma_mobile_providers_database_get_countries (mpd));
+        while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &country)) {
+                for (p = nma_country_info_get_providers (country); p != NULL; p = p->next) {
+                        NMAMobileProvider *provider = p->data;
+                        const gchar *name = nma_mobile_provider_get_name (provider);
+
+                        if (name == NULL)
+                                continue;
+
+                        for (l = nma_mobile_provider_get_3gpp_mcc_mnc (provider); l != NULL; l = l->next) {
+                                NMAMccMncItem *item = l->data;
+                                gchar *mccmnc;
+
+                                mccmnc = g_strconcat (nma_mcc_mnc_item_get_mcc (item),
+                                                      nma_mcc_mnc_item_get_mnc (item),
+                                                      NULL);
+                                if (g_hash_table_contains (gsm, mccmnc))
+                                        g_free (mccmnc);
+                                else
+                                        g_hash_table_insert (gsm, mccmnc, (gpointer) name);
+                        }
+
+                        for (l = nma_mobile_provider_get_cdma_sid (provider); l != NULL; l = l->next) {
+                                if (!g_hash_table_contains (cdma, l->data))
+                                        g_hash_table_insert (cdma, l->data, (gpointer) name);
+                        }
+                }
+        }
+
+        g_variant_builder_init (&builder, G_VARIANT_TYPE (CACHE_TYPE));
+        g_variant_builder_add (&builder, "u", CACHE_VERSION);
+        g_variant_builder_add (&builder, "x", (gint64) st->st_mtime);
+        g_variant_builder_add (&builder, "t", (guint64) st->st_size);
+        g_variant_builder_add (&builder, "s", g_get_language_names ()[0]);
+
+        keys = g_ptr_array_new ();
+        g_hash_table_iter_init (&iter, gsm);
+        while (g_hash_table_iter_next (&iter, &key, NULL))
+                g_ptr_array_add (keys, key);
+        g_ptr_array_sort (keys, compare_strings);
+        g_variant_builder_open (&builder, G_VARIANT_TYPE ("a(ss)"));
+        for (i = 0; i < keys->len; i++)
+                g_variant_builder_add (&builder, "(ss)",
+                                       g_ptr_array_index (keys, i),
+                                       g_hash_table_lookup (gsm, g_ptr_array_index (keys, i)));
+        g_variant_builder_close (&builder);
+
+        g_ptr_array_set_size (keys, 0);
+        g_hash_table_iter_init (&iter, cdma);
+        while (g_hash_table_iter_next (&iter, &key, NULL))
+                g_ptr_array_add (keys, key);
+        g_ptr_array_sort (keys, compare_sids);
+        g_variant_builder_open (&builder, G_VARIANT_TYPE ("a(us)"));
+        for (i = 0; i < keys->len; i++)
+                g_variant_builder_add (&builder, "(us)",
+                                       GPOINTER_TO_UINT (g_ptr_array_index (keys, i)),
+                                       g_hash_table_lookup (cdma, g_ptr_array_index (keys, i)));
+        g_variant_builder_close (&builder);
+
+        index = g_variant_ref_sink (g_variant_builder_end (&builder));
+        g_object_unref (mpd);
+
+        return index;
+}
+
+static void
+load_thread (GTask        *task,
+             gpointer      source_object,
+             gpointer      task_data,
+             GCancellable *cancellable)
+{
+        g_autofree gchar *cache_path = NULL;
+        NetMobileProviders *providers;
+        GVariant *index;
+        GError *error = NULL;
+        gint64 *mtime = task_data;
+        GStatBuf st;
+
+        if (g_stat (MOBILE_BROADBAND_PROVIDER_INFO_DATABASE, &st) != 0) {
+                int errsv = errno;
+
+                *mtime = -1;
+                g_task_return_new_error (task, G_IO_ERROR, g_io_error_from_errno (errsv),
+                                         "Could not read %s: %s",
+                                         MOBILE_BROADBAND_PROVIDER_INFO_DATABASE,
+                                         g_strerror (errsv));
+                return;
+        }
+
+        *mtime = st.st_mtime;
+        cache_path = get_cache_path ();
+        index = load_cache (cache_path, &st);
+        if (index == NULL) {
+                index = build_index (&st, &error);
+                if (index == NULL) {
+                        g_task_return_error (task, error);
+                        return;
+                }
+                save_cache (cache_path, index);
+        }
+
+        providers = g_new0 (NetMobileProviders, 1);
+        providers->gsm = g_variant_get_child_value (index, 4);
+        providers->cdma = g_variant_get_child_value (index, 5);
+        g_variant_unref (index);
+
+        g_task_return_pointer (task, providers, NULL);
+}
+
+static void
+load_done_cb (GObject      *source_object,
+              GAsyncResult *res,
+              gpointer      user_data)
+{
+        GError *error = NULL;
+        GSList *tasks, *l;
+
+        default_providers = g_task_propagate_pointer (G_TASK (res), &error);
+        if (default_providers == NULL) {
+                g_clear_error (&load_error);
+                load_error = g_error_copy (error);
+                load_error_mtime = *(gint64 *) g_task_get_task_data (G_TASK (res));
+        }
+
+        tasks = pending_tasks;
+        pending_tasks = NULL;
+        for (l = tasks; l != NULL; l = l->next) {
+                if (default_providers != NULL)
+                        g_task_return_pointer (l->data, default_providers, NULL);
+                else
+                        g_task_return_error (l->data, g_error_copy (error));
+        }
+        g_slist_free_full (tasks, g_object_unref);
+        g_clear_error (&error);
+}
+
+/**
+ * net_mobile_providers_load_async:
+ *
+ * Loads the provider index if it isn't yet. A failed load is only
+ * retried once the database has changed.
+ **/
+void
+net_mobile_providers_load_async (GCancellable        *cancellable,
+                                 GAsyncReadyCallback  callback,
+                                 gpointer             user_data)
+{
+        GTask *task;
+        GTask *load_task;
+
+        task = g_task_new (NULL, cancellable, callback, user_data);
+        g_task_set_source_tag (task, net_mobile_providers_load_async);
+
+        if (default_providers != NULL) {
+                g_task_return_pointer (task, default_providers, NULL);
+                g_object_unref (task);
+                return;
+        }
+
+        if (load_error != NULL && get_database_mtime () == load_error_mtime) {
+                g_task_return_error (task, g_error_copy (load_error));
+                g_object_unref (task);
+                return;
+        }
+
+        /* one load serves everybody waiting for it */
+        if (pending_tasks == NULL) {
+                load_task = g_task_new (NULL, NULL, load_done_cb, NULL);
+                g_task_set_task_data (load_task, g_new0 (gint64, 1), g_free);
+                g_task_run_in_thread (load_task, load_thread);
+                g_object_unref (load_task);
+        }
+        pending_tasks = g_slist_prepend (pending_tasks, task);
+}
+
+NetMobileProviders *
+net_mobile_providers_load_finish (GAsyncResult  *result,
+                                  GError       **error)
+{
+        g_return_val_if_fail (g_task_is_valid (result, NULL), NULL);
+
+        return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/* the index if it was loaded, without loading it */
+NetMobileProviders *
+net_mobile_providers_peek (void)
+{
+        return default_providers;
+}
+
+static gchar *
+lookup_gsm (NetMobileProviders *providers, const gchar *mccmnc)
+{
+        gsize lo = 0;
+        gsize hi = g_variant_n_children (providers->gsm);
+
+        while (lo < hi) {
+                gsize mid = lo + (hi - lo) / 2;
+                g_autoptr(GVariant) child = g_variant_get_child_value (providers->gsm, mid);
+                const gchar *key, *name;
+                gint cmp;
+
+                g_variant_get (child, "(&s&s)", &key, &name);
+                cmp = strcmp (mccmnc, key);
+                if (cmp == 0)
+                        return g_strdup (name);
+                if (cmp < 0)
+                        hi = mid;
+                else
+                        lo = mid + 1;
+        }
+
+        return NULL;
+}
+
+static gchar *
+lookup_cdma (NetMobileProviders *providers, guint32 sid)
+{
+        gsize lo = 0;
+        gsize hi = g_variant_n_children (providers->cdma);
+
+        while (lo < hi) {
+                gsize mid = lo + (hi - lo) / 2;
+                g_autoptr(GVariant) child = g_variant_get_child_value (providers->cdma, mid);
+                const gchar *name;
+                guint32 key;
+
+                g_variant_get (child, "(u&s)", &key, &name);
+                if (sid == key)
+                        return g_strdup (name);
+                if (sid < key)
+                        hi = mid;
+                else
+                        lo = mid + 1;
+        }
+
+        return NULL;
+}
+
+static gchar *
+find_gsm_name (NetMobileProviders *providers, const gchar *mccmnc)
+{
+        g_autofree gchar *alternative = NULL;
+        gchar *name;
+        gsize len;
+
+        name = lookup_gsm (providers, mccmnc);
+        if (name != NULL)
+                return name;
+
+        /* modems and the database don't agree on whether MNCs have two
+         * or three digits, so try the other way too */
+        len = strlen (mccmnc);
+        if (len == 6 && mccmnc[3] == '0')
+                alternative = g_strdup_printf ("%.3s%s", mccmnc, mccmnc + 4);
+        else if (len == 5)
+                alternative = g_strdup_printf ("%.3s0%s", mccmnc, mccmnc + 3);
+        else
+                return NULL;
+
+        return lookup_gsm (providers, alternative);
+}
+
+gchar *
+net_mobile_providers_find_name (NetMobileProviders *providers,
+                                const gchar        *mccmnc,
+                                guint32             sid)
+{
+        GString *name = NULL;
+        gchar *found;
+
+        g_return_val_if_fail (providers != NULL, NULL);
+
+        if (mccmnc != NULL) {
+                found = find_gsm_name (providers, mccmnc);
+                if (found != NULL)
+                        name = g_string_new (found);
+                g_free (found);
+        }
+
+        if (sid != 0) {
+                found = lookup_cdma (providers, sid);
+                if (found != NULL) {
+                        if (name == NULL)
+                                name = g_string_new (found);
+                        else
+                                g_string_append_printf (name, ", %s", found);
+                }
+                g_free (found);
+        }
+
+        return (name != NULL ? g_string_free (name, FALSE) : NULL);
+}
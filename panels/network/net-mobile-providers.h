@@ -0,0 +1,48 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __NET_MOBILE_PROVIDERS_H
+#define __NET_MOBILE_PROVIDERS_H
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Operator names of the mobile broadband provider database, indexed by
+ * 3GPP MCC/MNC and by CDMA SID. The index is built once per process on a
+ * worker thread, shared by all mobile devices, and cached on disk until
+ * the database changes.
+ */
+typedef struct _NetMobileProviders NetMobileProviders;
+
+void                 net_mobile_providers_load_async    (GCancellable        *cancellable,
+                                                         GAsyncReadyCallback  callback,
+                                                         gpointer             user_data);
+NetMobileProviders  *net_mobile_providers_load_finish   (GAsyncResult        *result,
+                                                         GError             **error);
+NetMobileProviders  *net_mobile_providers_peek          (void);
+
+gchar               *net_mobile_providers_find_name     (NetMobileProviders  *providers,
+                                                         const gchar         *mccmnc,
+                                                         guint32              sid);
+
+G_END_DECLS
+
+#endif /* __NET_MOBILE_PROVIDERS_H */
@@ -36,6 +36,7 @@ struct _NetObjectPrivate
         GCancellable                    *cancellable;
         NMClient                        *client;
         CcNetworkPanel                  *panel;
+        GtkWidget                       *page;
 };
 
 enum {
@@ -108,6 +109,8 @@ void
 net_object_set_title (NetObject *object, const gchar *title)
 {
         g_return_if_fail (NET_IS_OBJECT (object));
+        if (g_strcmp0 (object->priv->title, title) == 0)
+                return;
         g_clear_pointer (&object->priv->title, g_free);
         object->priv->title = g_strdup (title);
         g_object_notify (G_OBJECT (object), "title");
@@ -149,12 +152,22 @@ net_object_add_to_notebook (NetObject *object,
                                         "NetObject::id",
                                         g_strdup (object->priv->id),
                                         g_free);
+                object->priv->page = widget;
+                g_object_add_weak_pointer (G_OBJECT (widget), (gpointer *) (&object->priv->page));
                 return widget;
         }
         g_debug ("no klass->add_to_notebook for %s", object->priv->id);
         return NULL;
 }
 
+/* the widget added by net_object_add_to_notebook(), if it was */
+GtkWidget *
+net_object_get_page (NetObject *object)
+{
+        g_return_val_if_fail (NET_IS_OBJECT (object), NULL);
+        return object->priv->page;
+}
+
 void
 net_object_delete (NetObject *object)
 {
@@ -276,6 +289,8 @@ net_object_finalize (GObject *object)
                 g_object_remove_weak_pointer (G_OBJECT (priv->client), (gpointer *) (&priv->client));
         if (priv->panel)
                 g_object_remove_weak_pointer (G_OBJECT (priv->panel), (gpointer *) (&priv->panel));
+        if (priv->page)
+                g_object_remove_weak_pointer (G_OBJECT (priv->page), (gpointer *) (&priv->page));
 
         G_OBJECT_CLASS (net_object_parent_class)->finalize (object);
 }
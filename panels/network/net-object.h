@@ -84,6 +84,7 @@ void             net_object_edit                        (NetObject      *object)
 GtkWidget       *net_object_add_to_notebook             (NetObject      *object,
                                                          GtkNotebook    *notebook,
                                                          GtkSizeGroup   *heading_size_group);
+GtkWidget       *net_object_get_page                    (NetObject      *object);
 gboolean         net_object_get_removable               (NetObject      *object);
 void             net_object_set_removable               (NetObject      *object,
                                                          gboolean        removable);
@@ -240,25 +240,6 @@ vpn_proxy_delete (NetObject *object)
                                            NULL, NULL, vpn);
 }
 
-static GtkWidget *
-vpn_proxy_add_to_notebook (NetObject *object,
-                           GtkNotebook *notebook,
-                           GtkSizeGroup *heading_size_group)
-{
-        GtkWidget *widget;
-        NetVpn *vpn = NET_VPN (object);
-
-        /* add widgets to size group */
-        widget = GTK_WIDGET (gtk_builder_get_object (vpn->priv->builder,
-                                                     "heading_group_password"));
-        gtk_size_group_add_widget (heading_size_group, widget);
-
-        widget = GTK_WIDGET (gtk_builder_get_object (vpn->priv->builder,
-                                                     "vbox9"));
-        gtk_notebook_append_page (notebook, widget, NULL);
-        return widget;
-}
-
 static void
 nm_device_refresh_vpn_ui (NetVpn *vpn)
 {
@@ -273,21 +254,13 @@ nm_device_refresh_vpn_ui (NetVpn *vpn)
         gchar *title;
         NMClient *client;
 
-        sw = GTK_WIDGET (gtk_builder_get_object (priv->builder,
-                                                 "device_off_switch"));
-        gtk_widget_set_visible (sw, TRUE);
-
         /* update title */
-        widget = GTK_WIDGET (gtk_builder_get_object (priv->builder,
-                                                     "label_device"));
         /* Translators: this is the title of the connection details
          * window for vpn connections, it is also used to display
          * vpn connections in the device list.
          */
         title = g_strdup_printf (_("%s VPN"), nm_connection_get_id (vpn->priv->connection));
         net_object_set_title (NET_OBJECT (vpn), title);
-        gtk_label_set_label (GTK_LABEL (widget), title);
-        g_free (title);
 
         if (priv->active_connection) {
                 g_signal_handlers_disconnect_by_func (vpn->priv->active_connection,
@@ -322,6 +295,21 @@ nm_device_refresh_vpn_ui (NetVpn *vpn)
                 }
         }
 
+        /* the rest is only for the page, which is built when first shown */
+        if (priv->builder == NULL) {
+                g_free (title);
+                return;
+        }
+
+        widget = GTK_WIDGET (gtk_builder_get_object (priv->builder,
+                                                     "label_device"));
+        gtk_label_set_label (GTK_LABEL (widget), title);
+        g_free (title);
+
+        sw = GTK_WIDGET (gtk_builder_get_object (priv->builder,
+                                                 "device_off_switch"));
+        gtk_widget_set_visible (sw, TRUE);
+
         widget = GTK_WIDGET (gtk_builder_get_object (priv->builder,
                                                      "label_status"));
         status = panel_vpn_state_to_localized_string (state);
@@ -449,6 +437,49 @@ vpn_proxy_edit (NetObject *object)
         net_connection_editor_run (editor);
 }
 
+static GtkWidget *
+vpn_proxy_add_to_notebook (NetObject *object,
+                           GtkNotebook *notebook,
+                           GtkSizeGroup *heading_size_group)
+{
+        GError *error = NULL;
+        GtkWidget *widget;
+        NetVpn *vpn = NET_VPN (object);
+
+        vpn->priv->builder = gtk_builder_new ();
+        gtk_builder_add_from_resource (vpn->priv->builder,
+                                       "/org/cinnamon/control-center/network/network-vpn.ui",
+                                       &error);
+        if (error != NULL) {
+                g_warning ("Could not load interface file: %s", error->message);
+                g_error_free (error);
+                g_clear_object (&vpn->priv->builder);
+                return NULL;
+        }
+
+        widget = GTK_WIDGET (gtk_builder_get_object (vpn->priv->builder,
+                                                     "device_off_switch"));
+        g_signal_connect (widget, "notify::active",
+                          G_CALLBACK (device_off_toggled), vpn);
+
+        widget = GTK_WIDGET (gtk_builder_get_object (vpn->priv->builder,
+                                                     "button_options"));
+        g_signal_connect (widget, "clicked",
+                          G_CALLBACK (edit_connection), vpn);
+
+        nm_device_refresh_vpn_ui (vpn);
+
+        /* add widgets to size group */
+        widget = GTK_WIDGET (gtk_builder_get_object (vpn->priv->builder,
+                                                     "heading_group_password"));
+        gtk_size_group_add_widget (heading_size_group, widget);
+
+        widget = GTK_WIDGET (gtk_builder_get_object (vpn->priv->builder,
+                                                     "vbox9"));
+        gtk_notebook_append_page (notebook, widget, NULL);
+        return widget;
+}
+
 /**
  * net_vpn_get_property:
  **/
@@ -573,28 +604,5 @@ net_vpn_class_init (NetVpnClass *klass)
 static void
 net_vpn_init (NetVpn *vpn)
 {
-        GError *error = NULL;
-        GtkWidget *widget;
-
         vpn->priv = NET_VPN_GET_PRIVATE (vpn);
-
-        vpn->priv->builder = gtk_builder_new ();
-        gtk_builder_add_from_resource (vpn->priv->builder,
-                                       "/org/cinnamon/control-center/network/network-vpn.ui",
-                                       &error);
-        if (error != NULL) {
-                g_warning ("Could not load interface file: %s", error->message);
-                g_error_free (error);
-                return;
-        }
-
-        widget = GTK_WIDGET (gtk_builder_get_object (vpn->priv->builder,
-                                                     "device_off_switch"));
-        g_signal_connect (widget, "notify::active",
-                          G_CALLBACK (device_off_toggled), vpn);
-
-        widget = GTK_WIDGET (gtk_builder_get_object (vpn->priv->builder,
-                                                     "button_options"));
-        g_signal_connect (widget, "clicked",
-                          G_CALLBACK (edit_connection), vpn);
 }
@@ -0,0 +1,108 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "net-wifi-ssid.h"
+
+static const guint8 *
+ssid_get_data (GBytes *ssid, gsize *len)
+{
+        const guint8 *data;
+
+        data = g_bytes_get_data (ssid, len);
+
+        /* some drivers report the SSID with a trailing NUL */
+        if (*len > 0 && data[*len - 1] == '\0')
+                (*len)--;
+
+        return data;
+}
+
+guint
+net_wifi_ssid_hash (gconstpointer ssid)
+{
+        const guint8 *data;
+        gsize len, i;
+        guint hash = 5381;
+
+        data = ssid_get_data ((GBytes *) ssid, &len);
+        for (i = 0; i < len; i++)
+                hash = (hash << 5) + hash + data[i];
+
+        return hash;
+}
+
+gboolean
+net_wifi_ssid_equal (gconstpointer ssid1, gconstpointer ssid2)
+{
+        const guint8 *data1, *data2;
+        gsize len1, len2;
+
+        data1 = ssid_get_data ((GBytes *) ssid1, &len1);
+        data2 = ssid_get_data ((GBytes *) ssid2, &len2);
+
+        return len1 == len2 && memcmp (data1, data2, len1) == 0;
+}
+
+/* Keeps the strongest item of each SSID, in the order the SSIDs were first
+ * seen. Items without an SSID (hidden networks) are dropped. The returned
+ * array doesn't hold references. */
+GPtrArray *
+net_wifi_get_strongest_unique (const GPtrArray     *items,
+                               NetWifiSsidFunc      get_ssid,
+                               NetWifiStrengthFunc  get_strength)
+{
+        GPtrArray *unique;
+        GHashTable *index;
+        gpointer position;
+        guint i;
+
+        unique = g_ptr_array_new ();
+        if (items == NULL)
+                return unique;
+
+        /* SSID -> position in unique */
+        index = g_hash_table_new (net_wifi_ssid_hash, net_wifi_ssid_equal);
+
+        for (i = 0; i < items->len; i++) {
+                gpointer item = g_ptr_array_index (items, i);
+                GBytes *ssid;
+
+                ssid = get_ssid (item);
+                if (!ssid)
+                        continue;
+
+                if (g_hash_table_lookup_extended (index, ssid, NULL, &position)) {
+                        gpointer *kept = &g_ptr_array_index (unique, GPOINTER_TO_UINT (position));
+
+                        if (get_strength (item) > get_strength (*kept))
+                                *kept = item;
+                } else {
+                        g_hash_table_insert (index, ssid, GUINT_TO_POINTER (unique->len));
+                        g_ptr_array_add (unique, item);
+                }
+        }
+
+        g_hash_table_destroy (index);
+
+        return unique;
+}
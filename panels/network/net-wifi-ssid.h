@@ -0,0 +1,42 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*-
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __NET_WIFI_SSID_H
+#define __NET_WIFI_SSID_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* SSIDs as GBytes, compared like nm_utils_same_ssid() with
+ * ignore_trailing_null set, so they can key a GHashTable. */
+guint            net_wifi_ssid_hash                            (gconstpointer ssid);
+gboolean         net_wifi_ssid_equal                           (gconstpointer ssid1,
+                                                                gconstpointer ssid2);
+
+typedef GBytes  *(*NetWifiSsidFunc)                             (gpointer item);
+typedef guint8   (*NetWifiStrengthFunc)                         (gpointer item);
+
+GPtrArray       *net_wifi_get_strongest_unique                 (const GPtrArray     *items,
+                                                                NetWifiSsidFunc      get_ssid,
+                                                                NetWifiStrengthFunc  get_strength);
+
+G_END_DECLS
+
+#endif /* __NET_WIFI_SSID_H */
@@ -22,6 +22,8 @@
 
 #include "config.h"
 
+#include <sys/socket.h>
+
 #include <glib.h>
 #include <glib/gi18n.h>
 #include <gtk/gtk.h>
@@ -505,7 +507,9 @@ panel_set_device_widget_details (GtkBuilder *builder,
                 /* there exists a value */
                 gtk_widget_show (heading);
                 gtk_widget_show (widget);
-                gtk_label_set_label (GTK_LABEL (widget), value);
+                /* unchanged values are common, skip the relayout */
+                if (g_strcmp0 (gtk_label_get_label (GTK_LABEL (widget)), value) != 0)
+                        gtk_label_set_label (GTK_LABEL (widget), value);
                 gtk_label_set_max_width_chars (GTK_LABEL (widget), 50);
                 gtk_label_set_ellipsize (GTK_LABEL (widget), PANGO_ELLIPSIZE_END);
         }
@@ -593,88 +597,79 @@ panel_get_ip6_address_as_string (NMIPConfig *ip6_config, const char *what)
         return str;
 }
 
-void
-panel_set_device_widgets (GtkBuilder *builder, NMDevice *device)
+static void
+panel_set_device_ip4_widgets (GtkBuilder *builder, NMIPConfig *ip4_config)
 {
-        NMIPConfig *ip4_config = NULL;
-        NMIPConfig *ip6_config = NULL;
-        gboolean has_ip4;
-        gboolean has_ip6;
-        gchar *ip4_dns = NULL;
-        gchar *ip6_dns = NULL;
         gchar *str_tmp;
 
-        /* get IPv4 parameters */
-        ip4_config = nm_device_get_ip4_config (device);
-        if (ip4_config != NULL) {
-
-                /* IPv4 address */
-                str_tmp = panel_get_ip4_address_as_string (ip4_config, "address");
-                panel_set_device_widget_details (builder,
-                                                 "ipv4",
-                                                 str_tmp);
-                has_ip4 = str_tmp != NULL;
-                g_free (str_tmp);
-
-                /* IPv4 DNS */
-                ip4_dns = panel_get_dns_as_string (ip4_config);
-                panel_set_device_widget_details (builder,
-                                                 "dns4",
-                                                 ip4_dns);
-
-                /* IPv4 route */
-                str_tmp = panel_get_ip4_address_as_string (ip4_config, "gateway");
-                panel_set_device_widget_details (builder,
-                                                 "route",
-                                                 str_tmp);
-                g_free (str_tmp);
-
-        } else {
-                /* IPv4 address */
-                panel_set_device_widget_details (builder,
-                                                 "ipv4",
-                                                 NULL);
-                has_ip4 = FALSE;
-
-                /* IPv4 DNS */
-                panel_set_device_widget_details (builder,
-                                                 "dns4",
-                                                 NULL);
-
-                /* IPv4 route */
-                panel_set_device_widget_details (builder,
-                                                 "route",
-                                                 NULL);
+        if (ip4_config == NULL) {
+                panel_set_device_widget_details (builder, "ipv4", NULL);
+                panel_set_device_widget_details (builder, "dns4", NULL);
+                panel_set_device_widget_details (builder, "route", NULL);
+                return;
         }
 
-        /* get IPv6 parameters */
-        ip6_config = nm_device_get_ip6_config (device);
-        if (ip6_config != NULL) {
-                str_tmp = panel_get_ip6_address_as_string (ip6_config, "address");
-                panel_set_device_widget_details (builder,
-                                                 "ipv6",
-                                                 str_tmp);
-                has_ip6 = str_tmp != NULL;
-                g_free (str_tmp);
-
-                /* IPv6 DNS */
-                ip6_dns = panel_get_dns_as_string (ip6_config);
-                panel_set_device_widget_details (builder,
-                                                 "dns6",
-                                                 ip6_dns);
+        /* IPv4 address */
+        str_tmp = panel_get_ip4_address_as_string (ip4_config, "address");
+        panel_set_device_widget_details (builder, "ipv4", str_tmp);
+        g_free (str_tmp);
 
-        } else {
-                panel_set_device_widget_details (builder,
-                                                 "ipv6",
-                                                 NULL);
-                has_ip6 = FALSE;
-
-                /* IPv6 DNS */
-                panel_set_device_widget_details (builder,
-                                                 "dns6",
-                                                 NULL);
+        /* IPv4 DNS */
+        str_tmp = panel_get_dns_as_string (ip4_config);
+        panel_set_device_widget_details (builder, "dns4", str_tmp);
+        g_free (str_tmp);
+
+        /* IPv4 route */
+        str_tmp = panel_get_ip4_address_as_string (ip4_config, "gateway");
+        panel_set_device_widget_details (builder, "route", str_tmp);
+        g_free (str_tmp);
+}
+
+static void
+panel_set_device_ip6_widgets (GtkBuilder *builder, NMIPConfig *ip6_config)
+{
+        gchar *str_tmp;
+
+        if (ip6_config == NULL) {
+                panel_set_device_widget_details (builder, "ipv6", NULL);
+                panel_set_device_widget_details (builder, "dns6", NULL);
+                return;
         }
 
+        /* IPv6 address */
+        str_tmp = panel_get_ip6_address_as_string (ip6_config, "address");
+        panel_set_device_widget_details (builder, "ipv6", str_tmp);
+        g_free (str_tmp);
+
+        /* IPv6 DNS */
+        str_tmp = panel_get_dns_as_string (ip6_config);
+        panel_set_device_widget_details (builder, "dns6", str_tmp);
+        g_free (str_tmp);
+}
+
+static gboolean
+panel_device_widget_is_shown (GtkBuilder *builder, const gchar *widget_suffix)
+{
+        gchar *label_id;
+        GObject *widget;
+
+        label_id = g_strdup_printf ("label_%s", widget_suffix);
+        widget = gtk_builder_get_object (builder, label_id);
+        g_free (label_id);
+
+        return widget != NULL && gtk_widget_get_visible (GTK_WIDGET (widget));
+}
+
+/* the headings depend on whether both families have a value, which the
+ * rows already tell without formatting the other family again */
+static void
+panel_set_device_ip_headers (GtkBuilder *builder)
+{
+        gboolean has_ip4, has_ip6;
+        gboolean has_dns4, has_dns6;
+
+        has_ip4 = panel_device_widget_is_shown (builder, "ipv4");
+        has_ip6 = panel_device_widget_is_shown (builder, "ipv6");
         if (has_ip4 && has_ip6) {
                 panel_set_device_widget_header (builder, "ipv4", _("IPv4 Address"));
                 panel_set_device_widget_header (builder, "ipv6", _("IPv6 Address"));
@@ -684,17 +679,40 @@ panel_set_device_widgets (GtkBuilder *builder, NMDevice *device)
                 panel_set_device_widget_header (builder, "ipv6", _("IP Address"));
         }
 
-        if (ip4_dns && ip6_dns) {
+        has_dns4 = panel_device_widget_is_shown (builder, "dns4");
+        has_dns6 = panel_device_widget_is_shown (builder, "dns6");
+        if (has_dns4 && has_dns6) {
                 panel_set_device_widget_header (builder, "dns4", _("DNS4"));
                 panel_set_device_widget_header (builder, "dns6", _("DNS6"));
-        } else if (ip4_dns) {
+        } else if (has_dns4) {
                 panel_set_device_widget_header (builder, "dns4", _("DNS"));
-        } else if (ip6_dns) {
+        } else if (has_dns6) {
                 panel_set_device_widget_header (builder, "dns6", _("DNS"));
         }
+}
+
+void
+panel_set_device_widgets (GtkBuilder *builder, NMDevice *device)
+{
+        panel_set_device_ip4_widgets (builder, nm_device_get_ip4_config (device));
+        panel_set_device_ip6_widgets (builder, nm_device_get_ip6_config (device));
+        panel_set_device_ip_headers (builder);
+}
 
-        g_free (ip4_dns);
-        g_free (ip6_dns);
+/**
+ * panel_set_device_ip_widgets:
+ *
+ * Like panel_set_device_widgets(), but only redoes the rows of one address
+ * family, for when just that NMIPConfig changed.
+ **/
+void
+panel_set_device_ip_widgets (GtkBuilder *builder, NMDevice *device, int addr_family)
+{
+        if (addr_family == AF_INET)
+                panel_set_device_ip4_widgets (builder, nm_device_get_ip4_config (device));
+        else
+                panel_set_device_ip6_widgets (builder, nm_device_get_ip6_config (device));
+        panel_set_device_ip_headers (builder);
 }
 
 void
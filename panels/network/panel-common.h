@@ -45,6 +45,9 @@ gboolean         panel_set_device_widget_header                (GtkBuilder *buil
                                                                 const gchar *value);
 void             panel_set_device_widgets                      (GtkBuilder *builder,
                                                                 NMDevice *device);
+void             panel_set_device_ip_widgets                   (GtkBuilder *builder,
+                                                                NMDevice *device,
+                                                                int addr_family);
 void             panel_unset_device_widgets                    (GtkBuilder *builder);
 gchar           *panel_get_ip4_address_as_string               (NMIPConfig *config, const gchar *what);
 gchar           *panel_get_dns_as_string                       (NMIPConfig *config);
@@ -22,14 +22,13 @@
 
 #include <string.h>
 #include "cc-wacom-output-manager.h"
-#include "muffin-display-config.h"
+#include "cc-display-state.h"
 
 typedef struct _CcWacomOutputManager CcWacomOutputManager;
 
 struct _CcWacomOutputManager {
     GObject parent_instance;
 
-    MetaDBusDisplayConfig      *proxy;
     GList          *monitors;
 };
 
@@ -72,186 +71,75 @@ monitor_info_spew (MonitorInfo *info)
                 info->x, info->y, info->primary, info->builtin);
 }
 
-#define MODE_BASE_FORMAT "siiddad"
-#define MODE_FORMAT "(" MODE_BASE_FORMAT "a{sv})"
-#define MODES_FORMAT "a" MODE_FORMAT
-#define MONITOR_SPEC_FORMAT "(ssss)"
-#define MONITOR_FORMAT "(" MONITOR_SPEC_FORMAT MODES_FORMAT "a{sv})"
-#define MONITORS_FORMAT "a" MONITOR_FORMAT
-
-#define LOGICAL_MONITOR_MONITORS_FORMAT "a" MONITOR_SPEC_FORMAT
-#define LOGICAL_MONITOR_FORMAT "(iidub" LOGICAL_MONITOR_MONITORS_FORMAT "a{sv})"
-#define LOGICAL_MONITORS_FORMAT "a" LOGICAL_MONITOR_FORMAT
-
 static void
-update_monitor_infos (CcWacomOutputManager  *manager,
-                      GVariant              *monitors,
-                      GVariant              *logical_monitors)
+update_monitor_infos (CcWacomOutputManager   *manager,
+                      CcDisplayStateSnapshot *snapshot)
 {
     GList *new_monitors = NULL;
-    GVariantIter m_iter;
-    g_variant_iter_init (&m_iter, monitors);
-    while (TRUE)
-    {
-        g_autoptr(GVariant) variant = NULL;
-
-        if (!g_variant_iter_next (&m_iter, "@"MONITOR_FORMAT, &variant))
-            break;
-
-        gchar *connector_name, *vendor, *product, *serial;
-        g_autoptr(GVariantIter) modes = NULL;
-        g_autoptr(GVariantIter) props = NULL;
-
-        g_variant_get (variant, MONITOR_FORMAT,
-                       &connector_name, &vendor, &product, &serial, &modes, &props);
+    guint i;
 
+    for (i = 0; i < cc_display_state_snapshot_get_n_monitors (snapshot); i++)
+    {
+        const CcDisplayStateMonitor *monitor = cc_display_state_snapshot_get_monitor (snapshot, i);
         MonitorInfo *info = g_slice_new0 (MonitorInfo);
 
-        info->connector_name = connector_name;
-        info->vendor = vendor;
-        info->product = product;
-        info->serial = serial;
+        info->connector_name = g_strdup (monitor->connector);
+        info->display_name = g_strdup (monitor->display_name);
+        info->vendor = g_strdup (monitor->vendor);
+        info->product = g_strdup (monitor->product);
+        info->serial = g_strdup (monitor->serial);
+        info->builtin = monitor->builtin;
 
-        while (TRUE)
+        // We're only looking for the origin x, y of the physical one.
+        if (monitor->logical_monitor >= 0)
         {
-            const char *s;
-            g_autoptr(GVariant) v = NULL;
+            const CcDisplayStateLogicalMonitor *logical_monitor;
 
-            if (!g_variant_iter_next (props, "{&sv}", &s, &v))
-              break;
-
-            if (g_str_equal (s, "display-name"))
-            {
-                g_variant_get (v, "s", &info->display_name);
-            }
-
-            if (g_str_equal (s, "is-builtin"))
-            {
-                g_variant_get (v, "b", &info->builtin);
-            }
-        }
-
-        GVariantIter l_iter;
-        g_variant_iter_init (&l_iter, logical_monitors);
-
-        while (TRUE)
-        {
-            g_autoptr(GVariant) variant = NULL;
-            g_autoptr(GVariantIter) monitor_specs = NULL;
-            const gchar *lconnector, *lvendor, *lproduct, *lserial;
-            gint x, y;
-            gboolean primary;
-            gboolean found_one = FALSE;
-
-            if (!g_variant_iter_next (&l_iter, "@"LOGICAL_MONITOR_FORMAT, &variant))
-              break;
-
-            g_variant_get (variant, LOGICAL_MONITOR_FORMAT,
-                           &x,
-                           &y,
-                           NULL,
-                           NULL,
-                           &primary,
-                           &monitor_specs,
-                           NULL);
-
-            while (g_variant_iter_next (monitor_specs, "(&s&s&s&s)", &lconnector, &lvendor, &lproduct, &lserial))
-            {
-                if (g_strcmp0 (info->connector_name, lconnector) == 0 &&
-                    g_strcmp0 (info->vendor, lvendor) == 0 &&
-                    g_strcmp0 (info->product, lproduct) == 0 &&
-                    g_strcmp0 (info->serial, lserial) == 0) {
-                  info->x = x;
-                  info->y = y;
-                  info->primary = primary;
-
-                  found_one = TRUE;
-                  break;
-                }
-            }
-
-            // Only check the first logical monitor - we're only looking for the origin x, y of the physical one.
-            if (found_one)
-                break;
+            logical_monitor = cc_display_state_snapshot_get_logical_monitor (snapshot, monitor->logical_monitor);
+            info->x = logical_monitor->x;
+            info->y = logical_monitor->y;
+            info->primary = logical_monitor->primary;
         }
 
-        new_monitors = g_list_append (new_monitors, info);
+        new_monitors = g_list_prepend (new_monitors, info);
     }
 
-    manager->monitors = new_monitors;
+    manager->monitors = g_list_reverse (new_monitors);
 }
 
 static void
 update_from_muffin (CcWacomOutputManager *manager)
 {
+    g_autoptr(CcDisplayStateSnapshot) snapshot = NULL;
 
     if (manager->monitors != NULL) {
         g_list_free_full (g_steal_pointer (&manager->monitors), (GDestroyNotify) monitor_info_free);
     }
 
-    if (g_dbus_proxy_get_name_owner (G_DBUS_PROXY (manager->proxy)) != NULL) {
-        GVariant *monitors, *logical_monitors, *properties;
-        guint serial;
-        GError *error = NULL;
-
-        if (meta_dbus_display_config_call_get_current_state_sync (manager->proxy,
-                                                                  &serial,
-                                                                  &monitors,
-                                                                  &logical_monitors,
-                                                                  &properties,
-                                                                  NULL,
-                                                                  &error)) {
-            update_monitor_infos (manager, monitors, logical_monitors);
-
-            g_variant_unref (monitors);
-            g_variant_unref (logical_monitors);
-            g_variant_unref (properties);
-        } else {
-            g_critical ("GetCurrentState failed (%d): %s\n", error->code, error->message);
-        }
+    snapshot = cc_display_state_get_snapshot (cc_display_state_get_default ());
+
+    if (snapshot != NULL) {
+        update_monitor_infos (manager, snapshot);
     } else {
-        g_critical ("Is Cinnamon running??");
+        g_debug ("No display state from Muffin (yet)");
     }
 
     g_signal_emit (manager, cc_wacom_output_manager_signals[MONITORS_CHANGED], 0);
 }
 
-static void
-muffin_state_changed (gpointer data)
-{
-    g_return_if_fail (CC_IS_WACOM_OUTPUT_MANAGER (data));
-
-    CcWacomOutputManager *manager = CC_WACOM_OUTPUT_MANAGER (data);
-    update_from_muffin (manager);
-}
-
 static void
 cc_wacom_output_manager_constructed (GObject *object)
 {
     G_OBJECT_CLASS (cc_wacom_output_manager_parent_class)->constructed (object);
 
     CcWacomOutputManager *manager = CC_WACOM_OUTPUT_MANAGER (object);
-    GError *error = NULL;
-
-    manager->proxy = meta_dbus_display_config_proxy_new_for_bus_sync (G_BUS_TYPE_SESSION,
-                                                                     G_DBUS_PROXY_FLAGS_NONE,
-                                                                     "org.cinnamon.Muffin.DisplayConfig",
-                                                                     "/org/cinnamon/Muffin/DisplayConfig",
-                                                                     NULL, &error);
-
-    if (manager->proxy == NULL) {
-        if (error != NULL) {
-            g_critical ("No connection to session bus: (%d) %s", error->code, error->message);
-            return;
-        }
-    }
 
-    g_signal_connect_object (manager->proxy, "notify::g-name-owner",
-                             G_CALLBACK (muffin_state_changed), manager, G_CONNECT_SWAPPED);
-    g_signal_connect_object (META_DBUS_DISPLAY_CONFIG (manager->proxy), "monitors-changed",
-                             G_CALLBACK (muffin_state_changed), manager, G_CONNECT_SWAPPED);
+    /* The state is fetched asynchronously and shared with the display
+     * panel, we pick it up whenever it changes. */
+    g_signal_connect_object (cc_display_state_get_default (), "changed",
+                             G_CALLBACK (update_from_muffin), manager, G_CONNECT_SWAPPED);
 
-    update_from_muffin (CC_WACOM_OUTPUT_MANAGER (object));
+    update_from_muffin (manager);
 }
 
 static void
@@ -313,5 +201,6 @@ cc_wacom_output_manager_refresh_monitors (CcWacomOutputManager *manager)
 {
     g_return_if_fail (CC_IS_WACOM_OUTPUT_MANAGER (manager));
 
-    update_from_muffin (manager);
+    /* monitors-changed is emitted once the new state is in */
+    cc_display_state_refresh (cc_display_state_get_default ());
 }